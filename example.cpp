@@ -1,5 +1,5 @@
 /// \file example.cpp
-/// ʾļʾһCGI
+/// 代码示例文件，演示一个简单CGI流程
 
 #include <iostream>
 #include "webapplib.h"
@@ -8,27 +8,27 @@ using namespace webapp;
 
 int main() {
 	/***************************************************************************
-	ʾCGIӦó,ģWEBѯ	
-	1ȡCGICookieݣStringCgiCookie
-	2ʹöȡĲȨ޼ӿڣConfigFileHttpClient
-	3ʹöȡĲѯݿ⣨MysqlClient
-	4ʹ־ļ¼ûFileSystemUtilityEncode
-	5ûCookieCookieDateTime
-	6ʾHTMLҳ棨Template
+	演示完整的CGI应用程序流程,模拟WEB查询动作	
+	1、读取CGI参数和Cookie数据（String、Cgi、Cookie）
+	2、使用读取到的参数调用权限检查接口（ConfigFile、HttpClient）
+	3、使用读取到的参数查询数据库（MysqlClient）
+	4、使用日志文件记录用户请求（FileSystem、Utility、Encode）
+	5、更新用户端Cookie（Cookie、DateTime）
+	6、显示HTML页面（Template）
 	***************************************************************************/	
 
 	////////////////////////////////////////////////////////////////////////////
-	// 1ȡCGICookieݣCgiCookie
+	// 1、读取CGI参数和Cookie数据（Cgi、Cookie）
 	
 	Cgi cgi;
 	Cookie cookie;
 	String username = cgi["username"];
 	String usercookie = cookie["usercookie"];
 	
-	/*ʾ webapp::CgiڶCGIʱڵģʽʾCGIֵ*/
+	/*提示 webapp::Cgi在读不到CGI环境变量时会运行在调试模式，提示输入CGI参数值*/
 	
 	////////////////////////////////////////////////////////////////////////////
-	// 2ʹöȡĲȨ޼ӿڣConfigFileHttpClient
+	// 2、使用读取到的参数调用权限检查接口（ConfigFile、HttpClient）
 	
 	ConfigFile conf( "example.conf" );
 	String check_interface = conf["check_interface"];
@@ -45,7 +45,7 @@ int main() {
 	}
 	
 	////////////////////////////////////////////////////////////////////////////
-	// 3ʹöȡĲѯݿ⣨MysqlClient
+	// 3、使用读取到的参数查询数据库（MysqlClient）
 	String value;
 	#ifndef _WEBAPPLIB_NOMYSQL
 
@@ -67,7 +67,7 @@ int main() {
 	#endif //_WEBAPPLIB_NOMYSQL
 
 	////////////////////////////////////////////////////////////////////////////
-	// 4ʹ־ļ¼ûFileSystemUtilityEncode
+	// 4、使用日志文件记录用户请求（FileSystem、Utility、Encode）
 	
 	String log_path = "/tmp/";
 	String log_file = log_path + "/logfile.txt";
@@ -84,20 +84,20 @@ int main() {
 	cout << file_content << endl;
 
 	////////////////////////////////////////////////////////////////////////////
-	// 5ûCookieCookieDateTime
+	// 5、更新用户端Cookie（Cookie、DateTime）
 	
 	DateTime now;
-	DateTime expires = now + ( TIME_ONE_DAY*3 ); // CookieЧΪ
+	DateTime expires = now + ( TIME_ONE_DAY*3 ); // Cookie有效期为三天
 	cookie.set_cookie( "username", username, expires.gmt_datetime() );
 	
 	////////////////////////////////////////////////////////////////////////////
-	// 6ʾHTMLҳ棨Template
+	// 6、显示HTML页面（Template）
 	
 	Template page("example.tmpl");
 	page.set( "username", username );
 	page.set( "value", value );
 	
-	// ʾѯ
+	// 显示查询结果
 	cout << "---------------------------------------------------------" << endl;
 	http_head();
 	page.print();
@@ -0,0 +1,722 @@
+/// \file tmplc.cpp
+/// webapp-tmplc 模板代码生成工具
+/// 将HTML模板转换为C++输出函数头文件,输出时不再读取及分析模板,
+/// 模板语法与 webapp::Template 相同,依赖于 waTemplate
+
+// 使用方法:
+// webapp-tmplc [-n 名称] [-o 输出文件] [-e 转义方式] 模板文件
+// 生成的头文件中定义:
+// - 名称_data 结构,模板域为 string 成员,循环为 vector<名称_data::循环名称_row> 成员
+// - 名称_render( ostream &output, const 名称_data &data ) 输出函数
+// 循环名称按 {{#FOR $xxx}} 中的 xxx 或 {{#FOR xxx}} 中的字符串确定,
+// {{#CACHE}} 块在生成代码中不缓存,{{#INCLUDE}} 包含模板在包含位置展开,
+// 使用输出转义时生成代码依赖于 waEncode
+
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include "waTemplate.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+/// 模板代码生成类
+/// 读取 Template 编译后的指令列表,生成等价的C++代码
+class TemplateCompiler {
+	public:
+
+	/// 构造函数
+	/// \param name 生成代码名称,用于结构及函数名称
+	TemplateCompiler( const string &name ):
+	_name(name), _escape(ESCAPE_NONE), _escaped(false), _date(false), _time(false), _error(false)
+	{}
+
+	/// 设置默认输出转义方式,同 Template::set_escape()
+	inline void set_escape( const escape_mode mode ) {
+		_escape = mode;
+	}
+
+	/// 读取模板文件
+	bool load( const string &tmpl_file );
+	/// 生成代码
+	bool generate( ostream &output );
+
+	////////////////////////////////////////////////////////////////////////////
+	private:
+
+	typedef map<string,set<string> > loopfields;	// 循环字段列表 <循环名称,字段名称列表>
+
+	/// 收集模板域及循环字段
+	void collect();
+	/// 收集当前模板指令中的模板域及循环字段,包含模板递归收集
+	void collect_codes();
+	/// 收集表达式中的模板域及循环字段
+	void collect_exp( const Template::tmpl_exp &exp );
+	/// 表达式对应的循环名称
+	string scope_name( const Template::tmpl_exp &exp );
+
+	/// 生成输出函数
+	void gen_render( ostream &output );
+	/// 生成当前模板指令代码,包含模板递归生成
+	void gen_codes( ostream &output, string &indent, string &text );
+	/// 生成表达式代码
+	string gen_exp( const Template::tmpl_exp &exp );
+	/// 指令的输出转义方式
+	escape_mode code_escape( const Template::tmpl_code &code ) const;
+	/// 生成条件表达式代码
+	string gen_cond( const Template::tmpl_cond &cond );
+	/// 生成静态文本代码
+	void gen_text( ostream &output, const char *text, const size_t len, const string &indent );
+
+	/// 转换为C++标识符
+	static string ident( const string &name );
+	/// 转换为C++字符串常量
+	static string quote( const string &str );
+
+	/// 纪录错误
+	void error( const int line, const string &msg );
+
+	Template _tmpl;						// 模板
+	const Template::tmpl_program *_program;	// 编译后的模板,生成包含模板代码时为包含模板
+	string _file;						// 模板文件名
+	string _name;						// 生成代码名称
+	escape_mode _escape;				// 默认输出转义方式
+	bool _escaped;						// 是否使用输出转义
+	set<string> _values;				// 模板域名称列表
+	loopfields _loops;					// 循环字段列表
+	set<string> _cursors;				// 使用光标位置的循环名称列表
+	vector<string> _curloops;			// 当前循环名称列表,内层在后
+	bool _date;							// 是否使用 %DATE
+	bool _time;							// 是否使用 %TIME
+	bool _error;						// 是否有不能生成的脚本
+};
+
+/// 读取模板文件
+/// \param tmpl_file 模板文件
+/// \retval true 读取成功
+/// \retval false 失败
+bool TemplateCompiler::load( const string &tmpl_file ) {
+	_file = tmpl_file;
+	if ( !_tmpl.load(tmpl_file) )
+		return false;
+	_program = _tmpl._program;
+
+	// syntax errors, same as Template::print()
+	for ( multimap<int,string>::const_iterator i=_program->errlog.begin(); i!=_program->errlog.end(); ++i )
+		cerr << _file << ":" << i->first+1 << ": " << i->second << endl;
+	return true;
+}
+
+/// 生成代码
+/// \param output 输出流
+/// \retval true 生成成功
+/// \retval false 模板中有不能生成代码的脚本
+bool TemplateCompiler::generate( ostream &output ) {
+	this->collect();
+	if ( _error )
+		return false;
+
+	string guard = "_WEBAPP_TMPLC_" + ident( _name ) + "_H_";
+	for ( size_t i=0; i<guard.length(); ++i )
+		guard[i] = toupper( guard[i] );
+
+	output << "/// \\file " << _name << ".h" << endl
+		<< "/// Generated by webapp-tmplc from " << _file << ", do not edit" << endl
+		<< endl
+		<< "#ifndef " << guard << endl
+		<< "#define " << guard << endl
+		<< endl
+		<< "#include <cstdio>" << endl
+		<< "#include <cstdlib>" << endl
+		<< "#include <cctype>" << endl
+		<< "#include <cstring>" << endl
+		<< "#include <ctime>" << endl
+		<< "#include <string>" << endl
+		<< "#include <vector>" << endl
+		<< "#include <ostream>" << endl
+		<< endl;
+
+	// runtime helpers, shared by all generated files
+	output << "#ifndef _WEBAPP_TMPLC_RUNTIME_" << endl
+		<< "#define _WEBAPP_TMPLC_RUNTIME_" << endl
+		<< "namespace webapp { namespace tmplc {" << endl
+		<< "inline void write( std::ostream &output, const std::string &value ) {" << endl
+		<< "\toutput.write( value.data(), value.size() );" << endl
+		<< "}" << endl
+		<< "inline std::string itos( const size_t value ) {" << endl
+		<< "\tchar buf[32];" << endl
+		<< "\treturn std::string( buf, snprintf(buf,sizeof(buf),\"%lu\",(unsigned long)value) );" << endl
+		<< "}" << endl
+		<< "inline bool isnum( const std::string &value ) {" << endl
+		<< "\tif ( value.empty() ) return false;" << endl
+		<< "\tfor ( size_t i=0; i<value.size(); ++i ) if ( !isdigit(value[i]) ) return false;" << endl
+		<< "\treturn true;" << endl
+		<< "}" << endl
+		<< "inline bool truth( const std::string &value ) {" << endl
+		<< "\treturn value!=\"\" && value!=\"0\";" << endl
+		<< "}" << endl
+		<< "inline int compare( const std::string &lexp, const std::string &rexp ) {" << endl
+		<< "\tif ( isnum(lexp) && isnum(rexp) ) {" << endl
+		<< "\t\tint lv = atoi( lexp.c_str() ), rv = atoi( rexp.c_str() );" << endl
+		<< "\t\treturn ( lv>rv ) ? 1 : ( lv==rv ) ? 0 : -1;" << endl
+		<< "\t}" << endl
+		<< "\treturn strcmp( lexp.c_str(), rexp.c_str() );" << endl
+		<< "}" << endl
+		<< "template<class T> inline const std::string& cell( const std::vector<T> &rows, const size_t cursor," << endl
+		<< "\tstd::string T::*field ) {" << endl
+		<< "\tstatic const std::string blank;" << endl
+		<< "\treturn ( cursor<rows.size() ) ? rows[cursor].*field : blank;" << endl
+		<< "}" << endl
+		<< "} } // namespace" << endl
+		<< "#endif //_WEBAPP_TMPLC_RUNTIME_" << endl
+		<< endl;
+
+	// escape helper, needs waEncode
+	if ( _escaped ) {
+		output << "#include \"waEncode.h\"" << endl
+			<< "#ifndef _WEBAPP_TMPLC_ESCAPE_" << endl
+			<< "#define _WEBAPP_TMPLC_ESCAPE_" << endl
+			<< "namespace webapp { namespace tmplc {" << endl
+			<< "inline void write( std::ostream &output, const std::string &value, const webapp::escape_mode mode ) {" << endl
+			<< "\twebapp::escape_write( output, value.data(), value.size(), mode );" << endl
+			<< "}" << endl
+			<< "} } // namespace" << endl
+			<< "#endif //_WEBAPP_TMPLC_ESCAPE_" << endl
+			<< endl;
+	}
+
+	// data struct
+	string data = ident( _name ) + "_data";
+	output << "/// " << _file << " data" << endl
+		<< "struct " << data << " {" << endl;
+	for ( set<string>::const_iterator i=_values.begin(); i!=_values.end(); ++i )
+		output << "\tstd::string " << ident( *i ) << ";" << endl;
+	for ( loopfields::const_iterator i=_loops.begin(); i!=_loops.end(); ++i ) {
+		string row = ident( i->first ) + "_row";
+		output << endl
+			<< "\tstruct " << row << " {" << endl;
+		for ( set<string>::const_iterator j=i->second.begin(); j!=i->second.end(); ++j )
+			output << "\t\tstd::string " << ident( *j ) << ";" << endl;
+		output << "\t};" << endl
+			<< "\tstd::vector<" << row << "> " << ident( i->first ) << ";" << endl;
+	}
+	output << "};" << endl
+		<< endl;
+
+	// render function
+	this->gen_render( output );
+
+	output << endl
+		<< "#endif //" << guard << endl;
+	return !_error;
+}
+
+/// 收集模板域及循环字段
+void TemplateCompiler::collect() {
+	_curloops.clear();
+	this->collect_codes();
+
+	// values and loops share the data struct
+	set<string> names;
+	for ( set<string>::const_iterator i=_values.begin(); i!=_values.end(); ++i ) {
+		if ( !names.insert(ident(*i)).second )
+			this->error( 0, "Error: Duplicate name \"" + *i + "\"" );
+	}
+	for ( loopfields::const_iterator i=_loops.begin(); i!=_loops.end(); ++i ) {
+		if ( !names.insert(ident(i->first)).second )
+			this->error( 0, "Error: Loop name \"" + i->first + "\" also used as value" );
+	}
+}
+
+/// 收集当前模板指令中的模板域及循环字段
+void TemplateCompiler::collect_codes() {
+	const vector<Template::tmpl_code> &codes = _program->codes;
+	for ( size_t pc=0; pc<codes.size(); ++pc ) {
+		const Template::tmpl_code &code = codes[pc];
+		switch ( code.type ) {
+			case TMPL_S_LOOP: {
+				string loop = this->scope_name( code.exp );
+				if ( loop == "" )
+					this->error( code.line, "Error: Unsupported loop name " + code.script );
+				_loops[loop];
+				_cursors.insert( loop );
+				_curloops.push_back( loop );
+				}
+				break;
+
+			case TMPL_S_ENDLOOP:
+				_curloops.pop_back();
+				break;
+
+			case TMPL_S_IF:
+			case TMPL_S_ELSIF: {
+				const Template::tmpl_cond &cond = _program->conds[code.cond];
+				for ( size_t i=0; i<cond.cmps.size(); ++i ) {
+					this->collect_exp( cond.cmps[i].lexp );
+					if ( cond.cmps[i].op != TMPL_C_NONE )
+						this->collect_exp( cond.cmps[i].rexp );
+				}
+				}
+				break;
+
+			case TMPL_S_VALUE:
+			case TMPL_S_LOOPVALUE:
+				if ( this->code_escape(code) != ESCAPE_NONE )
+					_escaped = true;
+				// fall through
+			case TMPL_S_CURSOR:
+			case TMPL_S_ROWS:
+			case TMPL_S_DATE:
+			case TMPL_S_TIME:
+				this->collect_exp( code.exp );
+				break;
+
+			case TMPL_S_INCLUDE: {
+				const Template::tmpl_program *program = _program;
+				_program = program->includes[code.include].program;
+				this->collect_codes();
+				_program = program;
+				}
+				break;
+		}
+	}
+}
+
+/// 收集表达式中的模板域及循环字段
+/// \param exp 已编译表达式
+void TemplateCompiler::collect_exp( const Template::tmpl_exp &exp ) {
+	switch ( exp.type ) {
+		case TMPL_S_VALUE:
+			_values.insert( exp.name );
+			break;
+
+		case TMPL_S_LOOPVALUE: {
+			string loop = this->scope_name( exp );
+			if ( loop != "" ) {
+				_loops[loop].insert( exp.name );
+				_cursors.insert( loop );
+			}
+			}
+			break;
+
+		case TMPL_S_CURSOR: {
+			string loop = this->scope_name( exp );
+			if ( loop != "" ) {
+				_loops[loop];
+				_cursors.insert( loop );
+			}
+			}
+			break;
+
+		case TMPL_S_ROWS: {
+			string loop = this->scope_name( exp );
+			if ( loop != "" )
+				_loops[loop];
+			}
+			break;
+
+		case TMPL_S_DATE:
+			_date = true;
+			break;
+
+		case TMPL_S_TIME:
+			_time = true;
+			break;
+	}
+}
+
+/// 表达式对应的循环名称
+/// \param exp 已编译表达式,循环语句表达式或循环变量表达式
+/// \return 循环名称,不在循环中返回空字符串
+string TemplateCompiler::scope_name( const Template::tmpl_exp &exp ) {
+	const Template::tmpl_exp *scope = &exp;
+	if ( exp.type != TMPL_S_VALUE && exp.type != TMPL_S_UNKNOWN ) {
+		// loop value, cursor or rows
+		if ( exp.scope < 0 )
+			return _curloops.empty() ? "" : _curloops.back();
+		scope = &_program->scopes[exp.scope];
+	}
+
+	// $xxx for waTemplate old version templet script, or loop name string
+	if ( scope->type==TMPL_S_VALUE || scope->type==TMPL_S_UNKNOWN )
+		return scope->name;
+	return "";
+}
+
+/// 生成输出函数
+/// \param output 输出流
+void TemplateCompiler::gen_render( ostream &output ) {
+	string data = ident( _name ) + "_data";
+
+	output << "/// render " << _file << endl
+		<< "/// \\param output output stream" << endl
+		<< "/// \\param data template data" << endl
+		<< "inline void " << ident( _name ) << "_render( std::ostream &output, const "
+		<< data << " &data ) {" << endl;
+
+	// loop cursors
+	for ( set<string>::const_iterator i=_cursors.begin(); i!=_cursors.end(); ++i )
+		output << "\tsize_t c_" << ident( *i ) << " = 0;" << endl;
+
+	// date and time
+	if ( _date || _time ) {
+		output << "\tstruct tm stm;" << endl
+			<< "\ttime_t tt = time( 0 );" << endl
+			<< "\tlocaltime_r( &tt, &stm );" << endl;
+		if ( _date ) {
+			output << "\tchar tmpl_date[32];" << endl
+				<< "\tsnprintf( tmpl_date, sizeof(tmpl_date), \"%d-%d-%d\", stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday );" << endl;
+		}
+		if ( _time ) {
+			output << "\tchar tmpl_time[32];" << endl
+				<< "\tsnprintf( tmpl_time, sizeof(tmpl_time), \"%d:%d:%d\", stm.tm_hour, stm.tm_min, stm.tm_sec );" << endl;
+		}
+	}
+
+	// instructions to structured code
+	string indent = "\t";
+	string text;	// static html not written yet
+	_curloops.clear();
+	this->gen_codes( output, indent, text );
+	if ( text != "" )
+		this->gen_text( output, text.data(), text.length(), indent );
+
+	output << "}" << endl;
+}
+
+/// 生成当前模板指令代码
+/// \param output 输出流
+/// \param indent 当前缩进
+/// \param text 尚未生成代码的静态文本,与包含模板的静态文本合并
+void TemplateCompiler::gen_codes( ostream &output, string &indent, string &text ) {
+	const vector<Template::tmpl_code> &codes = _program->codes;
+	const char *tmpl = _program->tmpl.data();
+	vector<bool> elses;	// #ELSE written in open #IF
+	for ( size_t pc=0; pc<codes.size(); ++pc ) {
+		const Template::tmpl_code &code = codes[pc];
+
+		// merge static html
+		if ( code.type == TMPL_S_TEXT ) {
+			text.append( tmpl+code.pos, code.len );
+			continue;
+		} else if ( code.type == TMPL_S_SPACE ) {
+			text += code.exp.name;
+			continue;
+		} else if ( code.type == TMPL_S_BLANK ) {
+			continue;
+		}
+		if ( text != "" ) {
+			this->gen_text( output, text.data(), text.length(), indent );
+			text.clear();
+		}
+
+		switch ( code.type ) {
+			case TMPL_S_IF:
+				output << indent << "if ( " << this->gen_cond(_program->conds[code.cond]) << " ) {" << endl;
+				indent += "\t";
+				elses.push_back( false );
+				break;
+
+			case TMPL_S_ELSIF:
+			case TMPL_S_ELSE:
+				indent.erase( indent.length()-1 );
+				if ( elses.back() )
+					// branch after #ELSE never runs
+					output << indent << "} if ( false ) {" << endl;
+				else if ( code.type == TMPL_S_ELSIF )
+					output << indent << "} else if ( " << this->gen_cond(_program->conds[code.cond]) << " ) {" << endl;
+				else
+					output << indent << "} else {" << endl;
+				if ( code.type == TMPL_S_ELSE )
+					elses.back() = true;
+				indent += "\t";
+				break;
+
+			case TMPL_S_ENDIF:
+				elses.pop_back();
+				// fall through
+			case TMPL_S_ENDCACHE:
+				indent.erase( indent.length()-1 );
+				output << indent << "}" << endl;
+				break;
+
+			case TMPL_S_CACHE:
+				output << indent << "{ // #CACHE " << quote( code.script ) << " not cached" << endl;
+				indent += "\t";
+				break;
+
+			case TMPL_S_LOOP: {
+				string loop = this->scope_name( code.exp );
+				string rows = "data." + ident( loop );
+				string cursor = "c_" + ident( loop );
+				// without TMPL_ENDLOOP, the loop runs once
+				string once = ( codes[code.jump].jump<0 ) ? " && "+cursor+"<1" : "";
+				output << indent << "for ( " << cursor << "=0; " << cursor << "<" << rows << ".size()"
+					<< once << "; ++" << cursor << " ) {" << endl;
+				indent += "\t";
+				_curloops.push_back( loop );
+				}
+				break;
+
+			case TMPL_S_ENDLOOP:
+				indent.erase( indent.length()-1 );
+				output << indent << "}" << endl;
+				_curloops.pop_back();
+				break;
+
+			case TMPL_S_INCLUDE: {
+				const Template::tmpl_program *program = _program;
+				_program = program->includes[code.include].program;
+				this->gen_codes( output, indent, text );
+				_program = program;
+				}
+				break;
+
+			default: {
+				const char *modes[] = { "", "webapp::ESCAPE_HTML", "webapp::ESCAPE_ATTR", 
+					"webapp::ESCAPE_URL", "webapp::ESCAPE_JS" };
+				escape_mode mode = this->code_escape( code );
+				output << indent << "webapp::tmplc::write( output, " << this->gen_exp(code.exp);
+				if ( mode != ESCAPE_NONE )
+					output << ", " << modes[mode];
+				output << " );" << endl;
+				}
+		}
+	}
+}
+
+/// 生成表达式代码
+/// \param exp 已编译表达式
+/// \return 类型为 std::string 的C++表达式
+string TemplateCompiler::gen_exp( const Template::tmpl_exp &exp ) {
+	string data = ident( _name ) + "_data";
+	switch ( exp.type ) {
+		case TMPL_S_VALUE:
+			return "data." + ident( exp.name );
+
+		case TMPL_S_LOOPVALUE: {
+			string loop = this->scope_name( exp );
+			if ( loop == "" )
+				return "std::string()";
+			return "webapp::tmplc::cell( data." + ident(loop) + ", c_" + ident(loop) + ", &"
+				+ data + "::" + ident(loop) + "_row::" + ident(exp.name) + " )";
+			}
+
+		case TMPL_S_CURSOR: {
+			string loop = this->scope_name( exp );
+			if ( loop == "" )
+				return "std::string( \"1\" )";
+			return "webapp::tmplc::itos( c_" + ident(loop) + "+1 )";
+			}
+
+		case TMPL_S_ROWS: {
+			string loop = this->scope_name( exp );
+			if ( loop == "" )
+				return "std::string( \"0\" )";
+			return "webapp::tmplc::itos( data." + ident(loop) + ".size() )";
+			}
+
+		case TMPL_S_DATE:
+			return "std::string( tmpl_date )";
+
+		case TMPL_S_TIME:
+			return "std::string( tmpl_time )";
+
+		case TMPL_S_BLANK:
+			return "std::string()";
+
+		default:
+			// string or space char
+			return "std::string( " + quote(exp.name) + " )";
+	}
+}
+
+/// 指令的输出转义方式
+/// \param code 模板指令
+/// \return 模板域及循环字段返回模板中指定或默认的转义方式,其它指令返回 ESCAPE_NONE
+escape_mode TemplateCompiler::code_escape( const Template::tmpl_code &code ) const {
+	if ( code.type!=TMPL_S_VALUE && code.type!=TMPL_S_LOOPVALUE )
+		return ESCAPE_NONE;
+	return ( code.escape>=0 ) ? static_cast<escape_mode>( code.escape ) : _escape;
+}
+
+/// 生成条件表达式代码
+/// \param cond 已编译条件表达式
+/// \return 类型为 bool 的C++表达式
+string TemplateCompiler::gen_cond( const Template::tmpl_cond &cond ) {
+	static const char *ops[] = { "==", "!=", "<=", "<", ">=", ">" };
+	string result;
+	for ( size_t i=0; i<cond.cmps.size(); ++i ) {
+		const Template::tmpl_cmp &cmp = cond.cmps[i];
+		if ( i > 0 )
+			result += ( cond.logic==TMPL_L_AND ) ? " && " : " || ";
+		if ( cmp.op == TMPL_C_NONE )
+			result += "webapp::tmplc::truth( " + this->gen_exp(cmp.lexp) + " )";
+		else
+			result += "webapp::tmplc::compare( " + this->gen_exp(cmp.lexp) + ", "
+				+ this->gen_exp(cmp.rexp) + " )" + ops[cmp.op] + "0";
+
+		// single expression without logic
+		if ( cond.logic == TMPL_L_NONE )
+			break;
+	}
+	return result;
+}
+
+/// 生成静态文本代码
+/// 按行分割为多个字符串常量
+/// \param output 输出流
+/// \param text 静态文本
+/// \param len 静态文本长度
+/// \param indent 缩进
+void TemplateCompiler::gen_text( ostream &output, const char *text, const size_t len,
+	const string &indent )
+{
+	output << indent << "output.write( ";
+	size_t begin = 0;
+	while ( begin < len ) {
+		const char *nl = static_cast<const char*>( memchr(text+begin,'\n',len-begin) );
+		size_t end = ( nl!=NULL ) ? nl-text+1 : len;
+		if ( begin > 0 )
+			output << endl << indent << "\t";
+		output << quote( string(text+begin,end-begin) );
+		begin = end;
+	}
+	output << ", " << len << " );" << endl;
+}
+
+/// 转换为C++标识符
+/// \param name 名称
+/// \return 非字母数字字符替换为下划线,以数字开始或为C++关键字时加下划线
+string TemplateCompiler::ident( const string &name ) {
+	static const char *keywords[] = { "auto", "bool", "break", "case", "catch", "char", "class",
+		"const", "continue", "default", "delete", "do", "double", "else", "enum", "explicit",
+		"extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long",
+		"mutable", "namespace", "new", "operator", "private", "protected", "public", "register",
+		"return", "short", "signed", "sizeof", "static", "struct", "switch", "template", "this",
+		"throw", "true", "try", "typedef", "typename", "union", "unsigned", "using", "virtual",
+		"void", "volatile", "while", NULL };
+
+	string result = name;
+	for ( size_t i=0; i<result.length(); ++i ) {
+		if ( !isalnum(result[i]) )
+			result[i] = '_';
+	}
+	if ( result=="" || isdigit(result[0]) )
+		result = "_" + result;
+	for ( int i=0; keywords[i]!=NULL; ++i ) {
+		if ( result == keywords[i] )
+			return result + "_";
+	}
+	return result;
+}
+
+/// 转换为C++字符串常量
+/// \param str 字符串
+/// \return 带引号的C++字符串常量
+string TemplateCompiler::quote( const string &str ) {
+	string result = "\"";
+	char buf[8];
+	for ( size_t i=0; i<str.length(); ++i ) {
+		unsigned char c = str[i];
+		switch ( c ) {
+			case '\\': result += "\\\\"; break;
+			case '"': result += "\\\""; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+			case '?': result += "\\?"; break;	// trigraphs
+			default:
+				if ( c<0x20 || c>=0x7f ) {
+					snprintf( buf, sizeof(buf), "\\%03o", c );
+					result += buf;
+				} else {
+					result += c;
+				}
+		}
+	}
+	return result + "\"";
+}
+
+/// 纪录错误
+/// \param line 模板行数
+/// \param msg 错误描述
+void TemplateCompiler::error( const int line, const string &msg ) {
+	cerr << _file << ":" << line+1 << ": " << msg << endl;
+	_error = true;
+}
+
+} // namespace
+
+using namespace webapp;
+
+/// 显示使用方法
+static void usage() {
+	cerr << "Usage: webapp-tmplc [-n name] [-o output] [-e escape] template" << endl
+		<< "  -n name    name of generated struct and function, default is template file name" << endl
+		<< "  -o output  output header file, default is stdout" << endl
+		<< "  -e escape  default escape mode: none, html, attr, url or js, default is none" << endl;
+}
+
+int main( int argc, char **argv ) {
+	string name, outfile, tmplfile;
+	int escape = ESCAPE_NONE;
+	for ( int i=1; i<argc; ++i ) {
+		if ( strcmp(argv[i],"-n")==0 && i+1<argc ) {
+			name = argv[++i];
+		} else if ( strcmp(argv[i],"-o")==0 && i+1<argc ) {
+			outfile = argv[++i];
+		} else if ( strcmp(argv[i],"-e")==0 && i+1<argc ) {
+			const char *modes[] = { "none", "html", "attr", "url", "js", NULL };
+			for ( escape=0; modes[escape]!=NULL && strcmp(modes[escape],argv[i+1])!=0; ++escape );
+			if ( modes[escape] == NULL ) {
+				usage();
+				return 1;
+			}
+			++i;
+		} else if ( argv[i][0]!='-' && tmplfile=="" ) {
+			tmplfile = argv[i];
+		} else {
+			usage();
+			return 1;
+		}
+	}
+	if ( tmplfile == "" ) {
+		usage();
+		return 1;
+	}
+
+	// default name: file name without path and extension
+	if ( name == "" ) {
+		name = tmplfile.substr( tmplfile.rfind('/')+1 );
+		name = name.substr( 0, name.find('.') );
+	}
+
+	TemplateCompiler compiler( name );
+	compiler.set_escape( static_cast<escape_mode>(escape) );
+	if ( !compiler.load(tmplfile) ) {
+		cerr << "webapp-tmplc: can not read " << tmplfile << endl;
+		return 1;
+	}
+
+	// generate to memory, write only if succeeded
+	ostringstream code;
+	if ( !compiler.generate(code) )
+		return 1;
+	if ( outfile == "" ) {
+		cout << code.str();
+	} else {
+		ofstream output( outfile.c_str(), ios::trunc|ios::out );
+		if ( !output || !(output << code.str()) ) {
+			cerr << "webapp-tmplc: can not write " << outfile << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -1,12 +1,16 @@
 /// \file waCgi.cpp
-/// Cgi,Cookieʵļ
+/// Cgi,Cookie类实现文件
 
 #include <cstdlib>
-#include <climits>
+#include <cstring>
+#include <cerrno>
 #include <iostream>
+#include <algorithm>
+#include <unistd.h>
 #include <vector>
 #include "waString.h"
 #include "waEncode.h"
+#include "waResponse.h"
 #include "waCgi.h"
 
 using namespace std;
@@ -16,23 +20,52 @@ namespace webapp {
 	
 ////////////////////////////////////////////////////////////////////////////////	
 
+// 当前请求状态,常驻进程模式下由 set_cgi_request() 设置
+static const CgiEnv *WEBAPP_REQUEST_ENV = NULL;
+static const string *WEBAPP_REQUEST_INPUT = NULL;
+
 /// \ingroup waCgi
 /// \fn void http_head()
-/// HTML Content-Type header,Զظ
+/// 输出HTML Content-Type header,自动避免重复输出,
+/// 回应头由 Response::current() 缓存,与回应内容一起输出,
+/// 输出至stdout且不压缩时立即输出回应头,与之后 printf() 等输出的内容保持顺序,
+/// 已调用 Response::set_compress() 时根据 HTTP_ACCEPT_ENCODING 选择压缩方式
 void http_head() {
-	static bool WEBAPP_ALREADY_HTTPHEAD = false;
-	if ( !WEBAPP_ALREADY_HTTPHEAD ) {
-		cout << "Content-Type: text/html\n" << endl;
-		WEBAPP_ALREADY_HTTPHEAD = true;
+	Response &response = Response::current();
+	if ( !response.head_ended() ) {
+		if ( !response.has_header("Content-Type") )
+			response.set_header( "Content-Type", "text/html" );
+		if ( !response.head_sent() && !response.has_header("Content-Encoding") )
+			response.accept_encoding( get_env("HTTP_ACCEPT_ENCODING") );
+		response.end_head();
 	}
 }
 
+/// \ingroup waCgi
+/// \fn void set_cgi_request( const CgiEnv *env, const string *input )
+/// 设置当前请求的环境变量及输入数据,用于FastCGI等常驻进程模式,
+/// 设置后 get_env(),Cgi,Cookie 从参数指定的数据读取请求
+/// \param env 请求环境变量列表,为NULL则读取进程环境变量
+/// \param input 请求输入数据,为NULL则读取stdin
+void set_cgi_request( const CgiEnv *env, const string *input ) {
+	WEBAPP_REQUEST_ENV = env;
+	WEBAPP_REQUEST_INPUT = input;
+}
+
 /// \ingroup waCgi
 /// \fn string get_env( const string &envname )
-/// ȡû
-/// \param envname 
-/// \return ɹػֵ,򷵻ؿַ
+/// 取得环境变量
+/// \param envname 环境变量名
+/// \return 成功返回环境变量值,否则返回空字符串
 string get_env( const string &envname ) {
+	if ( WEBAPP_REQUEST_ENV != NULL ) {
+		CgiEnv::const_iterator i = WEBAPP_REQUEST_ENV->find( envname );
+		if ( i != WEBAPP_REQUEST_ENV->end() )
+			return i->second;
+		else
+			return string( "" );
+	}
+
 	const char *env = envname.c_str();
 	char *val = getenv( env );
 	if ( val != NULL ) 
@@ -41,13 +74,355 @@ string get_env( const string &envname ) {
 		return string( "" );
 }
 
+////////////////////////////////////////////////////////////////////////////
+// multipart/form-data
+
+// 上传文件处理设置,由 set_upload_spool(),set_upload_handler() 设置
+static size_t WEBAPP_UPLOAD_SPOOL = 0;
+static string WEBAPP_UPLOAD_DIR = "/tmp";
+static upload_handler WEBAPP_UPLOAD_HANDLER = NULL;
+static void *WEBAPP_UPLOAD_ARG = NULL;
+
+/// \ingroup waCgi
+/// \fn void set_upload_spool( const size_t spool_size, const string &spool_dir )
+/// 设置上传文件临时保存方式,
+/// "multipart/form-data"方式上传的文件超过指定大小后不再保存在内存中,
+/// 而是写入临时文件(或交由 set_upload_handler() 指定的回调函数处理),
+/// 此时CGI参数"参数名称_file"为临时文件路径,"参数名称_size"为文件大小,
+/// 临时文件在Cgi对象析构时删除,需要保留时应在此之前移走
+/// \param spool_size 上传文件大小超过该值后写入临时文件,单位为byte,为0则全部保存在内存中
+/// \param spool_dir 临时文件目录,默认为"/tmp"
+void set_upload_spool( const size_t spool_size, const string &spool_dir ) {
+	WEBAPP_UPLOAD_SPOOL = spool_size;
+	WEBAPP_UPLOAD_DIR = spool_dir;
+}
+
+/// \ingroup waCgi
+/// \fn void set_upload_handler( upload_handler handler, void *arg )
+/// 设置上传文件处理回调函数,
+/// 上传文件超过 set_upload_spool() 指定大小后文件内容分块交由回调函数处理,不写入临时文件,
+/// 文件结束时以 data 为NULL,len 为0调用一次回调函数
+/// \param handler 回调函数,为NULL则写入临时文件
+/// \param arg 传递给回调函数的参数
+void set_upload_handler( upload_handler handler, void *arg ) {
+	WEBAPP_UPLOAD_HANDLER = handler;
+	WEBAPP_UPLOAD_ARG = arg;
+}
+
+// multipart/form-data 增量分析类
+// 逐块输入数据,按边界分隔各部分,
+// 普通参数及小文件保存在内存,大文件写入临时文件或交由回调函数处理
+class FormDataParser {
+	public:
+	
+	FormDataParser( const string &boundary ):
+	_state(START), _isfile(false), _size(0), _fd(-1), _handler(false), _skip(false) {
+		_delim = "\r\n--" + boundary;
+	}
+	
+	~FormDataParser() {
+		this->abort_spool();
+	}
+	
+	// 输入数据
+	void feed( const char *data, const size_t len ) {
+		if ( _buf.empty() ) {
+			// parse input directly, keep the rest
+			size_t used = this->process( data, len );
+			_buf.assign( data+used, len-used );
+		} else {
+			_buf.append( data, len );
+			size_t used = this->process( _buf.data(), _buf.length() );
+			_buf.erase( 0, used );
+		}
+	}
+	
+	// 输入结束,丢弃不完整的部分
+	void finish() {
+		if ( _state == BODY )
+			this->abort_spool();
+		_state = EPILOGUE;
+	}
+	
+	vector< pair<string,string> > fields;	// 参数列表
+	vector<string> spools;					// 临时文件列表
+	
+	private:
+	
+	enum parse_state {
+		START,		// 数据开始
+		PREAMBLE,	// 第一个边界之前
+		BOUNDARY,	// 边界之后
+		HEADERS,	// 部分头信息
+		BODY,		// 部分内容
+		EPILOGUE	// 结束边界之后
+	};
+	
+	// 分析数据
+	// 返回已处理的数据长度,未处理部分等待更多数据
+	size_t process( const char *data, const size_t len ) {
+		size_t pos = 0;
+		while ( pos < len ) {
+			const char *p = data + pos;
+			size_t rest = len - pos;
+			
+			switch ( _state ) {
+				case START:
+					// body starts with "--boundary" usually
+					if ( rest < _delim.length()-2 )
+						return pos;
+					if ( memcmp(p,_delim.data()+2,_delim.length()-2) == 0 ) {
+						pos += _delim.length() - 2;
+						_state = BOUNDARY;
+					} else {
+						_state = PREAMBLE;
+					}
+					break;
+					
+				case PREAMBLE:
+				case BODY: {
+					// search boundary
+					const char *found = search( p, rest, _delim.data(), _delim.length() );
+					if ( found == NULL ) {
+						// keep possible partial boundary
+						size_t keep = min( rest, _delim.length()-1 );
+						if ( _state == BODY )
+							this->part_data( p, rest-keep );
+						return pos + rest - keep;
+					}
+					if ( _state == BODY ) {
+						this->part_data( p, found-p );
+						this->part_end();
+					}
+					pos += ( found-p ) + _delim.length();
+					_state = BOUNDARY;
+					break;
+				}
+					
+				case BOUNDARY:
+					// "--" for end, <CR> for next part
+					if ( rest < 2 )
+						return pos;
+					if ( p[0]=='-' && p[1]=='-' ) {
+						_state = EPILOGUE;
+						return len;
+					}
+					if ( p[0]=='\r' && p[1]=='\n' ) {
+						pos += 2;
+						_state = HEADERS;
+					} else {
+						// transport padding
+						++pos;
+					}
+					break;
+					
+				case HEADERS: {
+					// headers end with <CR><CR>
+					const char *found = search( p, rest, "\r\n\r\n", 4 );
+					if ( found == NULL ) {
+						if ( rest > MAX_HEADERS ) {
+							// broken headers, skip part
+							this->part_begin( string(p,MAX_HEADERS) );
+							_skip = true;
+							_state = BODY;
+							break;
+						}
+						return pos;
+					}
+					this->part_begin( string(p,found-p+2) );
+					pos += ( found-p ) + 4;
+					_state = BODY;
+					break;
+				}
+					
+				case EPILOGUE:
+					return len;
+			}
+		}
+		return pos;
+	}
+	
+	// 查找子串
+	static const char* search( const char *s, const size_t len, 
+		const char *sub, const size_t sublen ) 
+	{
+		if ( len < sublen )
+			return NULL;
+		const char *last = s + len - sublen;
+		for ( const char *p=s; p<=last; ++p ) {
+			p = (const char*)memchr( p, sub[0], last-p+1 );
+			if ( p == NULL )
+				return NULL;
+			if ( memcmp(p,sub,sublen) == 0 )
+				return p;
+		}
+		return NULL;
+	}
+	
+	// 读取头信息中的参数值
+	static string header_param( const string &headers, const string &param ) {
+		size_t pos, end;
+		string tag = "; " + param + "=\"";
+		if ( (pos=headers.find(tag)) == headers.npos )
+			return "";
+		pos += tag.length();
+		if ( (end=headers.find("\"",pos)) == headers.npos )
+			return "";
+		return headers.substr( pos, end-pos );
+	}
+	
+	// 部分开始
+	void part_begin( const string &headers ) {
+		_name = header_param( headers, "name" );
+		_isfile = ( headers.find("; filename=\"") != headers.npos );
+		_filename = header_param( headers, "filename" );
+		_type = "";
+		_value = "";
+		_size = 0;
+		_skip = ( _name == "" );
+		
+		size_t pos, end;
+		if ( (pos=headers.find("Content-Type: ")) != headers.npos 
+			&& (end=headers.find("\r\n",pos)) != headers.npos )
+			_type = headers.substr( pos+14, end-pos-14 ); // 14: strlen("Content-Type: ")
+	}
+	
+	// 部分内容
+	void part_data( const char *data, const size_t len ) {
+		if ( _skip || len == 0 )
+			return;
+		_size += len;
+		
+		if ( _fd>=0 || _handler ) {
+			this->spool( data, len );
+			return;
+		}
+		
+		_value.append( data, len );
+		if ( _isfile && WEBAPP_UPLOAD_SPOOL>0 && _value.length()>WEBAPP_UPLOAD_SPOOL ) {
+			// too large, spool to file or handler
+			if ( WEBAPP_UPLOAD_HANDLER != NULL ) {
+				_handler = true;
+			} else {
+				string path = WEBAPP_UPLOAD_DIR + "/webapp_upload_XXXXXX";
+				vector<char> tmpl( path.begin(), path.end() );
+				tmpl.push_back( '\0' );
+				if ( (_fd=mkstemp(&tmpl[0])) < 0 ) {
+					_skip = true;
+					_value = "";
+					return;
+				}
+				_spool = &tmpl[0];
+			}
+			this->spool( _value.data(), _value.length() );
+			_value = "";
+		}
+	}
+	
+	// 输出到临时文件或回调函数
+	void spool( const char *data, const size_t len ) {
+		if ( _handler ) {
+			if ( !WEBAPP_UPLOAD_HANDLER(_name,_filename,data,len,WEBAPP_UPLOAD_ARG) )
+				_skip = true;
+			return;
+		}
+		
+		size_t written = 0;
+		while ( written < len ) {
+			ssize_t n = write( _fd, data+written, len-written );
+			if ( n < 0 && errno == EINTR )
+				continue;
+			if ( n <= 0 ) {
+				this->abort_spool();
+				_skip = true;
+				return;
+			}
+			written += n;
+		}
+	}
+	
+	// 放弃临时文件
+	void abort_spool() {
+		if ( _fd >= 0 ) {
+			close( _fd );
+			unlink( _spool.c_str() );
+			_fd = -1;
+		}
+		_handler = false;
+	}
+	
+	// 部分结束
+	void part_end() {
+		if ( _name == "" )
+			return;
+		
+		if ( !_isfile ) {
+			// 参数名称 = 参数值
+			if ( _value != "" )
+				fields.push_back( make_pair(_name,_value) );
+			return;
+		}
+		
+		// 文件型参数
+		/******************************************************
+		参数名称 = 文件内容
+		参数名称_name = 文件名称
+		参数名称_type = {Content-Type}
+		若写入临时文件或交由回调函数处理:
+		参数名称_file = 临时文件路径
+		参数名称_size = 文件大小
+		******************************************************/
+		if ( _filename != "" )
+			fields.push_back( make_pair(_name+"_name",_filename) );
+		if ( _type != "" )
+			fields.push_back( make_pair(_name+"_type",_type) );
+		
+		if ( _fd >= 0 ) {
+			close( _fd );
+			_fd = -1;
+			spools.push_back( _spool );
+			fields.push_back( make_pair(_name+"_file",_spool) );
+			fields.push_back( make_pair(_name+"_size",itos(_size)) );
+		} else if ( _handler ) {
+			if ( !_skip )
+				WEBAPP_UPLOAD_HANDLER( _name, _filename, NULL, 0, WEBAPP_UPLOAD_ARG );
+			_handler = false;
+			fields.push_back( make_pair(_name+"_size",itos(_size)) );
+		} else if ( _value != "" ) {
+			fields.push_back( make_pair(_name,_value) );
+		}
+	}
+	
+	static const size_t MAX_HEADERS = 8192;
+
+	string _delim;		// 边界
+	string _buf;		// 未处理数据
+	parse_state _state;	// 分析状态
+	
+	// 当前部分
+	string _name;		// 参数名称
+	string _filename;	// 文件名称
+	string _type;		// 文件类型
+	string _value;		// 内存中的内容
+	bool _isfile;		// 是否为文件型参数
+	size_t _size;		// 内容长度
+	int _fd;			// 临时文件
+	string _spool;		// 临时文件路径
+	bool _handler;		// 是否交由回调函数处理
+	bool _skip;			// 是否忽略内容
+};
+
 ////////////////////////////////////////////////////////////////////////////
 // CGI
 
-/// 캯
-/// ȡCGI
-/// \param formdata_maxsize "multipart/form-data"ʽPOSTʱFORMϴݴС,
-/// ֱضϲ,λΪbyte,ĬΪ0ݴС
+/// 构造函数
+/// 读取并分析CGI内容,
+/// POST数据按CONTENT_LENGTH预分配后直接从stdin批量读取,
+/// 常驻进程模式下直接分析 set_cgi_request() 指定的请求输入数据,
+/// "multipart/form-data"方式POST时边读取边分析,上传文件超过 set_upload_spool()
+/// 指定大小后保存至临时文件或交由 set_upload_handler() 指定的回调函数处理
+/// \param formdata_maxsize 参数是"multipart/form-data"方式POST时的最大FORM上传数据大小,
+/// 超过部分被截断不处理,单位为byte,默认为0即不限制数据大小
 Cgi::Cgi( const size_t formdata_maxsize ) {
 	// get envionment variable REQUEST_METHOD
 	_method = get_env( "REQUEST_METHOD" );
@@ -55,88 +430,125 @@ Cgi::Cgi( const size_t formdata_maxsize ) {
 	
 	// set trunc flag
 	_trunc = false;
+	_input = NULL;
 	
 	// method = GET
 	if ( _method == "GET" ) {
 		// read and parse QUERY_STRING
-		this->parse_urlencoded( get_env("QUERY_STRING") );
+		_query = get_env( "QUERY_STRING" );
+		this->parse_urlencoded( NULL );
 	}
 	
 	// method = POST
 	else if ( _method == "POST" ) {
 		// get envionment variable CONTENT_TYPE
 		string content_type = get_env( "CONTENT_TYPE" );
+		bool urlencoded = ( content_type.find("application/x-www-form-urlencoded") != content_type.npos );
+		bool multipart = ( content_type.find("multipart/form-data") != content_type.npos );
+		if ( !urlencoded && !multipart )
+			return;
+
+		if ( multipart ) {
+			// parse multipart input incrementally
+			_trunc = this->parse_multipart( content_type, WEBAPP_REQUEST_INPUT, formdata_maxsize );
+		} else if ( WEBAPP_REQUEST_INPUT != NULL ) {
+			// parse request input, no copy
+			this->parse_urlencoded( WEBAPP_REQUEST_INPUT );
+		} else {
+			// read and parse stdin
+			this->read_stdin( _query, 0 );
+			this->parse_urlencoded( NULL );
+		}
+	}
+}
+
+/// 析构函数
+/// 删除未被移走的上传临时文件
+Cgi::~Cgi() {
+	for ( size_t i=0; i<_spools.size(); ++i )
+		unlink( _spools[i].c_str() );
+}
+
+/// 读取stdin输入数据
+/// 若设置了CONTENT_LENGTH则预分配缓冲区并读取指定长度,否则读取至EOF
+/// \param buf 读取结果
+/// \param maxsize 最大读取长度,为0不限制
+/// \retval true 数据超过最大读取长度被截断
+/// \retval false 未截断
+bool Cgi::read_stdin( string &buf, const size_t maxsize ) {
+	const size_t CHUNK_SIZE = 65536;
+	long content_length = atol( get_env("CONTENT_LENGTH").c_str() );
+	bool trunc = false;
+	size_t readed = 0;
+	
+	if ( content_length > 0 ) {
+		// read CONTENT_LENGTH bytes
+		size_t total = content_length;
+		if ( maxsize>0 && total>maxsize ) {
+			total = maxsize;
+			trunc = true;
+		}
 		
-		char c;
-		string buf;
-		if ( formdata_maxsize > 0 )
-			buf.reserve( formdata_maxsize );
-		else
-			buf.reserve( 256 );
-		
-		if ( content_type.find("application/x-www-form-urlencoded") != content_type.npos ) {
-			// read stdin
-			int content_length = atoi( (get_env("CONTENT_LENGTH")).c_str() );
-			for ( int i=0; i<content_length; ++i ) {
-				cin >> c;
-				buf += c;
-			}
-			
-			// parse stdin
-			this->parse_urlencoded( buf );
-			
-		} else if ( content_type.find("multipart/form-data") != content_type.npos ) {
-			// read stdin
-			cin.unsetf( ios::skipws );
-
-			if ( formdata_maxsize > 0 ) {
-				// max size set
-				size_t size = 0;
-				
-				while ( cin ) {
-					cin >> c;
-					buf += c;
-					++size;
-					
-					if ( size > formdata_maxsize ) {
-						cin.ignore( LONG_MAX );
-						_trunc = true;
-						break;
-					}
-				}
-			} else {
-				// no size limit
-				while ( cin ) {
-					cin >> c;
-					buf += c;
+		buf.resize( total );
+		while ( readed < total ) {
+			ssize_t n = read( 0, &buf[readed], total-readed );
+			if ( n < 0 && errno == EINTR )
+				continue;
+			if ( n <= 0 )
+				break;
+			readed += n;
+		}
+	} else {
+		// read until EOF
+		while ( true ) {
+			size_t want = CHUNK_SIZE;
+			if ( maxsize > 0 ) {
+				if ( readed >= maxsize ) {
+					// more data than maxsize
+					char c;
+					if ( read(0,&c,1) > 0 )
+						trunc = true;
+					break;
 				}
+				want = min( want, maxsize-readed );
 			}
-			
-			// parse stdin
-			this->parse_multipart( content_type, buf );
+
+			buf.resize( readed+want );
+			ssize_t n = read( 0, &buf[readed], want );
+			if ( n < 0 && errno == EINTR )
+				n = 0;
+			else if ( n <= 0 )
+				break;
+			readed += n;
 		}
 	}
+
+	buf.resize( readed );
+	return trunc;
 }
 
-/// ȡCGI
-/// \param name CGI,Сд
-/// \return ɹCGIֵ,򷵻ؿַ,ͬCGIֵָ֮Ϊǿո' '
+/// 取得CGI参数
+/// \param name CGI参数名,大小写敏感
+/// \return 成功返回CGI参数值,否则返回空字符串,多个同名CGI参数值之间分隔符为半角空格' '
 string Cgi::get_cgi( const string &name ) {
 	if ( name == "" ) 
 		return string( "" );
 	
 	if ( _method=="GET" || _method=="POST" ) {
-		if ( _cgi.find(name) != _cgi.end() )
-			return _cgi[name];
+		size_t length;
+		const char *value = this->get_cgi( name, length );
+		if ( value != NULL )
+			return string( value, length );
 		else 
 			return string( "" );
 	}
 	
 	else if ( _method != "OPTIONS" && _method != "HEAD" && _method != "PUT" &&
 			  _method != "DELETE" && _method != "TRACE" ) {
-		// ն˲ģʽû cgi 
+		// 终端测试模式，用户输入 cgi 参数
 		string cgival;
 		cout << "Input value of CGI parameter \"" << name << "\", type _SPACE_ if no value: ";
+		Response::current().flush();
 		cin >> cgival;
 		if ( cgival != "_SPACE_" )
 			return cgival;
@@ -148,193 +560,364 @@ string Cgi::get_cgi( const string &name ) {
 		return string( "" );
 }
 
-/// CGI
-/// \param name CGI,Сд
-/// \param value CGIֵ
+/// 取得CGI参数,不复制参数值
+/// 参数值无需解码时直接指向原始请求数据,否则指向解码缓存,
+/// 在Cgi对象析构(常驻进程模式下为当前请求结束)前有效
+/// \param name CGI参数名,大小写敏感
+/// \param length 参数值长度
+/// \return 成功返回CGI参数值指针(不以'\0'结尾),否则返回NULL,
+/// 多个同名CGI参数值之间分隔符为半角空格' '
+const char* Cgi::get_cgi( const string &name, size_t &length ) const {
+	length = 0;
+	int idx = this->find_param( name );
+	if ( idx < 0 )
+		return NULL;
+	
+	// single value without encoding, no copy
+	const cgi_meta &meta = _metas[idx];
+	if ( meta.first>=0 && _raws[meta.first].next<0 && _params[idx].values.empty() ) {
+		const cgi_value &raw = _raws[meta.first];
+		const char *value = this->query().data() + raw.pos;
+		if ( memchr(value,'%',raw.len)==NULL && memchr(value,'+',raw.len)==NULL ) {
+			length = raw.len;
+			return value;
+		}
+	}
+	
+	const string &value = this->join_param( idx );
+	length = value.length();
+	return value.data();
+}
+
+/// 取得CGI参数的全部参数值
+/// \param name CGI参数名,大小写敏感
+/// \return 按出现顺序排列的参数值列表,参数不存在返回空列表
+const vector<string>& Cgi::get_values( const string &name ) const {
+	static const vector<string> empty;
+	int idx = this->find_param( name );
+	if ( idx < 0 )
+		return empty;
+	
+	this->decode_param( idx );
+	return _params[idx].values;
+}
+
+/// 返回CGI参数列表
+/// 解码全部参数,返回内部列表的引用,不复制
+/// \return 按参数名称首次出现顺序排列的参数列表
+const CgiParams& Cgi::params() const {
+	for ( size_t i=0; i<_params.size(); ++i )
+		this->decode_param( i );
+	return _params;
+}
+
+/// 返回参数值列表
+/// \return 返回值类型为CgiList,即map<string,string>,
+/// 多个同名CGI参数值之间分隔符为半角空格' '
+CgiList Cgi::dump() const {
+	CgiList list;
+	for ( size_t i=0; i<_params.size(); ++i )
+		list[_params[i].name] = this->join_param( i );
+	return list;
+}
+
+/// 保存CGI参数
+/// \param name CGI参数名,大小写敏感
+/// \param value CGI参数值
 void Cgi::add_cgi( const string &name, const string &value ) {
-	if ( _cgi[name] == "" )
-		_cgi[name] = value;
-	else
-		_cgi[name] += ( " " + value );
+	int idx = this->insert_param( name );
+	_params[idx].values.push_back( value );
+	_metas[idx].joined = false;
+}
+
+/// 参数名称散列值,FNV-1a算法
+/// \param name 参数名称
+/// \param length 参数名称长度
+/// \return 散列值
+static size_t cgi_name_hash( const char *name, const size_t length ) {
+	size_t hash = 2166136261U;
+	for ( size_t i=0; i<length; ++i ) {
+		hash ^= static_cast<unsigned char>( name[i] );
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/// 查找参数位置
+/// \param name 参数名称
+/// \return 参数在参数列表中的位置,不存在返回-1
+int Cgi::find_param( const string &name ) const {
+	if ( _slots.empty() )
+		return -1;
+	
+	size_t hash = cgi_name_hash( name.data(), name.length() );
+	size_t mask = _slots.size() - 1;
+	for ( size_t i=hash&mask; ; i=(i+1)&mask ) {
+		int idx = _slots[i];
+		if ( idx < 0 )
+			return -1;
+		if ( _metas[idx].hash==hash && _params[idx].name==name )
+			return idx;
+	}
+}
+
+/// 增加参数
+/// \param name 参数名称
+/// \return 参数在参数列表中的位置,参数已存在则返回原位置
+int Cgi::insert_param( const string &name ) {
+	int idx = this->find_param( name );
+	if ( idx >= 0 )
+		return idx;
+	
+	// keep load factor <= 1/2
+	if ( (_params.size()+1)*2 > _slots.size() )
+		this->rehash( _slots.empty() ? 16 : _slots.size()*2 );
+	
+	idx = _params.size();
+	_params.push_back( CgiParam() );
+	_params[idx].name = name;
+	
+	cgi_meta meta;
+	meta.hash = cgi_name_hash( name.data(), name.length() );
+	meta.first = meta.last = -1;
+	meta.joined = false;
+	_metas.push_back( meta );
+	
+	size_t mask = _slots.size() - 1;
+	size_t i = meta.hash & mask;
+	while ( _slots[i] >= 0 )
+		i = ( i+1 ) & mask;
+	_slots[i] = idx;
+	
+	return idx;
+}
+
+/// 重建散列表
+/// \param size 散列表大小,必须为2的整数次幂
+void Cgi::rehash( const size_t size ) {
+	_slots.assign( size, -1 );
+	size_t mask = size - 1;
+	for ( size_t idx=0; idx<_metas.size(); ++idx ) {
+		size_t i = _metas[idx].hash & mask;
+		while ( _slots[i] >= 0 )
+			i = ( i+1 ) & mask;
+		_slots[i] = idx;
+	}
 }
 
-/// urlencoded
-/// \param buf Ҫ
-void Cgi::parse_urlencoded( const string &buf ) {
+/// 解码参数的全部未解码参数值
+/// \param idx 参数位置
+void Cgi::decode_param( const size_t idx ) const {
+	cgi_meta &meta = _metas[idx];
+	if ( meta.first < 0 )
+		return;
+	
+	const char *query = this->query().data();
+	vector<string> &values = _params[idx].values;
+	for ( int i=meta.first; i>=0; i=_raws[i].next )
+		values.push_back( form_decode(query+_raws[i].pos,_raws[i].len) );
+	meta.first = meta.last = -1;
+	meta.joined = false;
+}
+
+/// 合并参数的全部参数值
+/// \param idx 参数位置
+/// \return 合并结果,参数值之间分隔符为半角空格' ',空参数值不增加分隔符
+const string& Cgi::join_param( const size_t idx ) const {
+	this->decode_param( idx );
+	const vector<string> &values = _params[idx].values;
+	if ( values.size() == 1 )
+		return values[0];
+	
+	cgi_meta &meta = _metas[idx];
+	if ( !meta.joined ) {
+		meta.join = "";
+		for ( size_t i=0; i<values.size(); ++i ) {
+			if ( meta.join == "" )
+				meta.join = values[i];
+			else
+				meta.join += ( " " + values[i] );
+		}
+		meta.joined = true;
+	}
+	return meta.join;
+}
+
+/// urlencoded解码
+/// \param str 要解码的字符串
+/// \param length 字符串长度
+/// \return 解码结果,'+'解码为半角空格' '
+string Cgi::form_decode( const char *str, const size_t length ) {
+	string buf( str, length );
+	for ( size_t i=0; i<buf.length(); ++i ) {
+		if ( buf[i] == '+' )
+			buf[i] = ' ';
+	}
+	if ( buf.find('%') != buf.npos )
+		return uri_decode( buf );
+	return buf;
+}
+
+/// 分析urlencoded类型内容
+/// 参数名称解码后加入参数列表,参数值只记录位置,在读取时才解码
+/// \param input 要分析的内容,分析后直接引用不复制,为NULL则分析Cgi对象内保存的内容
+void Cgi::parse_urlencoded( const string *input ) {
 	/*****************************
 	name1=value1&name2=value2&...
 	*****************************/
 
-	String buffer = buf;
-	vector<String> pairslist = buffer.split( "&" );
+	_input = input;
+	const char *query = this->query().data();
+	size_t len = this->query().length();
+	size_t pos = 0;
 	
-	for ( size_t i=0; i<pairslist.size(); ++i ) {
-		String name = pairslist[i].substr( 0, pairslist[i].find("=") );
-		String value = pairslist[i].substr( pairslist[i].find("=")+1 );
-
-		name.replace_all( "+", " " );
-		name = uri_decode( name );
-		value.replace_all( "+", " " );
-		value = uri_decode( value );
+	while ( pos < len ) {
+		const char *amp = (const char*)memchr( query+pos, '&', len-pos );
+		size_t end = ( amp!=NULL ) ? amp-query : len;
+		
+		// ignore blank pair
+		if ( end > pos ) {
+			const char *eq = (const char*)memchr( query+pos, '=', end-pos );
+			size_t name_len = ( eq!=NULL ) ? eq-query-pos : end-pos;
+			
+			cgi_value raw;
+			raw.next = -1;
+			if ( eq != NULL ) {
+				raw.pos = eq - query + 1;
+				raw.len = end - raw.pos;
+			} else {
+				// no '=', value is the whole pair
+				raw.pos = pos;
+				raw.len = end - pos;
+			}
+			
+			int idx;
+			if ( memchr(query+pos,'%',name_len)!=NULL || memchr(query+pos,'+',name_len)!=NULL )
+				idx = this->insert_param( form_decode(query+pos,name_len) );
+			else
+				idx = this->insert_param( string(query+pos,name_len) );
+			
+			// append to value list of param
+			cgi_meta &meta = _metas[idx];
+			int cur = _raws.size();
+			_raws.push_back( raw );
+			if ( meta.last >= 0 )
+				_raws[meta.last].next = cur;
+			else
+				meta.first = cur;
+			meta.last = cur;
+		}
 		
-		add_cgi( name, value );
+		pos = end + 1;
 	}
 }
 
-/// multipart,
-/// HTML FORM Ϊ enctype=multipart/form-data
-/// \param content_type Content-Typeַ
-/// \param buf Ҫ
-void Cgi::parse_multipart( const string &content_type, const string &buf ) {
+/// 分析multipart类型内容,
+/// HTML FORM 参数为 enctype=multipart/form-data
+/// \param content_type Content-Type描述字符串
+/// \param input 要分析的内容,为NULL则从stdin分块读取
+/// \param maxsize 最大分析数据长度,为0不限制
+/// \retval true 数据超过最大长度被截断
+/// \retval false 未截断
+bool Cgi::parse_multipart( const string &content_type, const string *input, 
+	const size_t maxsize ) 
+{
 	/*******************************************************
-	ָΪ{boundary}س(0x0D)ͻз(0x0A)Ϊ<CR>
+	设分隔符为{boundary}，回车(0x0D)和换行符(0x0A)为<CR>
 	
 	multipart/form-data, boundary={boundary}
 	
-	1.ļͲmultipartʽ
+	1.文件型参数的multipart格式：
 	--{boundary}<CR>
-	Content-Disposition: form-data; name=""; filename="ļ"<CR>
+	Content-Disposition: form-data; name="参数名称"; filename="文件名称"<CR>
 	Content-Type: {Content-Type}<CR>
 	<CR>
-	ļ
+	文件内容
 	<CR>
 	--{boundary}<CR>
 	
-	2.ͨmultipartʽ
+	2.普通参数的multipart格式：
 	--{boundary}<CR>
-	Content-Disposition: form-data; name=""<CR>
+	Content-Disposition: form-data; name="参数名称"<CR>
 	<CR>
-	ֵ
+	参数值
 	<CR>
 	--{boundary}<CR>
 	*******************************************************/
 	
-	String buffer = buf;
-	size_t pos = 0;
-	const char cr[3] = "\x0D\x0A";
-	String boundary = "";
-	
 	// get boundary
 	/*****************************************************
 	multipart/form-data, boundary={boundary}
 	*****************************************************/
-	
+	size_t pos;
+	string boundary;
 	if ( (pos=content_type.find("boundary=")) != content_type.npos )
-		boundary = ( "--" + content_type.substr(pos+9) ); // 9: strlen("boundary=")
-	else return; // format error
-	
-	// split by boundary
-	vector<String> item = buffer.split( boundary );
-	for ( size_t i=0; i<item.size(); ++i ) {
-		if ( item[i].length() > 0 ) {
-			String itembuf = item[i];
-			size_t nextpos = 0;
-			String itemname;
-			String itemvalue;
-
-			// split tags
-			String crcr = cr; crcr += cr;	// <CR><CR>
-			String qucr = "\""; qucr += cr;	// "<CR>
-			String qucrcr = qucr + cr;		// "<CR><CR>
-
-			if ( (pos=itembuf.find("; name=\"")) != itembuf.npos ) {
-				size_t filename_pos = 0;
-				if ( (filename_pos=itembuf.find("; filename=\"")) != itembuf.npos ) {					
-					// ļͲ
-					/******************************************************
-					Content-Disposition: form-data; name=""; filename="ļ"<CR>
-					Content-Type: {Content-Type}<CR>
-					<CR>
-					ļ
-					<CR>
-					******************************************************/
-					
-					// 
-					/******************************************************
-					 = ļ
-					_name = ļ
-					_type = {Content-Type}
-					******************************************************/
-
-					String filename;
-					String filetype;
-					
-					// 
-					if ( filename_pos > (pos+9) ) // 9: strlen("; name=\"\"")
-						itemname = itembuf.substr( pos+8, filename_pos-pos-9 ); // 9->8?
-
-					if ( itemname != "" ) {
-						// _name = ļ
-						if ( (nextpos=itembuf.find(qucr,filename_pos)) != itembuf.npos
-							&& nextpos >= (filename_pos+12) ) { // 12: strlen("; filename=\"")						
-							filename = itembuf.substr( filename_pos+12, nextpos-filename_pos-12 );
-							if ( filename != "" )
-								add_cgi( (itemname+"_name"), filename );
-						}
-
-						// _type = {Content-Type}
-						if ( (pos=itembuf.find("Content-Type: ",filename_pos)) != itembuf.npos
-							&& (nextpos=itembuf.find(crcr,pos)) != itembuf.npos
-							&& nextpos >= (pos+14) ) { // 14: strlen("Content-Type: ")
-							
-							filetype = itembuf.substr( pos+14, nextpos-pos-14 );
-							if ( filetype != "" )
-								add_cgi( (itemname+"_type"), filetype );
-						}
-
-						//  = ļ
-						if ( (pos=nextpos+4) != itembuf.npos // 4: strlen("")
-							&& (nextpos=itembuf.rfind(cr)) != itembuf.npos
-							&& nextpos >= (pos+1) ) {
-							itemvalue = itembuf.substr( pos, nextpos-pos );
-							if ( itemvalue!= "" )
-								add_cgi( itemname, itemvalue );
-						}
-					}
-				} // ļͲ
-				
-				else {
-					// ͨ
-					/******************************************************
-					Content-Disposition: form-data; name=""<CR>
-					<CR>
-					ֵ
-					<CR>
-					******************************************************/
-					
-					// 
-					if ( (nextpos=itembuf.find(qucr,pos)) != itembuf.npos )
-						itemname = itembuf.substr( pos+8, nextpos-pos-8 ); // 8: strlen("; name=\"")
-					
-					//  = ֵ
-					if ( itemname != ""
-						&& (pos=itembuf.find(qucrcr)) != itembuf.npos 
-						&& (nextpos=itembuf.rfind(cr)) != itembuf.npos
-						&& nextpos >= (pos+6) ) { // 6: strlen("\"<CR>\n")
-						// 5: strlen("\"<CR>") 6: strlen("\"<CR>\n")
-						itemvalue = itembuf.substr( pos+5, nextpos-pos-5 );
-						if ( itemvalue != "" )
-							add_cgi( itemname, itemvalue );
-					}
-				}// ͨ
+		boundary = content_type.substr( pos+9 ); // 9: strlen("boundary=")
+	else return false; // format error
+	
+	FormDataParser parser( boundary );
+	bool trunc = false;
+	
+	if ( input != NULL ) {
+		// parse request input, no copy
+		size_t len = input->length();
+		if ( maxsize>0 && len>maxsize ) {
+			len = maxsize;
+			trunc = true;
+		}
+		parser.feed( input->data(), len );
+	} else {
+		// read stdin chunk by chunk
+		const size_t CHUNK_SIZE = 65536;
+		long content_length = atol( get_env("CONTENT_LENGTH").c_str() );
+		size_t total = ( content_length>0 ) ? content_length : 0;
+		size_t readed = 0;
+		char buf[CHUNK_SIZE];
+		
+		while ( total==0 || readed<total ) {
+			size_t want = CHUNK_SIZE;
+			if ( total>0 && total-readed<want )
+				want = total - readed;
+			if ( maxsize > 0 ) {
+				if ( readed >= maxsize ) {
+					if ( total>maxsize || read(0,buf,1)>0 )
+						trunc = true;
+					break;
+				}
+				want = min( want, maxsize-readed );
 			}
-		} // one item
-	} // split by boundary
+
+			ssize_t n = read( 0, buf, want );
+			if ( n < 0 && errno == EINTR )
+				continue;
+			if ( n <= 0 )
+				break;
+			parser.feed( buf, n );
+			readed += n;
+		}
+	}
+	
+	// save result
+	parser.finish();
+	for ( size_t i=0; i<parser.fields.size(); ++i )
+		this->add_cgi( parser.fields[i].first, parser.fields[i].second );
+	_spools.insert( _spools.end(), parser.spools.begin(), parser.spools.end() );
 	
+	return trunc;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 // Cookie
 
-/// 캯
-/// ȡCookie
+/// 构造函数
+/// 读取并分析Cookie环境变量
 Cookie::Cookie() {
 	this->parse_cookie( get_env("HTTP_COOKIE") );
 }
 
-/// ȡcookie
-/// \param name cookie,Сд
-/// \return ɹcookieֵ,򷵻ؿַ
+/// 取得cookie内容
+/// \param name cookie参数名,大小写敏感
+/// \return 成功返回cookie参数值,否则返回空字符串
 string Cookie::get_cookie( const string &name ) {
 	if ( name!="" && _cookies.find(name)!=_cookies.end() )
 		return _cookies[name];
@@ -342,13 +925,13 @@ string Cookie::get_cookie( const string &name ) {
 		return string( "" );
 }
 
-/// cookie
-/// content-typeǰ
-/// \param name cookie
-/// \param value cookieֵ
-/// \param expires cookieЧ,GMTʽַ,ĬΪ
-/// \param path cookie·,ĬΪ"/"
-/// \param domain cookie,ĬΪ""
+/// 设置cookie内容
+/// 必须在回应头输出前调用,由 Response::current() 缓存为Set-Cookie回应头
+/// \param name cookie名字
+/// \param value cookie值
+/// \param expires cookie有效期,GMT格式日期字符串,默认为空
+/// \param path cookie路径,默认为"/"
+/// \param domain cookie域,默认为""
 void Cookie::set_cookie( const string &name, const string &value, 
 	const string &expires, const string &path, const string &domain ) const 
 {
@@ -360,14 +943,14 @@ void Cookie::set_cookie( const string &name, const string &value,
 	else
 		expires_setting = "";
 	
-	cout << "Set-Cookie: " + name + "=" + value + "; "
-		 << expires_setting
-		 << "path=" + path + "; "
-		 << "domain=" + domain + ";" << endl;
+	Response::current().add_header( "Set-Cookie", name + "=" + value + "; "
+		+ expires_setting
+		+ "path=" + path + "; "
+		+ "domain=" + domain + ";" );
 }
 
-/// cookie
-/// \param buf Ҫ
+/// 分析cookie内容
+/// \param buf 要分析的内容
 void Cookie::parse_cookie( const string &buf ) {
 	/*****************************
 	name1=value1; name2=value2; ...
@@ -1,12 +1,17 @@
 /// \file waCgi.h
-/// webapp::Cgi,webapp::Cookieͷļ
-///  webapp::String, webapp::Encode
+/// webapp::Cgi,webapp::Cookie类头文件
+/// 依赖于 webapp::String, webapp::Encode, webapp::Response
 
 #ifndef _WEBAPPLIB_CGI_H_
 #define _WEBAPPLIB_CGI_H_ 
 
 #include <string>
+#include <vector>
 #include <map>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#include "waString.h"
 
 using namespace std;
 
@@ -14,62 +19,153 @@ using namespace std;
 namespace webapp {
 
 ////////////////////////////////////////////////////////////////////////////////	
-/// HTML Content-Type header
+/// 输出HTML Content-Type header
 void http_head();
-/// ȡû
+/// 取得环境变量
 string get_env( const string &envname );
 
 ////////////////////////////////////////////////////////////////////////////////
 
-/// \defgroup waCgi waCgiȫֺ
+/// \defgroup waCgi waCgi相关数据类型与全局函数
 
 /// \ingroup waCgi
 /// \typedef CgiList 
-/// Cgi ֵб (map<string,string>)
+/// Cgi 参数值列表类型 (map<string,string>)
 typedef map<string,string> CgiList;
 
-/// CGIȡ
+/// \ingroup waCgi
+/// \typedef CgiEnv 
+/// CGI 请求环境变量列表类型 (map<string,string>)
+typedef map<string,string> CgiEnv;
+
+/// 设置当前请求的环境变量及输入数据,用于常驻进程模式
+void set_cgi_request( const CgiEnv *env, const string *input );
+
+/// \ingroup waCgi
+/// \typedef upload_handler
+/// 上传文件处理回调函数类型,
+/// 参数依次为参数名称,文件名称,文件数据,数据长度,set_upload_handler()设置的参数,
+/// 返回false则忽略该文件的后续数据
+typedef bool (*upload_handler)( const string &name, const string &filename, 
+	const char *data, const size_t len, void *arg );
+
+/// 设置上传文件临时保存方式
+void set_upload_spool( const size_t spool_size, const string &spool_dir = "/tmp" );
+/// 设置上传文件处理回调函数
+void set_upload_handler( upload_handler handler, void *arg = NULL );
+
+/// \ingroup waCgi
+/// CGI参数,同名参数的全部参数值按出现顺序保存
+typedef struct {
+	string name;			///< 参数名称
+	vector<string> values;	///< 参数值列表
+} CgiParam;
+
+/// \ingroup waCgi
+/// \typedef CgiParams 
+/// CGI参数列表类型 (vector<CgiParam>)
+typedef vector<CgiParam> CgiParams;
+
+/// CGI参数读取类
 class Cgi {
 	public:
 
-	/// 캯
+	/// 构造函数
 	Cgi( const size_t formdata_maxsize = 0 );
 	
-	/// 
-	virtual ~Cgi(){};
+	/// 析构函数
+	virtual ~Cgi();
 	
-	/// ȡCGI
+	/// 取得CGI参数
 	string get_cgi( const string &name );
+	/// 取得CGI参数,不复制参数值
+	const char* get_cgi( const string &name, size_t &length ) const;
+
+#if __cplusplus >= 201703L
+	/// 取得CGI参数,不复制参数值
+	/// \param name CGI参数名,大小写敏感
+	/// \return 参数值,有效期同 get_cgi(name,length),参数不存在返回空string_view
+	inline string_view get_view( const string &name ) const {
+		size_t length;
+		const char *value = this->get_cgi( name, length );
+		return ( value!=NULL ) ? string_view( value, length ) : string_view();
+	}
+#endif
 	
-	/// ȡCGI
+	/// 取得CGI参数
 	inline string operator[] ( const string &name ) {
 		return this->get_cgi( name );
 	}
 	
-	/// FORMݴСǷ񳬳
+	/// 取得CGI参数的全部参数值
+	const vector<string>& get_values( const string &name ) const;
+	
+	/// FORM数据大小是否超出限制
 	inline bool is_trunc() const {
 		return _trunc;
 	}
 	
-	/// زֵб
-	/// \return ֵΪCgiList,map<string,string>.	
-	inline CgiList dump() const {
-		return _cgi;
-	}
+	/// 返回CGI参数列表
+	const CgiParams& params() const;
+	
+	/// 返回参数值列表
+	CgiList dump() const;
 	
 	////////////////////////////////////////////////////////////////////////////
 	private:
 	
-	/// CGI
+	/// 查找参数位置
+	int find_param( const string &name ) const;
+	/// 增加参数
+	int insert_param( const string &name );
+	/// 重建散列表
+	void rehash( const size_t size );
+	/// 解码参数的全部未解码参数值
+	void decode_param( const size_t idx ) const;
+	/// 合并参数的全部参数值
+	const string& join_param( const size_t idx ) const;
+	/// urlencoded解码
+	static string form_decode( const char *str, const size_t length );
+	
+	/// urlencoded原始数据
+	inline const string& query() const {
+		return ( _input!=NULL ) ? *_input : _query;
+	}
+
+	/// 读取stdin输入数据
+	bool read_stdin( string &buf, const size_t maxsize );
+
+	/// 保存CGI参数
 	void add_cgi( const string &name, const string &value );
 	
-	/// urlencoded
-	void parse_urlencoded( const string &buf );
-	
-	/// multipart
-	void parse_multipart( const string &content_type, const string &buf );
-
-	map<string,string> _cgi;
+	/// 分析urlencoded类型内容
+	void parse_urlencoded( const string *input );
+	
+	/// 分析multipart类型内容
+	bool parse_multipart( const string &content_type, const string *input, 
+		const size_t maxsize );
+
+	typedef struct {					// 未解码参数值位置
+		size_t pos;						// 参数值位置
+		size_t len;						// 参数值长度
+		int next;						// 同名参数的下一个参数值,-1为无
+	} cgi_value;
+	
+	typedef struct {					// 参数索引信息
+		size_t hash;					// 参数名称散列值
+		int first;						// 第一个未解码参数值,-1为无
+		int last;						// 最后一个未解码参数值
+		bool joined;					// 合并缓存是否有效
+		string join;					// 多个参数值合并缓存
+	} cgi_meta;
+
+	mutable CgiParams _params;			// 参数列表,按名称首次出现顺序
+	mutable vector<cgi_meta> _metas;	// 参数索引信息,与_params一一对应
+	vector<cgi_value> _raws;			// 未解码参数值位置列表
+	vector<int> _slots;					// 开放寻址散列表,保存参数位置,-1为空
+	string _query;						// urlencoded原始数据
+	const string *_input;				// 常驻进程模式下引用的请求输入数据
+	vector<string> _spools;
 	String _method;
 	bool _trunc;
 };
@@ -77,40 +173,40 @@ class Cgi {
 ////////////////////////////////////////////////////////////////////////////
 /// \ingroup waCgi
 /// \typedef CookieList 
-/// Cookie ֵб (map<string,string>)
+/// Cookie 参数值列表类型 (map<string,string>)
 typedef map<string,string> CookieList;
 
-/// Cookieȡ,
+/// Cookie读取,设置类
 class Cookie {
 	public:
 	
-	/// 캯
+	/// 构造函数
 	Cookie();
 	
-	/// 
+	/// 析构函数
 	virtual ~Cookie(){};
 	
-	/// ȡcookie
+	/// 取得cookie内容
 	string get_cookie( const string &name );
 	
-	/// ȡcookie
+	/// 取得cookie内容
 	inline string operator[] ( const string &name ) {
 		return this->get_cookie( name );
 	}
 	
-	/// cookie
+	/// 设置cookie内容
 	void set_cookie( const string &name, const string &value, 
 		const string &expires = "", const string &path = "/", 
 		const string &domain = "" ) const;
 
-	/// ָcookie
-	/// \param name cookie
+	/// 清除指定的cookie内容
+	/// \param name cookie名字
 	inline void del_cookie( const string &name ) const {
 		this->set_cookie( name, "", "Thursday,01-January-1970 08:00:01 GMT" );
 	}
 	
-	/// زֵб
-	/// \return ֵΪCookieList,map<string,string>.	
+	/// 返回参数值列表
+	/// \return 返回值类型为CookieList,即map<string,string>.	
 	inline CookieList dump() const {
 		return _cookies;
 	}
@@ -118,7 +214,7 @@ class Cookie {
 	////////////////////////////////////////////////////////////////////////////
 	private:
 	
-	/// cookie
+	/// 分析cookie内容
 	void parse_cookie( const string &buf );
 
 	map<string,string> _cookies;		
@@ -1,5 +1,5 @@
 /// \file waConfigFile.cpp
-/// INIʽļʵļ
+/// INI格式配置文件解析类实现文件
 
 #include <fstream>
 #include <set>
@@ -13,10 +13,10 @@ using namespace std;
 /// Web Application Library namaspace
 namespace webapp {
 	
-/// ȡļ
-/// \param file ļ·
-/// \retval true ɹ
-/// \retval false ʧ
+/// 读取解析配置文件
+/// \param file 配置文件路径名
+/// \retval true 解析成功
+/// \retval false 解析失败
 bool ConfigFile::load( const string &file ) {
 	if ( file == "" ) return false;
 	_file = file;
@@ -94,10 +94,10 @@ bool ConfigFile::load( const string &file ) {
 	return true;
 }
 
-/// ļ
-/// \param file ļ·ĬΪʹöȡļ
-/// \retval true ɹ
-/// \retval false ʧ
+/// 保存配置文件
+/// \param file 配置文件路径名，默认为空则使用读取文件参数
+/// \retval true 保存成功
+/// \retval false 保存失败
 bool ConfigFile::save( const string &file ) {
 	string config_file = _file;
 	if ( file != "" )
@@ -123,11 +123,11 @@ bool ConfigFile::save( const string &file ) {
 	return _unsaved;
 }
 
-/// Ƿ	
-/// \param block ÿΪձʾȫÿ
-/// \param name 
-/// \retval true 
-/// \retval false 
+/// 检查配置项是否存在	
+/// \param block 配置块名，为空表示全局配置块
+/// \param name 配置项名
+/// \retval true 存在
+/// \retval false 不存在
 bool ConfigFile::value_exist( const string &block, const string &name ) {
 	if ( name == "" )
 		return false;	
@@ -145,10 +145,10 @@ bool ConfigFile::value_exist( const string &block, const string &name ) {
 	return false;
 }
 
-/// ÿǷ
-/// \param block ÿΪձʾȫÿ
-/// \retval true 
-/// \retval false 
+/// 检查配置块是否存在
+/// \param block 配置块名，为空表示全局配置块
+/// \retval true 存在
+/// \retval false 不存在
 bool ConfigFile::block_exist( const string &block ) {
 	if ( block == "" )
 		return true;
@@ -160,11 +160,11 @@ bool ConfigFile::block_exist( const string &block ) {
 		return false;
 }
 
-/// ȡֵ
-/// \param block ÿΪձʾȫÿ
-/// \param name 
-/// \param default_value Ĭϲֵʱ
-/// \return ֵָ
+/// 读取配置项参数值
+/// \param block 配置块名，为空表示全局配置块
+/// \param name 配置项名
+/// \param default_value 默认参数值，配置项不存在时返回
+/// \return 指定配置项参数值
 string ConfigFile::get_value( const string &block, const string &name, 
 						  const string &default_value ) {
 	if ( name == "" )
@@ -184,9 +184,9 @@ string ConfigFile::get_value( const string &block, const string &name,
 	return _viter->second;
 }
 
-/// ȡָÿȫֵ
-/// \param block ÿΪձʾȫÿ
-/// \return ָÿȫֵб
+/// 读取指定配置块的全部配置项参数值
+/// \param block 配置块名，为空表示全局配置块
+/// \return 指定配置块的全部配置项参数值列表
 map<string,string> ConfigFile::get_block( const string &block ) {
 	value_def valuelist;	
 	if ( block_exist(block) )
@@ -194,8 +194,8 @@ map<string,string> ConfigFile::get_block( const string &block ) {
 	return valuelist;
 }
 
-/// ȡȫÿб		
-/// \return ȫÿбȫÿ飨blockֵΪգ
+/// 读取全部配置块列表		
+/// \return 全部配置块列表，包括全局配置块（block值为空）
 vector<string> ConfigFile::block_list() {
 	vector<string> blocklist;
 	_biter = _config.begin();
@@ -204,12 +204,12 @@ vector<string> ConfigFile::block_list() {
 	return blocklist;
 }
 	
-/// 
-/// \param block ÿΪձʾȫÿ
-/// \param name 
-/// \param value òֵ
-/// \retval true ³ɹ
-/// \retval false ʧ
+/// 更新配置项
+/// \param block 配置块名，为空表示全局配置块
+/// \param name 配置项名
+/// \param value 配置参数值
+/// \retval true 更新成功
+/// \retval false 更新失败
 bool ConfigFile::set_value( const string &block, const string &name, 
 	const string &value ) 
 {
@@ -220,11 +220,11 @@ bool ConfigFile::set_value( const string &block, const string &name,
 	return _unsaved;
 }
 
-/// ָÿб
-/// \param block ÿΪձʾȫÿ
-/// \param valuelist òֵб
-/// \retval true ³ɹ
-/// \retval false ʧ
+/// 更新指定配置块的配置项列表
+/// \param block 配置块名，为空表示全局配置块
+/// \param valuelist 配置参数值对列表
+/// \retval true 更新成功
+/// \retval false 更新失败
 bool ConfigFile::set_block( const string &block, 
 	const map<string,string> &valuelist ) 
 {
@@ -239,9 +239,9 @@ bool ConfigFile::set_block( const string &block,
 	return _unsaved;
 }
 
-/// ɾ
-/// \param block ÿΪձʾȫÿ
-/// \param name 
+/// 删除配置项
+/// \param block 配置块名，为空表示全局配置块
+/// \param name 配置项名
 void ConfigFile::del_value( const string &block, const string &name ) {
 	_biter = _config.find( block );
 	if ( _biter != _config.end() ) {
@@ -254,8 +254,8 @@ void ConfigFile::del_value( const string &block, const string &name ) {
 	}
 }
 
-/// ɾÿ
-/// \param block ÿΪձʾȫÿ
+/// 删除配置块
+/// \param block 配置块名，为空表示全局配置块
 void ConfigFile::del_block( const string &block ) {
 	_biter = _config.find( block );
 	if ( _biter != _config.end() ) {
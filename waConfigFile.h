@@ -1,6 +1,6 @@
 /// \file waConfigFile.h
-/// INIʽļͷļ
-///  webapp::String, webapp::TextFile
+/// INI格式配置文件解析类头文件
+/// 依赖于 webapp::String, webapp::TextFile
 
 #ifndef _WEBAPPLIB_CONFIGFILE_H_
 #define _WEBAPPLIB_CONFIGFILE_H_
@@ -14,70 +14,70 @@ using namespace std;
 /// Web Application Library namaspace
 namespace webapp {
 
-/// INIʽļ
+/// INI格式配置文件解析类
 class ConfigFile
 {
 	public:
 	
-	/// ĬϹ캯
+	/// 默认构造函数
 	ConfigFile(): _file(""), _unsaved(false) {};
 	
-	/// ΪļĹ캯
+	/// 参数为配置文件名的构造函数
 	ConfigFile( const string &file )
 	: _file(""), _unsaved(false) {
 		this->load( file );
 	}
 	
-	/// 
+	/// 析构函数
 	~ConfigFile() {
 		if ( _unsaved ) this->save();
 	};
 
 	////////////////////////////////////////////////////////////////////////////
-	/// ȡļ
+	/// 读取解析配置文件
 	bool load( const string &file );
 	
-	/// ļ
+	/// 保存配置文件
 	bool save( const string &file = "" );
 
-	/// Ƿ	
+	/// 检查配置项是否存在	
 	bool value_exist( const string &block, const string &name );
 	
-	/// ÿǷ
+	/// 检查配置块是否存在
 	bool block_exist( const string &block );
 
 	////////////////////////////////////////////////////////////////////////////
-	/// ȡֵ
+	/// 读取配置项参数值
 	inline string operator[] ( const string &name ) {
 		return this->get_value( "", name );
 	}
 
-	/// ȡֵ
+	/// 读取配置项参数值
 	string get_value( const string &block, const string &name, const string &default_value = "" );
 
-	/// ȡָÿȫֵ
+	/// 读取指定配置块的全部配置项参数值
 	map<string,string> get_block( const string &block );
 
-	/// ȡȫÿб					
+	/// 读取全部配置块列表					
 	vector<string> block_list();
 	
 	////////////////////////////////////////////////////////////////////////////
-	/// 
+	/// 更新配置项
 	inline bool set_value( const string &name, const string &value ) {
 		return this->set_value( "", name, value );
 	}
 
-	/// 
+	/// 更新配置项
 	bool set_value( const string &block, const string &name, const string &value );
 	
-	/// ָÿб
+	/// 更新指定配置块的配置项列表
 	bool set_block( const string &block, const map<string,string> &valuelist );
 
 	////////////////////////////////////////////////////////////////////////////
-	/// ɾ
+	/// 删除配置项
 	void del_value( const string &block, const string &name );
 	
-	/// ɾÿ
+	/// 删除配置块
 	void del_block( const string &block );
 	
 	////////////////////////////////////////////////////////////////////////////
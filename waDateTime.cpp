@@ -1,5 +1,5 @@
 /// \file waDateTime.cpp
-/// webapp::DateTimeʵļ
+/// webapp::DateTime类实现文件
 
 #include <cstdio>
 #include <cstring>
@@ -11,14 +11,14 @@ using namespace std;
 /// Web Application Library namaspace
 namespace webapp {
 	
-/// Եǰʱö
+/// 以当前时间设置对象
 void DateTime::set() {
 	_time = ::time( 0 );
 	localtime_r( &_time, &_tm );
 }
 
-///  time_t ö
-/// \param tt time_tͲ
+/// 以 time_t 参数设置对象
+/// \param tt time_t类型参数
 void DateTime::set( const time_t &tt ) {
 	time_t _tt = tt;
 	if ( tt < 0 ) _tt = 0;
@@ -28,15 +28,15 @@ void DateTime::set( const time_t &tt ) {
 	localtime_r( &_time, &_tm );
 }
 
-/// ָʱö
-/// Чʱ,Ϊϵͳʼʱ䣨1970/1/1
-/// ʱ䲻,Ϊ˳Чʱ䣨2/29Ϊ3/1
-/// \param year 
-/// \param mon 
-/// \param mday 
-/// \param hour ʱ,ĬΪ0
-/// \param min ,ĬΪ0
-/// \param src ,ĬΪ0
+/// 以指定时间设置对象
+/// 若参数不是有效日期时间,则设置为系统初始时间（1970/1/1）
+/// 若参数日期时间不存在,则设置为顺延有效时间（非闰年2/29视为3/1）
+/// \param year 年
+/// \param mon 月
+/// \param mday 日
+/// \param hour 时,默认为0
+/// \param min 分,默认为0
+/// \param src 秒,默认为0
 void DateTime::set( const int year, const int mon, const int mday, 
 	const int hour, const int min, const int sec ) 
 {
@@ -65,25 +65,25 @@ void DateTime::set( const int year, const int mon, const int mday,
 	_time = mktime( &_tm );
 }
 
-///  tm ṹö
-/// \param st struct tmͲ
+/// 以 tm 结构参数设置对象
+/// \param st struct tm类型参数
 void DateTime::set( const tm &st ) {
 	this->set( st.tm_year+1900, st.tm_mon+1, st.tm_mday,
 		st.tm_hour, st.tm_min, st.tm_sec );
 }
 
-///  DateTime ö
-/// \param date DateͲ
+/// 以 DateTime 参数设置对象
+/// \param date Date类型参数
 void DateTime::set( const DateTime &date ) {
 	this->set( date.value() );
 }
 
-/// "YYYY-MM-DD HH:MM:SS"ʽַö
-/// ַʽʱֵΪǰʱ
-/// \param datetime "YYYY-MM-DD HH:MM:SS"ʽʱַ
-/// \param datemark ڷַָ,ĬΪ"-"
-/// \param dtmark ʱַָ,ĬΪ" ",datemarktimemarkͬ
-/// \param timemark ʱַָ,ĬΪ":"
+/// 以"YYYY-MM-DD HH:MM:SS"格式字符串设置对象
+/// 若字符串格式错误或者时间值错误则设置为当前时间
+/// \param datetime "YYYY-MM-DD HH:MM:SS"格式日期时间字符串
+/// \param datemark 日期分隔字符,默认为"-"
+/// \param dtmark 日期时间分隔字符,默认为" ",不能与datemark或timemark相同
+/// \param timemark 时间分隔字符,默认为":"
 void DateTime::set( const string &datetime, const string &datemark, 
 	const string &dtmark, const string &timemark ) 
 {
@@ -106,10 +106,10 @@ void DateTime::set( const string &datetime, const string &datemark,
 		this->set();
 }
 
-/// ַ
-/// \param datemark ڷַָ,ĬΪ"-"
-/// \param leadingzero Ƿ񲹳ǰ,ĬΪ
-/// \return ָʽַ
+/// 输出日期字符串
+/// \param datemark 日期分隔字符,默认为"-"
+/// \param leadingzero 是否补充前置零,默认为是
+/// \return 输出指定格式的日期字符串
 string DateTime::date( const string &datemark, const bool leadingzero ) const {
 	char date_str[32];
 	if ( leadingzero )
@@ -122,10 +122,10 @@ string DateTime::date( const string &datemark, const bool leadingzero ) const {
 	return string( date_str );
 }
 
-/// ʱַ
-/// \param timemark ʱַָ,ĬΪ":"
-/// \param leadingzero Ƿ񲹳ǰ,ĬΪ
-/// \return ָʽʱַ
+/// 输出时间字符串
+/// \param timemark 时间分隔字符,默认为":"
+/// \param leadingzero 是否补充前置零,默认为是
+/// \return 输出指定格式的时间字符串
 string DateTime::time( const string &timemark, const bool leadingzero ) const {
 	char time_str[32];
 	if ( leadingzero )
@@ -138,12 +138,12 @@ string DateTime::time( const string &timemark, const bool leadingzero ) const {
 	return string( time_str );
 }
 
-/// ʱַ
-/// \param datemark ڷַָ,ĬΪ"-"
-/// \param dtmark ʱַָ,ĬΪ" "
-/// \param timemark ʱַָ,ĬΪ":"
-/// \param leadingzero Ƿ񲹳ǰ,ĬΪ
-/// \return ָʽʱַ
+/// 输出日期时间字符串
+/// \param datemark 日期分隔字符,默认为"-"
+/// \param dtmark 日期时间分隔字符,默认为" "
+/// \param timemark 时间分隔字符,默认为":"
+/// \param leadingzero 是否补充前置零,默认为是
+/// \return 输出指定格式的日期时间字符串
 string DateTime::datetime( const string &datemark, const string &dtmark,
 	const string &timemark, const bool leadingzero ) const 
 {
@@ -152,9 +152,9 @@ string DateTime::datetime( const string &datemark, const string &dtmark,
 	return datetime;
 }
 
-///  GMT ʽʱַ
-/// Ҫ cookie Ч
-/// \return GMT ʽʱַ
+/// 输出 GMT 格式日期时间字符串
+/// 主要用于设置 cookie 有效期
+/// \return GMT 格式日期时间字符串
 string DateTime::gmt_datetime() const {
 	char gmt[50];
 	struct tm gmt_tm;
@@ -164,41 +164,41 @@ string DateTime::gmt_datetime() const {
 	return string( gmt );
 }
 
-/// ֵ
+/// 赋值操作
 DateTime& DateTime::operator=( const DateTime &date ) {
 	if ( this == &date ) return *this;
 	this->set( date );
 	return *this;	
 }
-/// ֵ
+/// 赋值操作
 DateTime& DateTime::operator=( const time_t &tt ) {
 	this->set( tt );
 	return *this;
 }
 
-/// 
+/// 递增操作
 DateTime& DateTime::operator+=( const DateTime &date ) {
 	this->set( value() + date.value() );
 	return *this;
 }
-/// 
+/// 递增操作
 DateTime& DateTime::operator+=( const time_t &tt ) {
 	this->set( value() + tt );
 	return *this;
 }
 
-/// ݼ
+/// 递减操作
 DateTime& DateTime::operator-=( const DateTime &date ) {
 	this->set( value() - date.value() );
 	return *this;
 }
-/// ݼ
+/// 递减操作
 DateTime& DateTime::operator-=( const time_t &tt ) {
 	this->set( value() - tt );
 	return *this;
 }
 
-/// صΧ1~31
+/// 返回当月天数，范围1~31
 int DateTime::m_days() const {
 	int m = this->month();
 	if ( m==1 || m==3 || m==5 || m==7 || m==8 || m==10 || m==12 ) { 
@@ -215,26 +215,26 @@ int DateTime::m_days() const {
 	}
 }
 
-/// Ӳ
+/// 相加操作
 DateTime operator+( const DateTime &date1, const DateTime &date2 ) {
 	DateTime newdate;
 	newdate.set( date1.value() + date2.value() );
 	return newdate;
 }
-/// Ӳ
+/// 相加操作
 DateTime operator+( const DateTime &date, const time_t &tt ) {
 	DateTime newdate;
 	newdate.set( date.value() + tt );
 	return newdate;
 }
 
-/// 
+/// 相减操作
 DateTime operator-( const DateTime &date1, const DateTime &date2 ) {
 	DateTime newdate;
 	newdate.set( date1.value() - date2.value() );
 	return newdate;
 }
-/// 
+/// 相减操作
 DateTime operator-( const DateTime &date, const time_t &tt ) {
 	DateTime newdate;
 	newdate.set( date.value() - tt );
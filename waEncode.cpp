@@ -1,5 +1,5 @@
 /// \file waEncode.cpp
-/// ַBASE64URIMD5뺯ʵļ
+/// 字符串BASE64、URI、MD5编码函数,输出转义函数实现文件
 
 #include <cstdio>
 #include <cstring>
@@ -10,18 +10,28 @@
 #include <iostream>
 #include "waEncode.h"
 
+// SSE2/AVX2 escape kernels, AVX2 selected at runtime
+#if defined(__GNUC__) && defined(__SSE2__)
+#define _WEBAPPLIB_ESCAPE_SSE2
+#include <emmintrin.h>
+#if defined(__x86_64__) && ( __GNUC__>=5 || defined(__clang__) )
+#define _WEBAPPLIB_ESCAPE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
 using namespace std;
 
 /// Web Application Library namaspace
 namespace webapp {
 	
-/// \defgroup waEncode waEncodeַܱ뺯
+/// \defgroup waEncode waEncode字符串加密编码函数库
 	
 ////////////////////////////////////////////////////////////////////////////////
-// URI
+// URI编码解码
 
-// HEXַתΪASCַ
-// ɺuri_decode()
+// HEX字符转换为ASC字符
+// 由函数uri_decode()调用
 char hex_to_asc( const string &src ) {
 	char digit;
 	digit = ( src[0]>='A' ? ((src[0]&0xdf)-'A')+10 : (src[0]-'0') );
@@ -33,9 +43,9 @@ char hex_to_asc( const string &src ) {
 
 /// \ingroup waEncode
 /// \fn string uri_encode( const string &source )
-/// URI
-/// \param source ԭַ
-/// \return ַ
+/// URI编码
+/// \param source 原字符串
+/// \return 编码结果字符串
 string uri_encode( const string &source ) {
 	const char reserved[] = ";/?:@&=+\0";
 	const char unsafe[] = " \"#%<>\0";
@@ -60,9 +70,9 @@ string uri_encode( const string &source ) {
 
 /// \ingroup waEncode
 /// \fn string uri_decode( const string &source )
-/// URI
-/// \param source URIַ
-/// \return 
+/// URI解码
+/// \param source URI编码字符串
+/// \return 解码结果
 string uri_decode( const string &source ) {
 	size_t pos = 0;
 	string seq;
@@ -85,7 +95,265 @@ string uri_decode( const string &source ) {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// BASE64
+// 输出转义
+
+// 需要转义的字符表,按转义方式索引
+struct escape_chars {
+	bool special[ESCAPE_JS+1][256];
+
+	escape_chars() {
+		memset( special, 0, sizeof(special) );
+		for ( int c=0; c<256; ++c ) {
+			bool html = ( c=='&' || c=='<' || c=='>' || c=='"' || c=='\'' );
+			special[ESCAPE_HTML][c] = html;
+			special[ESCAPE_ATTR][c] = html || c=='`' || c=='=' || c<=0x20;
+			special[ESCAPE_URL][c] = !( isalnum(c) || c=='-' || c=='_' || c=='.' || c=='~' ) || c>=0x80;
+			special[ESCAPE_JS][c] = c=='\\' || c=='\'' || c=='"' || c=='`' || c=='<' || 
+				c=='>' || c=='&' || c=='=' || c=='/' || c<0x20;
+		}
+	}
+};
+
+// 需要转义的字符表
+static const escape_chars& escape_table() {
+	static escape_chars table;
+	return table;
+}
+
+// 逐字节查找需要转义的字符
+static size_t escape_span_scalar( const bool *special, const char *source, const size_t length ) {
+	const unsigned char *s = reinterpret_cast<const unsigned char*>( source );
+	size_t i = 0;
+	while ( i<length && !special[s[i]] )
+		++i;
+	return i;
+}
+
+#ifdef _WEBAPPLIB_ESCAPE_SSE2
+// 16字节中需要转义的字符位置掩码
+template<int MODE> static inline int escape_mask_sse2( const __m128i x ) {
+	#define EQ(c) _mm_cmpeq_epi8( x, _mm_set1_epi8(c) )
+	#define LE(v,c) _mm_cmpeq_epi8( _mm_min_epu8(v,_mm_set1_epi8(c)), v )
+	#define IN(lo,hi) LE( _mm_sub_epi8(x,_mm_set1_epi8(lo)), (hi)-(lo) )
+	__m128i m = _mm_or_si128( _mm_or_si128(EQ('&'),EQ('<')), _mm_or_si128(EQ('>'),EQ('"')) );
+	switch ( MODE ) {
+		case ESCAPE_HTML:
+			m = _mm_or_si128( m, EQ('\'') );
+			break;
+		case ESCAPE_ATTR:
+			m = _mm_or_si128( _mm_or_si128(m,EQ('\'')), _mm_or_si128(EQ('`'),EQ('=')) );
+			m = _mm_or_si128( m, LE(x,0x20) );
+			break;
+		case ESCAPE_URL:
+			m = _mm_or_si128( _mm_or_si128(IN('0','9'),IN('A','Z')), _mm_or_si128(IN('a','z'),EQ('-')) );
+			m = _mm_or_si128( m, _mm_or_si128(_mm_or_si128(EQ('_'),EQ('.')),EQ('~')) );
+			return ~_mm_movemask_epi8( m ) & 0xffff;
+		case ESCAPE_JS:
+			m = _mm_or_si128( _mm_or_si128(m,EQ('\'')), _mm_or_si128(EQ('`'),EQ('=')) );
+			m = _mm_or_si128( m, _mm_or_si128(_mm_or_si128(EQ('\\'),EQ('/')),LE(x,0x1f)) );
+			break;
+	}
+	return _mm_movemask_epi8( m );
+	#undef EQ
+	#undef LE
+	#undef IN
+}
+
+// 每次检查16字节
+template<int MODE> static size_t escape_span_sse2( const char *source, const size_t length ) {
+	size_t i = 0;
+	for ( ; i+16<=length; i+=16 ) {
+		int mask = escape_mask_sse2<MODE>( _mm_loadu_si128(reinterpret_cast<const __m128i*>(source+i)) );
+		if ( mask != 0 )
+			return i + __builtin_ctz( mask );
+	}
+	return i + escape_span_scalar( escape_table().special[MODE], source+i, length-i );
+}
+#endif //_WEBAPPLIB_ESCAPE_SSE2
+
+#ifdef _WEBAPPLIB_ESCAPE_AVX2
+// 32字节中需要转义的字符位置掩码
+template<int MODE> __attribute__((target("avx2"))) 
+static inline unsigned int escape_mask_avx2( const __m256i x ) {
+	#define EQ(c) _mm256_cmpeq_epi8( x, _mm256_set1_epi8(c) )
+	#define LE(v,c) _mm256_cmpeq_epi8( _mm256_min_epu8(v,_mm256_set1_epi8(c)), v )
+	#define IN(lo,hi) LE( _mm256_sub_epi8(x,_mm256_set1_epi8(lo)), (hi)-(lo) )
+	__m256i m = _mm256_or_si256( _mm256_or_si256(EQ('&'),EQ('<')), _mm256_or_si256(EQ('>'),EQ('"')) );
+	switch ( MODE ) {
+		case ESCAPE_HTML:
+			m = _mm256_or_si256( m, EQ('\'') );
+			break;
+		case ESCAPE_ATTR:
+			m = _mm256_or_si256( _mm256_or_si256(m,EQ('\'')), _mm256_or_si256(EQ('`'),EQ('=')) );
+			m = _mm256_or_si256( m, LE(x,0x20) );
+			break;
+		case ESCAPE_URL:
+			m = _mm256_or_si256( _mm256_or_si256(IN('0','9'),IN('A','Z')), _mm256_or_si256(IN('a','z'),EQ('-')) );
+			m = _mm256_or_si256( m, _mm256_or_si256(_mm256_or_si256(EQ('_'),EQ('.')),EQ('~')) );
+			return ~static_cast<unsigned int>( _mm256_movemask_epi8(m) );
+		case ESCAPE_JS:
+			m = _mm256_or_si256( _mm256_or_si256(m,EQ('\'')), _mm256_or_si256(EQ('`'),EQ('=')) );
+			m = _mm256_or_si256( m, _mm256_or_si256(_mm256_or_si256(EQ('\\'),EQ('/')),LE(x,0x1f)) );
+			break;
+	}
+	return static_cast<unsigned int>( _mm256_movemask_epi8(m) );
+	#undef EQ
+	#undef LE
+	#undef IN
+}
+
+// 每次检查32字节
+template<int MODE> __attribute__((target("avx2"))) 
+static size_t escape_span_avx2( const char *source, const size_t length ) {
+	size_t i = 0;
+	for ( ; i+32<=length; i+=32 ) {
+		unsigned int mask = escape_mask_avx2<MODE>( _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source+i)) );
+		if ( mask != 0 )
+			return i + __builtin_ctz( mask );
+	}
+	return i + escape_span_sse2<MODE>( source+i, length-i );
+}
+#endif //_WEBAPPLIB_ESCAPE_AVX2
+
+typedef size_t (*escape_spanner)( const char *source, const size_t length );
+
+// 按转义方式选择的查找函数
+struct escape_kernels {
+	escape_spanner span[ESCAPE_JS+1];
+
+	escape_kernels() {
+		span[ESCAPE_NONE] = NULL;
+		#if defined(_WEBAPPLIB_ESCAPE_AVX2)
+		if ( __builtin_cpu_supports("avx2") ) {
+			span[ESCAPE_HTML] = escape_span_avx2<ESCAPE_HTML>;
+			span[ESCAPE_ATTR] = escape_span_avx2<ESCAPE_ATTR>;
+			span[ESCAPE_URL] = escape_span_avx2<ESCAPE_URL>;
+			span[ESCAPE_JS] = escape_span_avx2<ESCAPE_JS>;
+			return;
+		}
+		#endif
+		#if defined(_WEBAPPLIB_ESCAPE_SSE2)
+		span[ESCAPE_HTML] = escape_span_sse2<ESCAPE_HTML>;
+		span[ESCAPE_ATTR] = escape_span_sse2<ESCAPE_ATTR>;
+		span[ESCAPE_URL] = escape_span_sse2<ESCAPE_URL>;
+		span[ESCAPE_JS] = escape_span_sse2<ESCAPE_JS>;
+		#else
+		for ( int i=ESCAPE_HTML; i<=ESCAPE_JS; ++i )
+			span[i] = NULL;
+		#endif
+	}
+};
+
+// 转义一个字符
+// \return 转义结果长度
+static size_t escape_char( const unsigned char c, const escape_mode mode, char *buf ) {
+	const char hex[] = "0123456789ABCDEF";
+	switch ( mode ) {
+		case ESCAPE_URL:
+			buf[0] = '%';
+			buf[1] = hex[c>>4];
+			buf[2] = hex[c&0xf];
+			return 3;
+
+		case ESCAPE_JS:
+			buf[0] = '\\';
+			if ( c == '\\' ) {
+				buf[1] = '\\';
+				return 2;
+			}
+			buf[1] = 'x';
+			buf[2] = hex[c>>4];
+			buf[3] = hex[c&0xf];
+			return 4;
+
+		default:
+			switch ( c ) {
+				case '&':	memcpy( buf, "&amp;", 5 );	return 5;
+				case '<':	memcpy( buf, "&lt;", 4 );	return 4;
+				case '>':	memcpy( buf, "&gt;", 4 );	return 4;
+				case '"':	memcpy( buf, "&quot;", 6 );	return 6;
+				case '\'':	memcpy( buf, "&#39;", 5 );	return 5;
+				default:	return snprintf( buf, 8, "&#%d;", c );
+			}
+	}
+}
+
+/// \ingroup waEncode
+/// \fn size_t escape_span( const char *source, const size_t length, const escape_mode mode )
+/// 不需要转义的前缀长度
+/// x86-64下使用SSE2每次检查16字节,CPU支持AVX2时每次检查32字节
+/// \param source 原字符串
+/// \param length 原字符串长度
+/// \param mode 转义方式
+/// \return 第一个需要转义的字符位置,不需要转义时为 length
+size_t escape_span( const char *source, const size_t length, const escape_mode mode ) {
+	if ( mode == ESCAPE_NONE )
+		return length;
+	static const escape_kernels kernels;
+	if ( kernels.span[mode] != NULL )
+		return kernels.span[mode]( source, length );
+	return escape_span_scalar( escape_table().special[mode], source, length );
+}
+
+/// \ingroup waEncode
+/// \fn size_t escape_write( ostream &output, const char *source, const size_t length, const escape_mode mode )
+/// 转义并输出
+/// 不需要转义的部分直接输出,不复制
+/// \param output 输出流
+/// \param source 原字符串
+/// \param length 原字符串长度
+/// \param mode 转义方式
+/// \return 输出长度
+size_t escape_write( ostream &output, const char *source, const size_t length, 
+	const escape_mode mode ) 
+{
+	char buf[8];
+	size_t pos = 0;
+	size_t written = length;
+	while ( pos < length ) {
+		size_t clean = escape_span( source+pos, length-pos, mode );
+		if ( clean > 0 )
+			output.write( source+pos, clean );
+		pos += clean;
+		if ( pos < length ) {
+			size_t len = escape_char( source[pos], mode, buf );
+			output.write( buf, len );
+			written += len-1;
+			++pos;
+		}
+	}
+	return written;
+}
+
+/// \ingroup waEncode
+/// \fn string escape_string( const string &source, const escape_mode mode )
+/// 转义字符串
+/// \param source 原字符串
+/// \param mode 转义方式,默认为 ESCAPE_HTML
+/// \return 转义结果
+string escape_string( const string &source, const escape_mode mode ) {
+	const char *data = source.data();
+	size_t length = source.length();
+	size_t pos = escape_span( data, length, mode );
+	if ( pos == length )
+		return source;
+
+	char buf[8];
+	string res;
+	res.reserve( length + length/8 + 8 );
+	res.append( data, pos );
+	while ( pos < length ) {
+		res.append( buf, escape_char(data[pos],mode,buf) );
+		++pos;
+		size_t clean = escape_span( data+pos, length-pos, mode );
+		res.append( data+pos, clean );
+		pos += clean;
+	}
+	return res;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BASE64编码
 
 //*********************************************************************
 //* C_Base64 - a simple base64 encoder and decoder.
@@ -259,9 +527,9 @@ bool Base64::isPrintable(const string& s) {
 ////////////////////////////////////////////////////////////////////////////////
 /// \ingroup waEncode
 /// \fn string base64_encode( const string &source )
-/// MIME Base64
-/// \param source ԭַ
-/// \return ɹر,򷵻ؿַ
+/// MIME Base64编码
+/// \param source 原字符串
+/// \return 成功返回编码结果,否则返回空字符串
 string base64_encode( const string &source ) {
 	Base64 b64;
 	return b64.encode( source );
@@ -269,9 +537,9 @@ string base64_encode( const string &source ) {
 
 /// \ingroup waEncode
 /// \fn string base64_decode( const string &source )
-/// MIME Base64
-/// \param source BASE64ַ
-/// \return ɹؽ,򷵻ؿַ
+/// MIME Base64解码
+/// \param source BASE64编码字符串
+/// \return 成功返回解码结果,否则返回空字符串
 string base64_decode( const string &source ) {
 	Base64 b64;
 	return b64.decode( source );
@@ -815,9 +1083,9 @@ inline void MD5::II(uint4& a, uint4 b, uint4 c, uint4 d, uint4 x,
 ////////////////////////////////////////////////////////////////////////////////
 /// \ingroup waEncode
 /// \fn string md5_encode( const string &source )
-/// MD5
-/// \param source MD5ַ
-/// \return 
+/// MD5解码
+/// \param source MD5编码字符串
+/// \return 解码结果
 string md5_encode( const string &source ) {
 	char *buffer = NULL;
 	size_t len = source.length();
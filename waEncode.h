@@ -1,30 +1,54 @@
 /// \file waEncode.h
-/// ,ӽܺͷļ
-/// ַBASE64URIMD5뺯
+/// 编码,加解密函数头文件
+/// 字符串BASE64、URI、MD5编码函数,HTML、URL、JavaScript输出转义函数
    
 #ifndef _WEBAPPLIB_ENCODE_H_
 #define _WEBAPPLIB_ENCODE_H_ 
 
 #include <string>
+#include <ostream>
 
 using namespace std;
 
 /// Web Application Library namaspace
 namespace webapp {
 
-/// URI
+/// URI编码
 string uri_encode( const string &source );
-/// URI
+/// URI解码
 string uri_decode( const string &source );
 
-/// ַMIME BASE64
+/// 字符串MIME BASE64编码
 string base64_encode( const string &source );
-/// ַMIME BASE64
+/// 字符串MIME BASE64解码
 string base64_decode( const string &source );
 
-/// MD5
+/// MD5编码
 string md5_encode( const string &source );
 
+/// \ingroup waEncode
+/// \enum escape_mode 输出转义方式
+enum escape_mode {
+	/// 不转义
+	ESCAPE_NONE,
+	/// HTML正文,转义 & < > " '
+	ESCAPE_HTML,
+	/// HTML属性值,另转义 ` = 及空白、控制字符,可用于不带引号的属性值
+	ESCAPE_ATTR,
+	/// URL参数,除 A-Z a-z 0-9 - _ . ~ 外均转义为 %XX
+	ESCAPE_URL,
+	/// JavaScript字符串,转义 \ ' " ` < > & = / 及控制字符
+	ESCAPE_JS
+};
+
+/// 不需要转义的前缀长度
+size_t escape_span( const char *source, const size_t length, const escape_mode mode );
+/// 转义并输出
+size_t escape_write( ostream &output, const char *source, const size_t length, 
+	const escape_mode mode );
+/// 转义字符串
+string escape_string( const string &source, const escape_mode mode = ESCAPE_HTML );
+
 } // namespace
 
 #endif //_WEBAPPLIB_ENCODE_H_
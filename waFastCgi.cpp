@@ -0,0 +1,518 @@
+/// \file waFastCgi.cpp
+/// FastCgi类实现文件
+
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "waFastCgi.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+// FastCGI协议定义
+const int FCGI_VERSION_1			= 1;
+const int FCGI_HEADER_LEN			= 8;
+const size_t FCGI_MAX_CONTENT		= 65535;
+
+// 记录类型
+const int FCGI_BEGIN_REQUEST		= 1;
+const int FCGI_ABORT_REQUEST		= 2;
+const int FCGI_END_REQUEST			= 3;
+const int FCGI_PARAMS				= 4;
+const int FCGI_STDIN				= 5;
+const int FCGI_STDOUT				= 6;
+const int FCGI_GET_VALUES			= 9;
+const int FCGI_GET_VALUES_RESULT	= 10;
+const int FCGI_UNKNOWN_TYPE			= 11;
+
+// FCGI_BEGIN_REQUEST 参数
+const int FCGI_KEEP_CONN			= 1;
+const int FCGI_RESPONDER			= 1;
+
+// FCGI_END_REQUEST 协议状态
+const int FCGI_REQUEST_COMPLETE		= 0;
+const int FCGI_CANT_MPX_CONN		= 1;
+const int FCGI_UNKNOWN_ROLE			= 3;
+
+// 单次发送最大数据块数量
+#ifdef IOV_MAX
+const int FCGI_IOV_MAX				= IOV_MAX;
+#else
+const int FCGI_IOV_MAX				= 16;
+#endif
+
+#ifdef MSG_NOSIGNAL
+const int FCGI_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int FCGI_SEND_FLAGS = 0;
+#endif
+
+// 读取指定长度数据
+static bool read_full( const int fd, char *buf, size_t len ) {
+	while ( len > 0 ) {
+		ssize_t n = ::read( fd, buf, len );
+		if ( n < 0 && errno == EINTR )
+			continue;
+		if ( n <= 0 )
+			return false;
+		buf += n;
+		len -= n;
+	}
+	return true;
+}
+
+// 发送指定长度数据
+static bool write_full( const int fd, const char *buf, size_t len ) {
+	while ( len > 0 ) {
+		ssize_t n = ::send( fd, buf, len, FCGI_SEND_FLAGS );
+		if ( n < 0 && errno == EINTR )
+			continue;
+		if ( n <= 0 )
+			return false;
+		buf += n;
+		len -= n;
+	}
+	return true;
+}
+
+// 批量发送数据块
+static bool writev_full( const int fd, struct iovec *iov, int iovcnt ) {
+	while ( iovcnt > 0 ) {
+		struct msghdr msg;
+		memset( &msg, 0, sizeof(msg) );
+		msg.msg_iov = iov;
+		msg.msg_iovlen = min( iovcnt, FCGI_IOV_MAX );
+
+		ssize_t n = ::sendmsg( fd, &msg, FCGI_SEND_FLAGS );
+		if ( n < 0 && errno == EINTR )
+			continue;
+		if ( n < 0 )
+			return false;
+
+		// skip sent data
+		while ( iovcnt>0 && static_cast<size_t>(n)>=iov->iov_len ) {
+			n -= iov->iov_len;
+			++iov;
+			--iovcnt;
+		}
+		if ( iovcnt > 0 ) {
+			iov->iov_base = static_cast<char*>( iov->iov_base ) + n;
+			iov->iov_len -= n;
+		}
+	}
+	return true;
+}
+
+// 填充记录头
+static void make_header( unsigned char *header, const int type, const int reqid,
+	const size_t len )
+{
+	header[0] = FCGI_VERSION_1;
+	header[1] = type;
+	header[2] = ( reqid>>8 ) & 0xff;
+	header[3] = reqid & 0xff;
+	header[4] = ( len>>8 ) & 0xff;
+	header[5] = len & 0xff;
+	header[6] = 0;
+	header[7] = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// FastCgi
+
+/// 构造函数
+/// 检查监听socket,若进程不是由FastCGI方式启动则运行于普通CGI模式
+/// \param listen_fd 监听socket,默认为0即WEB服务器传入的FCGI_LISTENSOCK_FILENO
+FastCgi::FastCgi( const int listen_fd ):
+_listen(listen_fd), _conn(-1), _reqid(0), _keepconn(false),
+_cgi(false), _accepted(false), _stopped(false)
+{
+	// FastCGI方式启动时监听socket未连接,getpeername()返回ENOTCONN
+	struct sockaddr_storage addr;
+	socklen_t len = sizeof( addr );
+	if ( getpeername(_listen,(struct sockaddr*)&addr,&len)==0 || errno!=ENOTCONN )
+		_cgi = true;
+
+	_response = new Response( FastCgi::stdout_writer, this );
+}
+
+/// 析构函数
+/// 结束未完成的请求
+FastCgi::~FastCgi() {
+	this->finish();
+	this->close_conn();
+	delete _response;
+}
+
+/// 结束上一个请求并等待接收下一个请求
+/// 接收请求后 get_env(),Cgi,Cookie 读取该请求的数据,Response::current() 及 cout 输出至该请求
+/// \retval true 接收到新请求
+/// \retval false 监听socket出错,已调用 stop() 或者普通CGI模式下请求已处理
+bool FastCgi::accept() {
+	// CGI mode, only one request
+	if ( _cgi ) {
+		if ( _accepted )
+			return false;
+		_accepted = true;
+		return true;
+	}
+
+	// finish last request
+	this->finish();
+
+	while ( true ) {
+		if ( _stopped ) {
+			this->close_conn();
+			return false;
+		}
+
+		// wait for new connection
+		if ( _conn < 0 ) {
+			_conn = ::accept( _listen, NULL, NULL );
+			if ( _conn < 0 ) {
+				if ( errno == EINTR )
+					continue;
+				return false;
+			}
+		}
+
+		// read request
+		if ( this->read_request() )
+			break;
+		this->close_conn();
+	}
+
+	// redirect request
+	set_cgi_request( &_env, &_input );
+	Response::current();
+	_response->reset();
+	Response::set_current( _response );
+	return true;
+}
+
+/// 结束当前请求
+/// 发送未输出的内容及FCGI_END_REQUEST记录,恢复输出至stdout
+/// \param status 请求返回状态,默认为0
+void FastCgi::finish( const int status ) {
+	if ( _reqid == 0 )
+		return;
+
+	// flush and restore output
+	bool ok = _response->finish();
+	Response::set_current( NULL );
+	set_cgi_request( NULL, NULL );
+
+	// end request
+	ok = ok && this->write_record( FCGI_STDOUT, _reqid, NULL, 0 )
+		&& this->end_request( _reqid, status, FCGI_REQUEST_COMPLETE );
+	_reqid = 0;
+	_env.clear();
+	_input.clear();
+
+	if ( !ok || !_keepconn )
+		this->close_conn();
+}
+
+/// 停止接收请求
+/// 可在信号处理函数中调用,当前请求结束后 accept() 返回false,
+/// 正在等待请求时立即返回false
+void FastCgi::stop() {
+	_stopped = true;
+	// wake up blocking read on kept connection
+	if ( _conn >= 0 )
+		shutdown( _conn, SHUT_RD );
+}
+
+/// 读取请求参数及输入数据
+/// 不支持同一连接上的多路复用请求
+/// \retval true 读取成功
+/// \retval false 连接出错或已关闭
+bool FastCgi::read_request() {
+	_reqid = 0;
+	_env.clear();
+	_input.clear();
+
+	string params;
+	string content;
+	bool params_done = false;
+	bool stdin_done = false;
+	int type, reqid;
+
+	while ( !(params_done && stdin_done) ) {
+		if ( !this->read_record(type,reqid,content) )
+			return false;
+
+		// management record
+		if ( reqid == 0 ) {
+			this->management( type, content );
+			continue;
+		}
+
+		switch ( type ) {
+			case FCGI_BEGIN_REQUEST:
+				// roleB1 roleB0 flags reserved[5]
+				if ( content.length() < 8 )
+					return false;
+				if ( _reqid != 0 ) {
+					// multiplexed request
+					this->end_request( reqid, 0, FCGI_CANT_MPX_CONN );
+				} else if ( ((unsigned char)content[0]<<8|(unsigned char)content[1]) != FCGI_RESPONDER ) {
+					// only responder role supported
+					this->end_request( reqid, 0, FCGI_UNKNOWN_ROLE );
+					if ( !(content[2]&FCGI_KEEP_CONN) )
+						return false;
+				} else {
+					_reqid = reqid;
+					_keepconn = ( content[2]&FCGI_KEEP_CONN ) ? true : false;
+				}
+				break;
+
+			case FCGI_ABORT_REQUEST:
+				if ( reqid == _reqid ) {
+					this->end_request( reqid, 0, FCGI_REQUEST_COMPLETE );
+					if ( !_keepconn )
+						return false;
+					_reqid = 0;
+					params.clear();
+					_env.clear();
+					_input.clear();
+					params_done = stdin_done = false;
+				}
+				break;
+
+			case FCGI_PARAMS:
+				if ( reqid == _reqid ) {
+					if ( content.length() == 0 ) {
+						this->parse_params( params, _env );
+						params_done = true;
+					} else {
+						params += content;
+					}
+				}
+				break;
+
+			case FCGI_STDIN:
+				if ( reqid == _reqid ) {
+					if ( content.length() == 0 )
+						stdin_done = true;
+					else
+						_input += content;
+				}
+				break;
+
+			default:
+				// FCGI_DATA etc. ignored
+				break;
+		}
+	}
+
+	return true;
+}
+
+/// 读取FastCGI记录
+/// \param type 记录类型
+/// \param reqid 请求ID
+/// \param content 记录内容
+/// \retval true 读取成功
+/// \retval false 连接出错或已关闭
+bool FastCgi::read_record( int &type, int &reqid, string &content ) {
+	unsigned char header[FCGI_HEADER_LEN];
+	if ( !read_full(_conn,(char*)header,FCGI_HEADER_LEN) )
+		return false;
+	if ( header[0] != FCGI_VERSION_1 )
+		return false;
+
+	type = header[1];
+	reqid = ( header[2]<<8 ) | header[3];
+	size_t len = ( header[4]<<8 ) | header[5];
+	size_t padding = header[6];
+
+	content.resize( len+padding );
+	if ( len+padding>0 && !read_full(_conn,&content[0],len+padding) )
+		return false;
+	content.resize( len );
+	return true;
+}
+
+/// 发送FastCGI记录
+/// 内容超过单条记录长度限制时自动分为多条记录
+/// \param type 记录类型
+/// \param reqid 请求ID
+/// \param content 记录内容
+/// \param len 记录内容长度,为0时发送空记录
+/// \retval true 发送成功
+/// \retval false 连接出错
+bool FastCgi::write_record( const int type, const int reqid,
+	const char *content, const size_t len )
+{
+	if ( _conn < 0 )
+		return false;
+
+	size_t sent = 0;
+	do {
+		size_t n = len - sent;
+		if ( n > FCGI_MAX_CONTENT )
+			n = FCGI_MAX_CONTENT;
+
+		unsigned char header[FCGI_HEADER_LEN];
+		make_header( header, type, reqid, n );
+
+		if ( !write_full(_conn,(const char*)header,FCGI_HEADER_LEN) )
+			return false;
+		if ( n>0 && !write_full(_conn,content+sent,n) )
+			return false;
+		sent += n;
+	} while ( sent < len );
+
+	return true;
+}
+
+/// 发送FCGI_STDOUT记录
+/// 每个数据块按单条记录长度限制分为多条记录,全部记录以一次 sendmsg() 发送
+/// \param iov 数据块列表
+/// \param iovcnt 数据块数量
+/// \retval true 发送成功
+/// \retval false 无当前请求或连接出错
+bool FastCgi::write_stdout( const struct iovec *iov, const int iovcnt ) {
+	if ( _conn<0 || _reqid==0 )
+		return false;
+
+	size_t records = 0;
+	for ( int i=0; i<iovcnt; ++i )
+		records += ( iov[i].iov_len+FCGI_MAX_CONTENT-1 ) / FCGI_MAX_CONTENT;
+	if ( records == 0 )
+		return true;
+
+	vector<unsigned char> headers( records*FCGI_HEADER_LEN );
+	vector<struct iovec> out;
+	out.reserve( records*2 );
+
+	unsigned char *header = &headers[0];
+	for ( int i=0; i<iovcnt; ++i ) {
+		char *data = static_cast<char*>( iov[i].iov_base );
+		for ( size_t sent=0; sent<iov[i].iov_len; ) {
+			size_t n = min( iov[i].iov_len-sent, FCGI_MAX_CONTENT );
+			make_header( header, FCGI_STDOUT, _reqid, n );
+
+			struct iovec item;
+			item.iov_base = header;
+			item.iov_len = FCGI_HEADER_LEN;
+			out.push_back( item );
+			item.iov_base = data + sent;
+			item.iov_len = n;
+			out.push_back( item );
+
+			header += FCGI_HEADER_LEN;
+			sent += n;
+		}
+	}
+
+	return writev_full( _conn, &out[0], out.size() );
+}
+
+/// Response输出函数
+/// \param iov 数据块列表
+/// \param iovcnt 数据块数量
+/// \param arg FastCgi对象
+/// \retval true 发送成功
+/// \retval false 失败
+bool FastCgi::stdout_writer( const struct iovec *iov, const int iovcnt, void *arg ) {
+	return static_cast<FastCgi*>( arg )->write_stdout( iov, iovcnt );
+}
+
+/// 发送FCGI_END_REQUEST记录
+/// \param reqid 请求ID
+/// \param status 应用返回状态
+/// \param protocol 协议状态
+/// \retval true 发送成功
+/// \retval false 连接出错
+bool FastCgi::end_request( const int reqid, const int status, const int protocol ) {
+	char body[8];
+	body[0] = ( status>>24 ) & 0xff;
+	body[1] = ( status>>16 ) & 0xff;
+	body[2] = ( status>>8 ) & 0xff;
+	body[3] = status & 0xff;
+	body[4] = protocol;
+	body[5] = body[6] = body[7] = 0;
+	return this->write_record( FCGI_END_REQUEST, reqid, body, 8 );
+}
+
+/// 回应管理记录
+/// \param type 记录类型
+/// \param content 记录内容
+void FastCgi::management( const int type, const string &content ) {
+	if ( type == FCGI_GET_VALUES ) {
+		// FCGI_MAX_CONNS,FCGI_MAX_REQS,FCGI_MPXS_CONNS
+		CgiEnv query;
+		this->parse_params( content, query );
+
+		string result;
+		for ( CgiEnv::const_iterator i=query.begin(); i!=query.end(); ++i ) {
+			string value;
+			if ( i->first=="FCGI_MAX_CONNS" || i->first=="FCGI_MAX_REQS" )
+				value = "1";
+			else if ( i->first == "FCGI_MPXS_CONNS" )
+				value = "0";
+			else
+				continue;
+			result += (char)i->first.length();
+			result += (char)value.length();
+			result += i->first + value;
+		}
+		this->write_record( FCGI_GET_VALUES_RESULT, 0, result.c_str(), result.length() );
+	} else {
+		// unknown management record
+		char body[8] = {0};
+		body[0] = type;
+		this->write_record( FCGI_UNKNOWN_TYPE, 0, body, 8 );
+	}
+}
+
+/// 解析FastCGI名称-值列表
+/// \param buf FCGI_PARAMS记录内容
+/// \param params 解析结果
+void FastCgi::parse_params( const string &buf, CgiEnv &params ) {
+	size_t pos = 0;
+	size_t lens[2];
+
+	while ( pos < buf.length() ) {
+		// name length and value length, 1 or 4 bytes
+		for ( int i=0; i<2; ++i ) {
+			if ( pos >= buf.length() )
+				return;
+			unsigned char b = buf[pos];
+			if ( b & 0x80 ) {
+				if ( pos+4 > buf.length() )
+					return;
+				lens[i] = ( (b&0x7f)<<24 ) | ( (unsigned char)buf[pos+1]<<16 )
+					| ( (unsigned char)buf[pos+2]<<8 ) | (unsigned char)buf[pos+3];
+				pos += 4;
+			} else {
+				lens[i] = b;
+				pos += 1;
+			}
+		}
+
+		if ( pos+lens[0]+lens[1] > buf.length() )
+			return;
+		params[buf.substr(pos,lens[0])] = buf.substr( pos+lens[0], lens[1] );
+		pos += lens[0] + lens[1];
+	}
+}
+
+/// 关闭当前连接
+void FastCgi::close_conn() {
+	if ( _conn >= 0 ) {
+		::close( _conn );
+		_conn = -1;
+	}
+}
+
+} // namespace
@@ -0,0 +1,107 @@
+/// \file waFastCgi.h
+/// webapp::FastCgi类头文件
+/// FastCGI常驻进程模式请求处理类
+/// 依赖于 webapp::Cgi, webapp::Response
+
+#ifndef _WEBAPPLIB_FASTCGI_H_
+#define _WEBAPPLIB_FASTCGI_H_
+
+#include <string>
+#include <map>
+#include <iostream>
+#include "waCgi.h"
+#include "waResponse.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+/// \defgroup waFastCgi waFastCgi相关数据类型与全局函数
+
+/// \ingroup waFastCgi
+/// FastCGI监听socket默认文件描述符,由WEB服务器启动进程时传入
+const int FCGI_LISTENSOCK_FILENO = 0;
+
+/// FastCGI请求处理类
+/// 进程常驻,循环调用 FastCgi::accept() 接收请求,
+/// 请求期间 get_env(),Cgi,Cookie 读取当前请求数据,Response::current() 及 cout 输出至当前请求
+class FastCgi {
+	public:
+
+	/// 构造函数
+	FastCgi( const int listen_fd = FCGI_LISTENSOCK_FILENO );
+
+	/// 析构函数
+	virtual ~FastCgi();
+
+	/// 结束上一个请求并等待接收下一个请求
+	bool accept();
+	/// 结束当前请求
+	void finish( const int status = 0 );
+	/// 停止接收请求
+	void stop();
+
+	/// 是否运行于普通CGI模式
+	/// \retval true 进程不是由FastCGI方式启动,accept()只返回一次请求
+	/// \retval false FastCGI模式
+	inline bool is_cgi() const {
+		return _cgi;
+	}
+
+	/// 返回当前请求环境变量列表
+	/// \return 当前请求环境变量列表,普通CGI模式下为空
+	inline const CgiEnv& env() const {
+		return _env;
+	}
+
+	/// 返回当前请求输入数据
+	/// \return 当前请求FCGI_STDIN数据,普通CGI模式下为空
+	inline const string& input() const {
+		return _input;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	private:
+
+	/// 读取请求参数及输入数据
+	bool read_request();
+	/// 读取FastCGI记录
+	bool read_record( int &type, int &reqid, string &content );
+	/// 发送FastCGI记录
+	bool write_record( const int type, const int reqid,
+		const char *content, const size_t len );
+	/// 发送FCGI_STDOUT记录
+	bool write_stdout( const struct iovec *iov, const int iovcnt );
+	/// Response输出函数
+	static bool stdout_writer( const struct iovec *iov, const int iovcnt, void *arg );
+	/// 发送FCGI_END_REQUEST记录
+	bool end_request( const int reqid, const int status, const int protocol );
+	/// 回应管理记录
+	void management( const int type, const string &content );
+	/// 解析FastCGI名称-值列表
+	void parse_params( const string &buf, CgiEnv &params );
+	/// 关闭当前连接
+	void close_conn();
+
+	/// 禁止调用拷贝构造函数
+	FastCgi( FastCgi &copy );
+	/// 禁止调用拷贝赋值操作
+	FastCgi& operator = ( const FastCgi& copy );
+
+	int _listen;				// 监听socket
+	int _conn;					// 当前连接
+	int _reqid;					// 当前请求ID,0为无请求
+	bool _keepconn;				// 请求结束后是否保持连接
+	bool _cgi;					// 是否为普通CGI模式
+	bool _accepted;				// 普通CGI模式下是否已返回请求
+	volatile bool _stopped;		// 是否已停止接收请求
+
+	CgiEnv _env;				// 当前请求环境变量
+	string _input;				// 当前请求输入数据
+	Response *_response;		// 当前请求回应对象,输出为FCGI_STDOUT记录
+};
+
+} // namespace
+
+#endif //_WEBAPPLIB_FASTCGI_H_
@@ -1,5 +1,5 @@
 /// \file waFileSystem.cpp
-/// ļʵļ
+/// 文件操作函数实现文件
 
 #include <cstdio>
 #include <unistd.h>
@@ -14,14 +14,14 @@ using namespace std;
 /// Web Application Library namaspace
 namespace webapp {
 
-/// \defgroup waFileSystem waFileSystemļ
+/// \defgroup waFileSystem waFileSystem文件操作函数库
 	
 /// \ingroup waFileSystem
 /// \fn bool file_exist( const string &file )
-/// ļĿ¼Ƿ
-/// \param file ļ·
-/// \retval true ļ
-/// \retval false 
+/// 文件或者目录是否存在
+/// \param file 文件路径名
+/// \retval true 文件存在
+/// \retval false 不存在
 bool file_exist( const string &file ) {
 	if ( access(file.c_str(),F_OK) == 0 )
 		return true;
@@ -31,10 +31,10 @@ bool file_exist( const string &file ) {
 
 /// \ingroup waFileSystem
 /// \fn bool is_link( const string &file )
-/// ļǷΪ
-/// \param file ļ·
-/// \retval true ļΪ
-/// \retval false ڻ߲Ƿ
+/// 文件是否为链接
+/// \param file 文件路径名
+/// \retval true 文件存在且为符号链接
+/// \retval false 不存在或者不是符号链接
 bool is_link( const string &file ) {
 	struct stat statbuf;
 	
@@ -47,10 +47,10 @@ bool is_link( const string &file ) {
 
 /// \ingroup waFileSystem
 /// \fn bool is_dir( const string &file )
-/// ǷΪĿ¼
-/// \param dile Ŀ¼·
-/// \retval true Ŀ¼
-/// \retval false ڻ߲Ŀ¼
+/// 是否为目录
+/// \param dile 目录路径名
+/// \retval true 目录存在
+/// \retval false 不存在或者不是目录
 bool is_dir( const string &file ) {
 	struct stat statbuf;
 	
@@ -63,11 +63,11 @@ bool is_dir( const string &file ) {
 
 /// \ingroup waFileSystem
 /// \fn bool make_link( const string &srcfile, const string &destfile )
-/// ,ļ벻
-/// \param srcfile ԭļ
-/// \param destfile 
-/// \retval true ɹ
-/// \retval false ɹ
+/// 建立链接,新链接名文件必须不存在
+/// \param srcfile 原文件名
+/// \param destfile 新链接名
+/// \retval true 操作成功
+/// \retval false 不成功
 bool make_link( const string &srcfile, const string &destfile ) {
 	if ( symlink(srcfile.c_str(),destfile.c_str()) == 0 )
 		return true;
@@ -77,9 +77,9 @@ bool make_link( const string &srcfile, const string &destfile ) {
 
 /// \ingroup waFileSystem
 /// \fn size_t file_size( const string &file )
-/// ȡļС
-/// \param file ļ·
-/// \return ļ򷵻شС,򷵻-1
+/// 取得文件大小
+/// \param file 文件路径名
+/// \return 若文件存在则返回大小,否则返回-1
 size_t file_size( const string &file ) {
 	struct stat statbuf;
 	
@@ -91,9 +91,9 @@ size_t file_size( const string &file ) {
 
 /// \ingroup waFileSystem
 /// \fn time_t file_time( const string &file )
-/// ȡļʱ
-/// \param file ļ·
-/// \return ļ򷵻ʱ,򷵻-1
+/// 取得文件更改时间
+/// \param file 文件路径名
+/// \return 若文件存在则返回其最后更改时间,否则返回-1
 time_t file_time( const string &file ) {
 	struct stat statbuf;
 	
@@ -105,9 +105,9 @@ time_t file_time( const string &file ) {
 
 /// \ingroup waFileSystem
 /// \fn string file_path( const string &file )
-/// ȡļ·
-/// \param file ļ·
-/// \return ȡļ·򷵻,򷵻ؿַ
+/// 取得文件路径
+/// \param file 文件路径名
+/// \return 若能取得文件路径则返回,否则返回空字符串
 string file_path( const string &file ) {
 	size_t p;
 	if ( (p=file.rfind("/")) != file.npos )
@@ -119,9 +119,9 @@ string file_path( const string &file ) {
 
 /// \ingroup waFileSystem
 /// \fn string file_name( const string &file )
-/// ȡļ
-/// \param file ļ·
-/// \return ȡļ򷵻,򷵻ԭļ·
+/// 取得文件名称
+/// \param file 文件路径名
+/// \return 若能取得文件名称则返回,否则返回原文件路径名称
 string file_name( const string &file ) {
 	size_t p;
 	if ( (p=file.rfind("/")) != file.npos )
@@ -133,11 +133,11 @@ string file_name( const string &file ) {
 
 /// \ingroup waFileSystem
 /// \fn bool rename_file( const string &oldname, const string &newname )
-/// ļĿ¼,ļԭļλͬһļϵͳ
-/// \param oldname ԭļ
-/// \param newname ļ
-/// \retval true ɹ
-/// \retval false ʧ
+/// 文件或者目录改名,新文件名必须与原文件名位于同一文件系统
+/// \param oldname 原文件名
+/// \param newname 新文件名
+/// \retval true 操作成功
+/// \retval false 失败
 bool rename_file( const string &oldname, const string &newname ) {
 	if ( rename(oldname.c_str(),newname.c_str()) != -1 )
 		return true;
@@ -147,11 +147,11 @@ bool rename_file( const string &oldname, const string &newname ) {
 
 /// \ingroup waFileSystem
 /// \fn bool copy_file( const string &srcfile, const string &destfile )
-/// ļ	
-/// \param srcfile ԭļ
-/// \param destfile Ŀļ,ļΪ0666
-/// \retval true ɹ
-/// \retval false ʧ
+/// 拷贝文件	
+/// \param srcfile 原文件名
+/// \param destfile 目的文件名,文件属性为0666
+/// \retval true 操作成功
+/// \retval false 失败
 bool copy_file( const string &srcfile, const string &destfile ) {
 	FILE *src=NULL, *dest=NULL;
 	if ( (src=fopen(srcfile.c_str(),"rb")) == NULL ) {
@@ -186,10 +186,10 @@ bool copy_file( const string &srcfile, const string &destfile ) {
 
 /// \ingroup waFileSystem
 /// \fn bool delete_file( const string &file )
-/// ɾļ
-/// \param file ļ·
-/// \retval true ɾɹ
-/// \retval false ļڻɾʧ
+/// 删除文件
+/// \param file 文件路径名
+/// \retval true 删除成功
+/// \retval false 文件不存在或者删除失败
 bool delete_file( const string &file ) {
 	if ( remove(file.c_str()) == 0 )
 		return true;
@@ -199,11 +199,11 @@ bool delete_file( const string &file ) {
 
 /// \ingroup waFileSystem
 /// \fn bool move_file( const string &srcfile, const string &destfile )
-/// ƶļ
-/// \param srcfile ԭļ
-/// \param destfile ļ
-/// \retval true ɹ
-/// \retval false ʧ
+/// 移动文件
+/// \param srcfile 原文件名
+/// \param destfile 新文件名
+/// \retval true 操作成功
+/// \retval false 失败
 bool move_file( const string &srcfile, const string &destfile ) {
 	if ( rename_file(srcfile,destfile) )
 		return true;
@@ -219,10 +219,10 @@ bool move_file( const string &srcfile, const string &destfile ) {
 
 /// \ingroup waFileSystem
 /// \fn vector<string> dir_files( const string &dir )
-/// Ŀ¼ļб
-/// \param dir ΪĿ¼·
-/// \return ؽΪļĿ¼б,Ŀ¼ĵһַΪ '/',
-/// ؽвǰһĿ¼ "/.", "/.."
+/// 返回目录文件列表
+/// \param dir 参数为目录路径名
+/// \return 返回结果为文件及子目录列表,子目录的第一个字符为 '/',
+/// 返回结果中不包括代表当前及上一级目录的 "/.", "/.."
 vector<string> dir_files( const string &dir ) {
 	vector<string> files;
 	string file;
@@ -246,12 +246,12 @@ vector<string> dir_files( const string &dir ) {
 
 /// \ingroup waFileSystem
 /// \fn bool make_dir( const string &dir, const size_t mode )
-/// Ŀ¼
-/// \param dir ҪĿ¼,ϲĿ¼Զ
-/// \param mode Ŀ¼Ȩ,ĬΪS_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH(0755)
-/// ɹtrue, 򷵻false.
-/// \retval true ɹ
-/// \retval false ʧ
+/// 建立目录
+/// \param dir 要创建的目录,若上层目录不存在则自动创建
+/// \param mode 创建目录权限,默认为S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH(0755)
+/// 成功返回true, 否则返回false.
+/// \retval true 操作成功
+/// \retval false 失败
 bool make_dir( const string &dir, const mode_t mode ) {
 	// check
 	size_t len = dir.length();
@@ -282,17 +282,17 @@ bool make_dir( const string &dir, const mode_t mode ) {
 
 /// \ingroup waFileSystem
 /// \fn bool copy_dir( const string &srcdir, const string &destdir )
-/// Ŀ¼,Ŀ¼ʱΪݹ
-/// \param srcdir ԭĿ¼
-/// \param destdir ĿĿ¼
-/// \retval true ɹ
-/// \retval false ʧ
+/// 拷贝目录,拷贝子目录时为递归调用
+/// \param srcdir 原目录
+/// \param destdir 目的目录
+/// \retval true 操作成功
+/// \retval false 失败
 bool copy_dir( const string &srcdir, const string &destdir ) {	
 	vector<string> files = dir_files( srcdir );
 	string from;
 	string to;
 	
-	// ĿĿ¼
+	// 创建目标目录
 	if ( !file_exist(destdir) )
 		make_dir( destdir );
 	
@@ -300,13 +300,13 @@ bool copy_dir( const string &srcdir, const string &destdir ) {
 		from = srcdir + "/" + files[i];
 		to = destdir + "/" + files[i];
 		
-		// Ŀ¼,ݹ
+		// 子目录,递归调用
 		if ( files[i][0] == '/' ) {
 			 if ( !copy_dir(from,to) )
 				return false;
 		}
 		
-		// ļ
+		// 文件
 		else if ( !copy_file(from,to) )
 			return false;
 	}
@@ -316,30 +316,30 @@ bool copy_dir( const string &srcdir, const string &destdir ) {
 
 /// \ingroup waFileSystem
 /// \fn bool delete_dir( const string &dir )
-/// ɾĿ¼,ɾĿ¼ʱΪݹ
-/// \param dir ҪɾĿ¼
-/// \retval true ɹ
-/// \retval false ʧ
+/// 删除目录,删除子目录时为递归调用
+/// \param dir 要删除的目录
+/// \retval true 操作成功
+/// \retval false 失败
 bool delete_dir( const string &dir ) {	
 	vector<string> files = dir_files( dir );
 	string todel;
 	
-	// ɾļ
+	// 删除文件
 	for ( size_t i=0; i<files.size(); ++i ) {
 		todel = dir + "/" + files[i];
 		
-		// Ŀ¼,ݹ
+		// 子目录,递归调用
 		if ( files[i][0] == '/' ) {
 			 if ( !delete_dir(todel) )
 				return false;
 		}
 		
-		// ļ
+		// 文件
 		else if ( !delete_file(todel) )
 			return false;
 	}
 	
-	// ɾĿ¼
+	// 删除目录
 	if ( rmdir(dir.c_str()) == 0 )
 		return true;
 
@@ -348,11 +348,11 @@ bool delete_dir( const string &dir ) {
 			
 /// \ingroup waFileSystem
 /// \fn bool move_dir( const string &srcdir, const string &destdir )
-/// ƶĿ¼
-/// \param srcdir ԭĿ¼
-/// \param destdir ĿĿ¼
-/// \retval true ɹ
-/// \retval false ʧ
+/// 移动目录
+/// \param srcdir 原目录
+/// \param destdir 目的目录
+/// \retval true 操作成功
+/// \retval false 失败
 bool move_dir( const string &srcdir, const string &destdir ) {
 	if ( rename_file(srcdir,destdir) )
 		return true;
@@ -368,9 +368,9 @@ bool move_dir( const string &srcdir, const string &destdir ) {
 
 /// \ingroup waFileSystem
 /// \fn void lock_file( int fd, const int type )
-/// ļļѱȴ
-/// \param fd ļ
-/// \param type ģʽѡF_WRLCKF_RDLCKF_UNLCK
+/// 文件句柄锁函数，若文件已被锁则阻塞并等待
+/// \param fd 文件句柄
+/// \param type 锁模式，可选F_WRLCK、F_RDLCK、F_UNLCK
 void lock_file( int fd, const int type ) {
 	struct flock lck;
 	lck.l_start = 0;
@@ -389,10 +389,10 @@ void lock_file( int fd, const int type ) {
 
 /// \ingroup waFileSystem
 /// \fn bool is_locked( int fd )
-/// жļ
-/// \param fd ļ
-/// \retval true ļѱ
-/// \retval false ļδ
+/// 判断文件句柄锁
+/// \param fd 文件句柄
+/// \retval true 文件已被锁
+/// \retval false 文件未被锁
 bool is_locked( int fd ) {
 	struct flock lck;
 	lck.l_start = 0;
@@ -410,11 +410,11 @@ bool is_locked( int fd ) {
 
 /// \ingroup waFileSystem
 /// \fn FILE* lock_open( const string &file, const char* mode, const int type )
-/// ļļѱȴ
-/// \param file ļ·
-/// \param mode ļģʽfopen()ͬͬ
-/// \param type ģʽѡF_WRLCKF_RDLCKF_UNLCK
-/// \return ļʧܷNULL
+/// 申请锁并打开文件，若文件已被锁则阻塞并等待
+/// \param file 文件路径
+/// \param mode 文件打开模式，与fopen()同参数意义相同
+/// \param type 锁模式，可选F_WRLCK、F_RDLCK、F_UNLCK
+/// \return 文件句柄，失败返回NULL
 FILE* lock_open( const string &file, const char* mode, const int type ) {
 	FILE *fp;
 	mode_t mask = umask( 0 );
@@ -1,8 +1,16 @@
 /// \file waHttpClient.cpp
-/// HTTPͻʵļ
+/// HTTP客户端类实现文件
 
 #include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <strings.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -17,88 +25,597 @@ using namespace std;
 /// Web Application Library namaspace
 namespace webapp {
 
-/// \defgroup waHttpClient waHttpClientȫֺ
+// 单次读取数据长度
+const size_t HTTPCLIENT_READ_SIZE = 16384;
+// 按Content-Length预分配回应缓冲区的长度上限
+const size_t HTTPCLIENT_MAX_RESERVE = 64*1024*1024;
 
-/// \ingroup waHttpClient
-/// \fn int tcp_request( const string &server, const int port, const string &request, string &response, const int timeout )
-/// TCPȡûӦ
-/// \param server IP
-/// \param port ˿
-/// \param request ͵TCP
-/// \param response ĻӦ
-/// \param timeout ʱʱ,λΪ,Ϊ0жϳʱ
-/// \retval 0 ִгɹ
-/// \retval 1 socketʧ
-/// \retval 2 ޷ӷ
-/// \retval 3 ʧ
-/// \retval 4 öʱʧܻӳʱ
-/// \retval 10 δ֪
-int tcp_request( const string &server, const int port, const string &request,
-	string &response, const int timeout ) 
-{
-	// init
-	struct sockaddr_in sin;	 
+#ifdef MSG_NOSIGNAL
+const int HTTPCLIENT_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int HTTPCLIENT_SEND_FLAGS = 0;
+#endif
+
+/// 连接池
+/// 以"服务器地址:端口"为索引保存空闲连接,最近放回的连接在后
+struct HttpClient::http_pool {
+	typedef struct {					// 空闲连接
+		int fd;							// 连接socket
+		time_t idle;					// 放回连接池时间
+	} http_idleconn;
+	typedef map<string,vector<http_idleconn> > http_idleconns;
+
+	pthread_mutex_t lock;				// 互斥锁
+	size_t limit;						// 每个服务器保持的空闲连接数量上限,为0则不保持连接
+	int timeout;						// 空闲连接保持时间,单位为秒
+	pid_t pid;							// 连接所属进程ID
+	size_t hits;						// 复用连接次数
+	size_t misses;						// 新建连接次数
+	size_t stales;						// 已失效而关闭的空闲连接数量
+	http_idleconns conns;				// 空闲连接列表 <服务器地址:端口,空闲连接>
+
+	http_pool():
+	limit(HTTPCLIENT_POOL_SIZE), timeout(HTTPCLIENT_POOL_IDLE), pid(getpid()),
+	hits(0), misses(0), stales(0)
+	{
+		pthread_mutex_init( &lock, NULL );
+	}
+
+	// 关闭全部空闲连接
+	void clear() {
+		for ( http_idleconns::iterator i=conns.begin(); i!=conns.end(); ++i ) {
+			for ( size_t j=0; j<i->second.size(); ++j )
+				close( i->second[j].fd );
+		}
+		conns.clear();
+	}
+
+	// fork()之后子进程不使用父进程建立的连接,只关闭子进程中的描述符
+	void check_pid() {
+		if ( pid != getpid() ) {
+			this->clear();
+			pid = getpid();
+		}
+	}
+};
+
+/// 初始化回应分帧状态
+void HttpClient::frame_init() {
+	http_frame &frame = _frame;
+	frame.scan = 0;
+	frame.head = 0;
+	frame.length = string::npos;
+	frame.chunk = string::npos;
+	frame.body = 0;
+	frame.remain = 0;
+	frame.crlf = false;
+	frame.flushed = 0;
+	frame.status = 0;
+	frame.error = ERROR_NULL;
+	frame.keepalive = false;
+}
+
+// 查找回应头结束位置
+// 返回空行之后的位置,未找到返回0
+static size_t frame_headend( const string &response, size_t &scan ) {
+	for ( ; scan<response.length(); ++scan ) {
+		if ( response[scan] == '\n' ) {
+			if ( scan>=1 && response[scan-1]=='\n' )
+				return scan+1;
+			if ( scan>=2 && response[scan-1]=='\r' && response[scan-2]=='\n' )
+				return scan+1;
+		}
+	}
+	return 0;
+}
+
+// 回应头值是否包含指定字符串,不区分大小写
+static bool frame_hasvalue( const char *value, const size_t length, const char *token ) {
+	String str( string(value,length) );
+	str.lower();
+	return ( str.find(token) != str.npos );
+}
+
+/// 分析回应头,确定回应全文长度及是否可以复用连接
+/// \param head_only 回应是否只有回应头,HEAD请求时为true
+void HttpClient::frame_parsehead( const bool head_only ) {
+	const string &response = _response;
+	http_frame &frame = _frame;
+
+	// HTTP/1.1 status_number description_string
+	size_t eol = response.find( '\n' );
+	bool http11 = ( response.compare(0,8,"HTTP/1.1") == 0 );
+	size_t sp = response.find( ' ' );
+	if ( sp < eol )
+		frame.status = atoi( response.c_str()+sp+1 );
+
+	// HTTP/1.1 默认保持连接,HTTP/1.0 默认关闭连接
+	bool keepalive = http11;
+	bool chunked = false;
+	size_t length = string::npos;
+	for ( size_t pos=eol+1; pos<frame.head; pos=eol+1 ) {
+		if ( (eol=response.find('\n',pos)) == response.npos )
+			break;
+		const char *line = response.c_str() + pos;
+		size_t len = eol - pos;
+
+		if ( len>15 && strncasecmp(line,"Content-Length:",15)==0 )
+			length = strtoul( line+15, NULL, 10 );
+		else if ( len>18 && strncasecmp(line,"Transfer-Encoding:",18)==0 )
+			chunked = frame_hasvalue( line+18, len-18, "chunked" );
+		else if ( len>11 && strncasecmp(line,"Connection:",11)==0 )
+			keepalive = frame_hasvalue( line+11, len-11, "keep-alive" ) ||
+				( http11 && !frame_hasvalue(line+11,len-11,"close") );
+	}
+
+	frame.keepalive = keepalive;
+	if ( head_only || frame.status==204 || frame.status==304 || 
+		 (frame.status>=100 && frame.status<200) ) {
+		frame.length = frame.head;
+	} else if ( chunked ) {
+		frame.chunk = frame.head;
+		frame.body = frame.head;
+	} else if ( length != string::npos ) {
+		frame.length = frame.head + length;
+		if ( _maxbody>0 && length>_maxbody ) {
+			frame.error = ERROR_RESPONSE_TOOLARGE;
+			frame.keepalive = false;
+		} else if ( length<=HTTPCLIENT_MAX_RESERVE && _writer==NULL && _bodyfd<0 ) {
+			_response.reserve( frame.length );
+		}
+	} else {
+		// 没有正文长度时读取至连接关闭
+		frame.keepalive = false;
+	}
+
+	// 101 Switching Protocols 之后不再是HTTP连接
+	if ( frame.status == 101 )
+		frame.keepalive = false;
+}
+
+/// 已读取的回应是否完整
+/// 设置了正文处理回调函数或输出文件时已读取的正文随即输出,回应中只保留回应头
+/// \param head_only 回应是否只有回应头,HEAD请求时为true
+/// \retval true 回应已读取完毕
+/// \retval false 需要继续读取,回应长度未知时读取至连接关闭,
+/// 出错时 _frame.error 为错误信息代码
+bool HttpClient::frame_response( const bool head_only ) {
+	bool done = this->frame_decode( head_only );
+	if ( _frame.head>0 && _frame.error==ERROR_NULL )
+		this->frame_flush();
+	return ( done && _frame.error==ERROR_NULL );
+}
+
+/// 连接关闭时回应是否完整
+/// 只有未指定正文长度的回应以连接关闭结束,
+/// Content-Length 或 chunked 正文未读取完毕时连接关闭为回应不完整
+/// \return 错误信息代码
+int HttpClient::frame_closed() {
+	_frame.keepalive = false;
+	if ( _response == "" )
+		return ERROR_RESPONSE_NULL;
+	if ( _frame.head>0 && _frame.length==string::npos && _frame.chunk==string::npos )
+		return ERROR_NULL;
+	return ERROR_RESPONSE_INVALID;
+}
+
+/// 分析已读取的回应
+/// 跳过"100 Continue"等中间回应,删除回应结束之后的多余数据
+/// \param head_only 回应是否只有回应头,HEAD请求时为true
+/// \retval true 回应已读取完毕
+/// \retval false 需要继续读取
+bool HttpClient::frame_decode( const bool head_only ) {
+	string &response = _response;
+	http_frame &frame = _frame;
+
+	while ( frame.head == 0 ) {
+		if ( (frame.head=frame_headend(response,frame.scan)) == 0 )
+			return false;
+		this->frame_parsehead( head_only );
+
+		if ( frame.status>=100 && frame.status<200 && frame.status!=101 ) {
+			response.erase( 0, frame.head );
+			this->frame_init();
+		}
+	}
+
+	// chunked正文在读取时原地解码,块数据依次移至已解码正文之后,
+	// 以长度为0的块及可选的trailer结束
+	while ( frame.chunk != string::npos ) {
+		if ( frame.remain > 0 ) {
+			size_t size = response.length() - frame.chunk;
+			if ( size > frame.remain )
+				size = frame.remain;
+			if ( size == 0 )
+				return false;
+			if ( frame.body != frame.chunk )
+				memmove( &response[frame.body], response.data()+frame.chunk, size );
+			frame.body += size;
+			frame.chunk += size;
+			frame.remain -= size;
+			if ( frame.remain > 0 )
+				return false;
+			frame.crlf = true;
+		}
+
+		// 块数据之后的换行
+		size_t eol = response.find( '\n', frame.chunk );
+		if ( eol == response.npos )
+			return false;
+		if ( frame.crlf ) {
+			frame.crlf = false;
+			frame.chunk = eol + 1;
+			continue;
+		}
+
+		size_t line = frame.chunk;
+		size_t size = strtoul( response.c_str()+line, NULL, 16 );
+		if ( size > response.max_size() ) {
+			// invalid chunk size
+			response.erase( frame.body );
+			frame.chunk = string::npos;
+			frame.keepalive = false;
+			return false;
+		}
+
+		frame.chunk = eol + 1;
+		if ( size > 0 ) {
+			frame.remain = size;
+		} else {
+			size_t end;
+			size_t pos = frame.chunk;
+			if ( response.compare(pos,2,HTTP_CRLF) == 0 ) {
+				end = pos + 2;
+			} else if ( response.compare(pos,1,"\n") == 0 ) {
+				end = pos + 1;
+			} else {
+				if ( (end=response.find(DOUBLE_CRLF,pos)) == response.npos ) {
+					frame.chunk = line;
+					return false;
+				}
+				end += 4;
+			}
+
+			// 删除块长度及trailer
+			if ( response.length() > end )
+				frame.keepalive = false;
+			response.erase( frame.body );
+			frame.length = frame.body;
+			frame.chunk = string::npos;
+		}
+	}
+
+	if ( frame.length==string::npos || response.length()<frame.length )
+		return false;
+	if ( response.length() > frame.length ) {
+		response.erase( frame.length );
+		frame.keepalive = false;
+	}
+	return true;
+}
+
+// 写入全部数据
+static bool write_all( const int fd, const char *data, size_t length ) {
+	while ( length > 0 ) {
+		ssize_t n = write( fd, data, length );
+		if ( n < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return false;
+		}
+		data += n;
+		length -= n;
+	}
+	return true;
+}
+
+/// 检查正文长度并输出已读取的正文
+/// 正文超过 set_max_body() 设置的上限时出错,
+/// 设置了正文处理回调函数或输出文件时输出已读取的正文并从回应中删除
+void HttpClient::frame_flush() {
+	string &response = _response;
+	http_frame &frame = _frame;
+
+	// 已读取的正文,chunked正文为已解码部分
+	size_t end = response.length();
+	if ( frame.chunk != string::npos )
+		end = frame.body;
+	else if ( frame.length!=string::npos && frame.length<end )
+		end = frame.length;
+	size_t size = end - frame.head;
+
+	if ( _maxbody>0 && frame.flushed+size>_maxbody ) {
+		frame.error = ERROR_RESPONSE_TOOLARGE;
+		frame.keepalive = false;
+		return;
+	}
+	if ( size==0 || (_writer==NULL && _bodyfd<0) )
+		return;
+
+	const char *data = response.data() + frame.head;
+	bool res = ( _writer != NULL ) ? _writer( data, size, _writerarg ) 
+		: write_all( _bodyfd, data, size );
+	if ( !res ) {
+		frame.error = ERROR_WRITE_BODY;
+		frame.keepalive = false;
+		return;
+	}
+
+	response.erase( frame.head, size );
+	frame.flushed += size;
+	if ( frame.length != string::npos )
+		frame.length -= size;
+	if ( frame.chunk != string::npos ) {
+		frame.chunk -= size;
+		frame.body -= size;
+	}
+}
+
+/// 当前时间
+/// \return 单调时钟的当前时间,单位为毫秒,不受系统时间调整影响
+long long HttpClient::now_ms() {
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (long long)ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
+
+// 超时时长由秒转换为毫秒
+static int seconds_to_ms( const int timeout ) {
+	if ( timeout <= 0 )
+		return 0;
+	return ( timeout<INT_MAX/1000 ) ? timeout*1000 : INT_MAX;
+}
+
+/// 设置socket是否非阻塞模式
+/// \param fd socket
+/// \param nonblock 是否非阻塞模式
+/// \retval true 成功
+/// \retval false 失败
+bool HttpClient::set_nonblock( const int fd, const bool nonblock ) {
+	int flags = fcntl( fd, F_GETFL, 0 );
+	if ( flags < 0 )
+		return false;
+	flags = nonblock ? ( flags|O_NONBLOCK ) : ( flags&~O_NONBLOCK );
+	return ( fcntl(fd,F_SETFL,flags) == 0 );
+}
+
+/// 等待socket可读或可写
+/// \param fd socket
+/// \param events 等待的poll事件
+/// \param deadline 截止时间,单位为毫秒,为0不判断超时
+/// \retval true 已就绪
+/// \retval false 超时或出错
+bool HttpClient::wait_fd( const int fd, const short events, const long long deadline ) {
+	while ( true ) {
+		int wait = -1;
+		if ( deadline > 0 ) {
+			long long now = HttpClient::now_ms();
+			if ( now >= deadline )
+				return false;
+			wait = static_cast<int>( deadline-now );
+		}
+
+		struct pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = events;
+		pfd.revents = 0;
+		int res = poll( &pfd, 1, wait );
+		if ( res<0 && errno==EINTR )
+			continue;
+		return ( res > 0 );
+	}
+}
+
+/// 以非阻塞模式开始连接服务器
+/// 创建非阻塞socket并发起连接,连接未完成时应等待socket可写后调用 connect_result()
+/// \param addr 服务器IP
+/// \param port 服务器端口
+/// \param fd 创建的socket,失败时为-1
+/// \param connected 是否已完成连接
+/// \return 错误信息代码
+int HttpClient::connect_start( const string &addr, const int port, int &fd, bool &connected ) {
+	struct sockaddr_in sin;
+	memset( &sin, 0, sizeof(sin) );
 	sin.sin_family = AF_INET;
 	sin.sin_port = htons( port );
-	sin.sin_addr.s_addr = inet_addr( server.c_str() );
-	
-	// create socket
-	int fd;
+	sin.sin_addr.s_addr = inet_addr( addr.c_str() );
+
+	connected = false;
 	if ( (fd=socket(AF_INET,SOCK_STREAM,0)) < 0 )
-		return 1;
+		return ERROR_CREATE_SOCKET;
+	if ( !HttpClient::set_nonblock(fd,true) ) {
+		close( fd );
+		fd = -1;
+		return ERROR_CREATE_SOCKET;
+	}
 
-	// connect
-	if ( connect(fd,(struct sockaddr*)&sin,sizeof(sin)) < 0 ) {
+	if ( connect(fd,(struct sockaddr*)&sin,sizeof(sin)) == 0 ) {
+		connected = true;
+	} else if ( errno!=EINPROGRESS && errno!=EINTR ) {
+		// 被信号中断时连接仍在进行
 		close( fd );
-		return 2;
+		fd = -1;
+		return ERROR_CONNECT_SERVER;
 	}
+	return ERROR_NULL;
+}
 
-	// send request
-	if ( send(fd,request.c_str(),request.length(),0) < 0 ) {
+/// 取得非阻塞连接的结果
+/// \param fd 已可写的socket
+/// \return 错误信息代码
+int HttpClient::connect_result( const int fd ) {
+	int err = 0;
+	socklen_t len = sizeof( err );
+	if ( getsockopt(fd,SOL_SOCKET,SO_ERROR,&err,&len)<0 || err!=0 )
+		return ERROR_CONNECT_SERVER;
+	return ERROR_NULL;
+}
+
+/// 连接服务器
+/// 以非阻塞模式连接并等待至截止时间,连接成功后socket保持非阻塞模式
+/// \param addr 服务器IP
+/// \param port 服务器端口
+/// \param deadline 截止时间,单位为毫秒,为0不判断超时
+/// \param fd 连接socket,失败时为-1
+/// \return 错误信息代码,连接超时为 ERROR_RESPONSE_TIMEDOUT
+int HttpClient::connect_server( const string &addr, const int port, const long long deadline, int &fd ) {
+	bool connected;
+	int res = HttpClient::connect_start( addr, port, fd, connected );
+	if ( res!=ERROR_NULL || connected )
+		return res;
+
+	if ( !HttpClient::wait_fd(fd,POLLOUT,deadline) )
+		res = ERROR_RESPONSE_TIMEDOUT;
+	else
+		res = HttpClient::connect_result( fd );
+
+	if ( res != ERROR_NULL ) {
 		close( fd );
-		return 3;
+		fd = -1;
+	}
+	return res;
+}
+
+/// 在非阻塞socket上发送全部数据
+/// \param fd socket
+/// \param data 发送的数据
+/// \param deadline 截止时间,单位为毫秒,为0不判断超时
+/// \return 错误信息代码,发送超时为 ERROR_RESPONSE_TIMEDOUT
+int HttpClient::send_all( const int fd, const string &data, const long long deadline ) {
+	size_t sent = 0;
+	while ( sent < data.length() ) {
+		ssize_t n = send( fd, data.data()+sent, data.length()-sent, HTTPCLIENT_SEND_FLAGS );
+		if ( n < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			if ( errno!=EAGAIN && errno!=EWOULDBLOCK )
+				return ERROR_SEND_REQUEST;
+			if ( !HttpClient::wait_fd(fd,POLLOUT,deadline) )
+				return ERROR_RESPONSE_TIMEDOUT;
+			continue;
+		}
+		sent += n;
 	}
+	return ERROR_NULL;
+}
 
-	fd_set fds;
-	struct timeval tv;
+// 空闲连接是否可用
+// 服务器已关闭连接或发送了多余数据时不可用
+static bool conn_alive( const int fd ) {
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return ( poll(&pfd,1,0) == 0 );
+}
 
-	// set timer
-	if ( timeout > 0 ) {
-		FD_ZERO( &fds );
-		FD_SET( fd, &fds );
-		tv.tv_sec = timeout;
-		tv.tv_usec = 0;
+/// 在已建立的连接上发送HTTP请求并读取回应
+/// 按回应头确定的长度读取回应,无法确定长度时读取至连接关闭
+/// \param fd 连接socket,须为非阻塞模式
+/// \param head_only 回应是否只有回应头,HEAD请求时为true
+/// \param deadline 发送请求及读取回应的截止时间,单位为毫秒,为0不判断超时
+/// \return 错误信息代码
+int HttpClient::exchange( const int fd, const bool head_only, const long long deadline ) {
+	string &response = _response;
+	this->frame_init();
+	response = "";
 
-		if ( select(fd+1,&fds,NULL,NULL,&tv) <= 0 ) {
-			close( fd );
-			return 4;
+	// send request
+	int res = HttpClient::send_all( fd, _request, deadline );
+	if ( res != ERROR_NULL )
+		return res;
+
+	// recv response
+	char buff[HTTPCLIENT_READ_SIZE];
+	while ( !this->frame_response(head_only) ) {
+		if ( _frame.error != ERROR_NULL )
+			return _frame.error;
+		if ( !HttpClient::wait_fd(fd,POLLIN,deadline) )
+			return ERROR_RESPONSE_TIMEDOUT;
+
+		ssize_t readed = recv( fd, buff, sizeof(buff), 0 );
+		if ( readed<0 && (errno==EINTR || errno==EAGAIN || errno==EWOULDBLOCK) )
+			continue;
+		if ( readed <= 0 ) {
+			// connection closed
+			return this->frame_closed();
 		}
+		response.append( buff, readed );
 	}
 
-	if ( ( timeout>0 && FD_ISSET(fd,&fds) ) || timeout<=0 ) {
-		// recv response
-		int readed = 0;
-		int buflen = 1024;
-		char buff[1024];
-		
-		while ( (readed=recv(fd,buff,buflen-1,0)) > 0 ) {
-			buff[readed] = '\0';
-			response += buff;
+	return ERROR_NULL;
+}
+
+/// \defgroup waHttpClient waHttpClient相关全局函数
+
+/// \ingroup waHttpClient
+/// \fn int tcp_request( const string &server, const int port, const string &request, string &response, const int timeout )
+/// 发送TCP请求并取得回应内容
+/// \param server 服务器IP
+/// \param port 服务器端口
+/// \param request 发送的TCP请求
+/// \param response 服务器的回应内容
+/// \param timeout 超时时长,单位为秒,为0不判断超时
+/// \return 同 tcp_request_ms()
+int tcp_request( const string &server, const int port, const string &request,
+	string &response, const int timeout ) 
+{
+	return tcp_request_ms( server, port, request, response, seconds_to_ms(timeout) );
+}
+
+/// \ingroup waHttpClient
+/// \fn int tcp_request_ms( const string &server, const int port, const string &request, string &response, const int timeout_ms )
+/// 发送TCP请求并取得回应内容
+/// 连接、发送请求及读取回应至连接关闭共用同一截止时间
+/// \param server 服务器IP
+/// \param port 服务器端口
+/// \param request 发送的TCP请求
+/// \param response 服务器的回应内容
+/// \param timeout_ms 超时时长,单位为毫秒,为0不判断超时
+/// \retval 0 执行成功
+/// \retval 1 创建socket失败
+/// \retval 2 无法连接服务器
+/// \retval 3 发送请求失败
+/// \retval 4 连接、发送请求或读取回应超时
+int tcp_request_ms( const string &server, const int port, const string &request,
+	string &response, const int timeout_ms ) 
+{
+	long long deadline = ( timeout_ms>0 ) ? HttpClient::now_ms()+timeout_ms : 0;
+
+	// connect
+	int fd;
+	int res = HttpClient::connect_server( server, port, deadline, fd );
+	if ( res != HttpClient::ERROR_NULL )
+		return res;
+
+	// send request
+	res = HttpClient::send_all( fd, request, deadline );
+
+	// recv response
+	char buff[HTTPCLIENT_READ_SIZE];
+	while ( res == HttpClient::ERROR_NULL ) {
+		if ( !HttpClient::wait_fd(fd,POLLIN,deadline) ) {
+			res = HttpClient::ERROR_RESPONSE_TIMEDOUT;
+			break;
 		}
 
-		close( fd );
-		return 0;
-	} else {
-		close( fd );
-		return 10;
+		ssize_t readed = recv( fd, buff, sizeof(buff), 0 );
+		if ( readed<0 && (errno==EINTR || errno==EAGAIN || errno==EWOULDBLOCK) )
+			continue;
+		if ( readed <= 0 )
+			break;
+		response.append( buff, readed );
 	}
+
+	close( fd );
+	return res;
 }
 
 /// \ingroup waHttpClient
 /// \fn string gethost_byname( const string &domain )
-/// ݷȡIP
-/// \param domain "HTTP:://"ͷκ'/'ַ
-/// \return ִгɹطIP,򷵻ؿַ
+/// 根据服务器域名取得IP
+/// \param domain 服务器域名（不包含"HTTP:://"头及任何'/'字符）
+/// \return 执行成功返回服务器IP,否则返回空字符串
 string gethost_byname( const string &domain ) {
 	string ip;
 	if ( domain != "" ) {
@@ -112,10 +629,10 @@ string gethost_byname( const string &domain ) {
 
 /// \ingroup waHttpClient
 /// \fn bool isip( const string &ipstr )
-/// жַǷΪЧIP
-/// \param ipstr IPַ
-/// \retval true Ч
-/// \retval false Ч
+/// 判断字符串是否为有效IP
+/// \param ipstr IP字符串
+/// \retval true 有效
+/// \retval false 无效
 bool isip( const string &ipstr ) {
 	
 	struct in_addr addr;
@@ -125,24 +642,24 @@ bool isip( const string &ipstr ) {
 		return false;
 }
 
-/// ָHTTPHeader
-/// \param name Header
-/// \param value Headerֵ,
+/// 设置指定的HTTP请求Header
+/// \param name Header名称
+/// \param value Header值,
 void HttpClient::set_header( const string &name, const string &value ) {
 	if ( name != "" )
 		_sets[name] = value;
 }
 
-/// HTTPReferer Header
-/// \param referer Referer Headerֵ
+/// 设置HTTP请求Referer Header
+/// \param referer Referer Header值
 void HttpClient::set_referer( const string &referer ) {
 	if ( referer != "" )
 		set_header( "Referer", referer );
 }
 
-/// HTTPAuthorization Header
-/// \param username û
-/// \param password û
+/// 设置HTTP请求Authorization Header
+/// \param username 用户名
+/// \param password 用户口令
 void HttpClient::set_auth( const string &username, const string &password ) {
 	if ( username != "" ) {
 		string auth = username + ":" + password;
@@ -151,9 +668,9 @@ void HttpClient::set_auth( const string &username, const string &password ) {
 	}
 }
 
-/// HTTPCookie Header
-/// \param name Cookie
-/// \param value Cookieֵ
+/// 设置HTTP请求Cookie Header
+/// \param name Cookie名称
+/// \param value Cookie值
 void HttpClient::set_cookie( const string &name, const string &value ) {
 	if ( name != "" ) {
 		if ( _sets["Cookie"] != "" )
@@ -162,9 +679,9 @@ void HttpClient::set_cookie( const string &name, const string &value ) {
 	}
 }
 
-/// HTTPCGI
-/// \param name CGI
-/// \param value CGIֵ
+/// 设置HTTP请求CGI参数
+/// \param name CGI参数名称
+/// \param value CGI参数值
 void HttpClient::set_param( const string &name, const string &value ) {
 	if ( name != "" ) {
 		if ( _params != "" ) _params += "&";
@@ -172,13 +689,42 @@ void HttpClient::set_param( const string &name, const string &value ) {
 	}
 }
 
-/// HTTP URLַ
-/// \param urlstr URL
-/// \param parsed_host 
-/// \param parsed_host ַ
-/// \param parsed_url URL
-/// \param parsed_param 
-/// \param parsed_port ˿ڷ
+/// 设置HTTP返回正文处理回调函数
+/// 设置后正文不保存在 content() 中,读取时分块交由回调函数处理,
+/// 正文完整读取后以 data 为NULL,len 为0调用一次回调函数,
+/// 请求失败(如正文未读取完毕时连接关闭)时不调用,已输出的部分正文应由调用者丢弃,
+/// 回调函数返回false时中止请求,errnum() 为 ERROR_WRITE_BODY
+/// \param writer 回调函数,为NULL则正文保存在 content() 中
+/// \param arg 传递给回调函数的参数
+void HttpClient::set_body_writer( body_writer writer, void *arg ) {
+	_writer = writer;
+	_writerarg = arg;
+}
+
+/// 设置HTTP返回正文输出文件
+/// 设置后正文不保存在 content() 中,读取时直接写入文件,
+/// 写入失败时中止请求,errnum() 为 ERROR_WRITE_BODY,
+/// request() 返回失败时文件中可能已写入部分正文,
+/// 同时设置了 set_body_writer() 时只调用回调函数
+/// \param fd 已打开的文件描述符,由调用者关闭,为-1则正文保存在 content() 中
+void HttpClient::set_body_fd( const int fd ) {
+	_bodyfd = fd;
+}
+
+/// 设置HTTP返回正文长度上限
+/// Content-Length 或已读取的正文超过上限时中止请求,errnum() 为 ERROR_RESPONSE_TOOLARGE
+/// \param size 正文长度上限,单位为byte,为0则不限制
+void HttpClient::set_max_body( const size_t size ) {
+	_maxbody = size;
+}
+
+/// 分析HTTP URL字符串
+/// \param urlstr 请求URL
+/// \param parsed_host 服务器主机名分析结果
+/// \param parsed_host 服务器主机地址分析结果
+/// \param parsed_url 请求URL分析结果
+/// \param parsed_param 请求参数分析结果
+/// \param parsed_port 服务器端口分析结果
 void HttpClient::parse_url( const string &urlstr, string &parsed_host, string &parsed_addr,
 	string &parsed_url, string &parsed_param, int &parsed_port )
 {
@@ -229,14 +775,15 @@ void HttpClient::parse_url( const string &urlstr, string &parsed_host, string &p
 		parsed_addr = parsed_host;
 }
 				   
-/// HTTPַ
-/// \param url URL
-/// \param params URLCGI
-/// \param host (IP)
-/// \param method 󷽷(GETPOST)
-/// \return ɵHTTPַ
+/// 生成HTTP请求字符串
+/// \param url 所请求的URL
+/// \param params 所请求的URL的CGI参数
+/// \param host 服务器域名(或者IP)
+/// \param method 请求方法(GET或者POST)
+/// \param keepalive 是否请求保持连接,已设置Connection请求Header时不再生成
+/// \return 返回生成的HTTP请求字符串
 string HttpClient::gen_httpreq( const string &url, const string &params, 
-	const string &host, const string &method ) 
+	const string &host, const string &method, const bool keepalive ) 
 {
 	string request;
 	request.reserve( 512 );
@@ -258,33 +805,81 @@ string HttpClient::gen_httpreq( const string &url, const string &params,
 			request += i->first + ": " + i->second + HTTP_CRLF;
 	}
 
-	request += "Connection: close" + HTTP_CRLF;
+	if ( _sets.find("Connection") == _sets.end() )
+		request += ( keepalive ? "Connection: keep-alive" : "Connection: close" ) + HTTP_CRLF;
 
 	if ( method == "POST" ) {
-		// post data
+		// post data, 正文之后不能有多余数据,否则无法复用连接
 		request += "Content-Type: application/x-www-form-urlencoded" + HTTP_CRLF;
 		request += "Content-Length: " + itos(params.length()) + HTTP_CRLF;
 		request += HTTP_CRLF;
-		request += params + HTTP_CRLF;
+		request += params;
+		return request;
 	}
 
 	request += HTTP_CRLF;
 	return request;
 }
 
-/// ִHTTP
-/// \param url HTTPURL
-/// \param server IP,Ϊַݲ1,ĬΪַ,
-/// url,serverַϢ,ʧ
-/// \param port ˿,ĬΪ80
-/// \param method HTTPMethod,ĬΪ"GET"
-/// \param timeout HTTPʱʱ,λΪ,ĬΪ5
-/// \retval true ִгɹ
-/// \retval false ִʧ
+/// 执行HTTP请求
+/// \param url HTTP请求URL
+/// \param server 服务器IP或者域名,为空字符串则根据参数1获得,默认为空字符串,
+/// 若参数url,server都不包含服务器地址信息,则函数返回失败
+/// \param port 服务器端口,默认为80
+/// \param method HTTP请求Method,默认为"GET"
+/// \param timeout HTTP请求超时时长,单位为秒,默认为5秒,为0不判断超时
+/// \retval true 执行成功
+/// \retval false 执行失败
+/// 连接池保持连接时复用同一服务器的空闲连接,参见 set_pool()
 bool HttpClient::request( const string &url, const string &host, const int port, 
 	const string &method, const int timeout )
+{
+	return this->request_ms( url, host, port, method, seconds_to_ms(timeout) );
+}
+
+/// 执行HTTP请求
+/// 连接服务器、发送请求及读取回应共用同一截止时间,超时返回失败,
+/// 错误信息代码为 ERROR_RESPONSE_TIMEDOUT
+/// \param url HTTP请求URL
+/// \param server 服务器IP或者域名,为空字符串则根据参数1获得,默认为空字符串
+/// \param port 服务器端口,默认为80
+/// \param method HTTP请求Method,默认为"GET"
+/// \param timeout_ms HTTP请求超时时长,单位为毫秒,默认为5000毫秒,为0不判断超时
+/// \retval true 执行成功
+/// \retval false 执行失败
+bool HttpClient::request_ms( const string &url, const string &host, const int port, 
+	const string &method, const int timeout_ms )
+{
+	long long deadline = ( timeout_ms>0 ) ? HttpClient::now_ms()+timeout_ms : 0;
+	string addr;
+	int addrport;
+	bool keepalive;
+	if ( !this->prepare(url,host,port,method,addr,addrport,keepalive) )
+		return false;
+
+	// request
+	int reqres = this->send_request( addr, addrport, method=="HEAD", keepalive,
+		HttpClient::idempotent(method), deadline );
+	return this->finish( reqres );
+}
+
+/// 准备HTTP请求
+/// 分析服务器地址并生成HTTP请求字符串,参数同 request()
+/// \param url HTTP请求URL
+/// \param host 服务器IP或者域名
+/// \param port 服务器端口
+/// \param method HTTP请求Method
+/// \param addr 服务器IP
+/// \param addrport 服务器端口
+/// \param keepalive 是否请求保持连接
+/// \retval true 成功
+/// \retval false 服务器地址信息错误
+bool HttpClient::prepare( const string &url, const string &host, const int port,
+	const string &method, string &addr, int &addrport, bool &keepalive )
 {
 	_errno = ERROR_NULL;
+	_response = "";
+	this->frame_init();
 	
 	// parse host,port,url info
 	string parsed_host, parsed_addr, parsed_url, parsed_param;
@@ -315,10 +910,25 @@ bool HttpClient::request( const string &url, const string &host, const int port,
 		return false;
 	}
 	
+	// keep-alive
+	http_pool &pool = HttpClient::pool();
+	pthread_mutex_lock( &pool.lock );
+	keepalive = ( pool.limit > 0 );
+	pthread_mutex_unlock( &pool.lock );
+
 	// generate request string
-	_request = this->gen_httpreq( parsed_url, _params, parsed_host, method );
-	// request
-	int reqres = tcp_request( parsed_addr, parsed_port, _request, _response, timeout );
+	_request = this->gen_httpreq( parsed_url, _params, parsed_host, method, keepalive );
+	addr = parsed_addr;
+	addrport = parsed_port;
+	return true;
+}
+
+/// 完成HTTP请求
+/// 设置错误信息代码并分析HTTP返回
+/// \param reqres 发送请求并读取回应的错误信息代码
+/// \retval true 执行成功
+/// \retval false 执行失败
+bool HttpClient::finish( const int reqres ) {
 	if ( reqres != 0 ) {
 		_errno = static_cast<error_msg>( reqres );
 		return false;
@@ -330,17 +940,23 @@ bool HttpClient::request( const string &url, const string &host, const int port,
 		return false;
 	}
 
-	this->parse_response( _response );
+	// 正文结束,只在回应完整时通知,不完整的回应已由 frame_closed() 返回错误
+	if ( _writer!=NULL && !_writer(NULL,0,_writerarg) ) {
+		_errno = ERROR_WRITE_BODY;
+		return false;
+	}
+
+	this->parse_response();
 	return true;
 }
 
-/// URL ǷЧ
-/// \param url HTTPURL
-/// \param server IP,Ϊַݲ1,ĬΪַ,
-/// url,serverַϢ,ʧ
-/// \param port ˿,ĬΪ80
-/// \retval true URLЧ
-/// \retval false URLʧЧ
+/// URL 是否有效
+/// \param url HTTP请求URL
+/// \param server 服务器IP,为空字符串则根据参数1获得,默认为空字符串,
+/// 若参数url,server都不包含服务器地址信息,则函数返回失败
+/// \param port 服务器端口,默认为80
+/// \retval true URL有效
+/// \retval false URL已失效
 bool HttpClient::exist( const string &url, const string &server, 
 	const int port ) 
 {
@@ -358,62 +974,57 @@ bool HttpClient::exist( const string &url, const string &server,
 	return res;
 }
 
-/// HTTP
-/// \param response HTTPַ
-void HttpClient::parse_response( const string &response ) {
+/// 分析HTTP返回
+/// 在读取的回应中直接分析回应头,回应头保留在 _response 中,正文移至 _content,
+/// chunked正文已在读取时解码
+void HttpClient::parse_response() {
 	// clear response status
 	_status = "";
 	_content = "";
 	_gets.clear();
 
+	// 未读取完毕的chunked正文只保留已解码部分
+	if ( _frame.chunk!=string::npos && _frame.body<_response.length() )
+		_response.erase( _frame.body );
+
 	// split header and body
-	size_t pos;
-	String head;
-	String body;
-	if ( (pos=response.find(DOUBLE_CRLF)) != response.npos ) {
-		head = response.substr( 0, pos );
-		body = response.substr( pos+4 );
-	} else if ( (pos=response.find("\n\n")) != response.npos ) {
-		head = response.substr( 0, pos );
-		body = response.substr( pos+2 );
-	} else {
+	size_t head = _frame.head;
+	if ( head == 0 ) {
 		_errno = ERROR_RESPONSE_INVALID;
 		return;
-	}	
-				
-	// parse status
-	String status;
-	if ( (pos=head.find(HTTP_CRLF)) != head.npos ) {
-		status = head.substr( 0, pos );
-		head = head.substr( pos+2 );
-		
-		// HTTP/1.1 status_number description_string
-		status.trim();
-		_gets["HTTP_STATUS"] = status;
-		if ( strncmp(status.c_str(),"HTTP/",5) == 0 ) {
-			size_t b1, b2;
-			if ( (b1=status.find(" "))!=status.npos
-				 && (b2=status.find(" ",b1+1))!=status.npos )
-				_status = status.substr( b1+1, b2-b1-1 );
-		}
 	}
 
-	// http response status
-	if ( _status.length()>1 && _status[0]!='2' )
-		_errno = ERROR_HTTPSTATUS;
-	
-	// parse header
+	// parse status and header
 	String line, name, value;
-	vector<String> hds = head.split( "\n" );
-	for ( size_t i=0; i<hds.size(); ++i ) {
-		line = hds[i];
+	size_t pos, eol;
+	for ( pos=0; pos<head; pos=eol+1 ) {
+		if ( (eol=_response.find('\n',pos)) == _response.npos )
+			eol = head;
+		line.assign( _response, pos, eol-pos );
 		line.trim();
-		
+		if ( line == "" )
+			continue;
+
+		if ( pos == 0 ) {
+			// HTTP/1.1 status_number description_string
+			_gets["HTTP_STATUS"] = line;
+			if ( strncmp(line.c_str(),"HTTP/",5) == 0 ) {
+				size_t b1, b2;
+				if ( (b1=line.find(" ")) != line.npos ) {
+					if ( (b2=line.find(" ",b1+1)) == line.npos )
+						b2 = line.length();
+					_status = line.substr( b1+1, b2-b1-1 );
+				}
+			}
+			continue;
+		}
+
 		// name: value
-		if ( (pos=line.find(":")) != line.npos ) {
-			name = line.substr( 0, pos );
+		size_t colon;
+		if ( (colon=line.find(":")) != line.npos ) {
+			name = line.substr( 0, colon );
 			name.trim();
-			value = line.substr( pos+1 );
+			value = line.substr( colon+1 );
 			value.trim();
 			
 			if ( name != "" ) {
@@ -423,17 +1034,20 @@ void HttpClient::parse_response( const string &response ) {
 			}
 		}
 	}
-	
-	// parse body
-	if ( this->get_header("Transfer-Encoding") == "chunked" )
-		_content = this->parse_chunked( body );
-	else
-		_content = body;
+
+	// http response status
+	if ( _status.length()>1 && _status[0]!='2' )
+		_errno = ERROR_HTTPSTATUS;
+
+	// 正文移至 _content,不复制回应全文
+	_content.swap( _response );
+	_response.assign( _content, 0, head );
+	_content.erase( 0, head );
 }
 
-/// ȡָHTTPHeader
-/// \param name Header,
-/// \return ɹHeaderֵ,򷵻ؿַ
+/// 获取指定的HTTP返回Header
+/// \param name Header名称,
+/// \return 成功返回Header值,否则返回空字符串
 string HttpClient::get_header( const string &name ) {
 	if ( name != "" )
 		return _gets[name];
@@ -441,16 +1055,16 @@ string HttpClient::get_header( const string &name ) {
 		return string( "" );		
 }
 
-/// ȡHTTPSet-Cookie Header
-/// \return Cookieб,ÿԪΪһCookieֵ
+/// 获取HTTP返回Set-Cookie Header
+/// \return 返回Cookie列表数组,每个元素为一个Cookie值
 vector<String> HttpClient::get_cookie() {
 	String ck = this->get_header( "Set-Cookie" );
 	vector<String> cks = ck.split( "\n" );
 	return cks;
 }
 
-/// ȡHTTPHeader
-/// \return HTTPHeaderַ
+/// 获取HTTP返回Header
+/// \return HTTP返回Header字符串
 string HttpClient::dump_header() {
 	// status
 	string header = ( this->get_header("HTTP_STATUS") + "\n" );
@@ -476,9 +1090,9 @@ string HttpClient::dump_header() {
 	return header;
 }
 
-/// ִHTTPǷɹ
-/// \retval true ɹ
-/// \retval false ʧ
+/// 执行HTTP请求是否成功
+/// \retval true 成功
+/// \retval false 失败
 bool HttpClient::done() const {
 	if ( _status.isnum() ) {
 		int ret = webapp::stoi( _status );
@@ -488,11 +1102,15 @@ bool HttpClient::done() const {
 	return false;
 }
 
-/// ü״ֵ̬
+/// 清空所有设置及状态值
 void HttpClient::clear() {
 	// set
 	_params = "";
 	_sets.clear();
+	_writer = NULL;
+	_writerarg = NULL;
+	_bodyfd = -1;
+	_maxbody = 0;
 	
 	// get
 	_status = "";
@@ -500,43 +1118,200 @@ void HttpClient::clear() {
 	_gets.clear();
 }
 
-/// HTTPchunkedcontent
-/// \param chunkedstr chunkedַ
-/// \return ؽַ
-string HttpClient::parse_chunked( const string &chunkedstr ) {
-	char crlf[3] = "\x0D\x0A";
-	size_t pos, lastpos;
-	int size = 0;
-	string hexstr;
+/// 进程内唯一的连接池
+/// \return 连接池
+HttpClient::http_pool& HttpClient::pool() {
+	static http_pool pool;
+	return pool;
+}
+
+/// 设置连接池
+/// request() 请求保持连接,回应允许保持连接时将连接放回连接池,
+/// 之后对同一服务器的请求复用空闲连接,超过保持时间或已被服务器关闭的空闲连接不再复用,
+/// 默认每个服务器保持 HTTPCLIENT_POOL_SIZE 个空闲连接,
+/// 连接池在进程内共享,fork()之后子进程不复用父进程的连接,线程安全
+/// \param max_idle 每个服务器保持的空闲连接数量上限,为0则不保持连接,
+/// 每次请求后关闭连接
+/// \param idle_timeout 空闲连接保持时间,单位为秒,默认为 HTTPCLIENT_POOL_IDLE
+void HttpClient::set_pool( const size_t max_idle, const int idle_timeout ) {
+	http_pool &pool = HttpClient::pool();
+	pthread_mutex_lock( &pool.lock );
+	pool.check_pid();
+	pool.limit = max_idle;
+	pool.timeout = idle_timeout;
 
-	// location HTTP_CRLF		
-	if ( (pos=chunkedstr.find(crlf)) != chunkedstr.npos ) {
-		hexstr = chunkedstr.substr( 0, pos );
-		size = stoi( hexstr, ios::hex );
+	// 关闭超过上限的最早放回的空闲连接
+	for ( http_pool::http_idleconns::iterator i=pool.conns.begin(); i!=pool.conns.end(); ++i ) {
+		vector<http_pool::http_idleconn> &idles = i->second;
+		if ( idles.size() > max_idle ) {
+			size_t excess = idles.size() - max_idle;
+			for ( size_t j=0; j<excess; ++j )
+				close( idles[j].fd );
+			idles.erase( idles.begin(), idles.begin()+excess );
+		}
 	}
-	
-	string res;
-	res.reserve( chunkedstr.length() );
-	
-	while ( size > 0 ) {
-		// append to content
-		res += chunkedstr.substr( pos+2, size );
-		lastpos = pos+size+4;
-		
-		// location next HTTP_CRLF
-		if ( (pos=chunkedstr.find(crlf,lastpos)) != chunkedstr.npos ) {
-			hexstr = chunkedstr.substr( lastpos, pos-lastpos );
-			size = stoi( hexstr, ios::hex );
-		} else {
-			break;
+	pthread_mutex_unlock( &pool.lock );
+}
+
+/// 关闭连接池中的全部空闲连接
+/// 不清除复用次数统计,线程安全
+void HttpClient::clear_pool() {
+	http_pool &pool = HttpClient::pool();
+	pthread_mutex_lock( &pool.lock );
+	pool.clear();
+	pthread_mutex_unlock( &pool.lock );
+}
+
+/// 连接池统计
+/// 线程安全
+/// \return 复用连接次数,新建连接次数,已失效而关闭的空闲连接数量及当前空闲连接数量
+HttpClient::pool_stat HttpClient::pool_stats() {
+	http_pool &pool = HttpClient::pool();
+	pool_stat stat;
+	pthread_mutex_lock( &pool.lock );
+	pool.check_pid();
+	stat.hits = pool.hits;
+	stat.misses = pool.misses;
+	stat.stales = pool.stales;
+	stat.idles = 0;
+	for ( http_pool::http_idleconns::const_iterator i=pool.conns.begin(); i!=pool.conns.end(); ++i )
+		stat.idles += i->second.size();
+	pthread_mutex_unlock( &pool.lock );
+	return stat;
+}
+
+/// 从连接池取得连接
+/// 优先使用最近放回的空闲连接,关闭超过保持时间或已失效的空闲连接
+/// \param addr 服务器IP
+/// \param port 服务器端口
+/// \return 空闲连接socket,没有可用的空闲连接时返回-1
+int HttpClient::pool_get( const string &addr, const int port ) {
+	http_pool &pool = HttpClient::pool();
+	string key = addr + ":" + itos( port );
+	time_t now = time( NULL );
+	vector<int> stales;
+	int fd = -1;
+
+	pthread_mutex_lock( &pool.lock );
+	pool.check_pid();
+	http_pool::http_idleconns::iterator i = pool.conns.find( key );
+	if ( i != pool.conns.end() ) {
+		vector<http_pool::http_idleconn> &idles = i->second;
+		while ( fd<0 && !idles.empty() ) {
+			http_pool::http_idleconn conn = idles.back();
+			idles.pop_back();
+			if ( now-conn.idle<pool.timeout && conn_alive(conn.fd) )
+				fd = conn.fd;
+			else
+				stales.push_back( conn.fd );
 		}
 	}
-			
-	return res;
+	pool.stales += stales.size();
+	if ( fd >= 0 )
+		++pool.hits;
+	else
+		++pool.misses;
+	pthread_mutex_unlock( &pool.lock );
+
+	for ( size_t j=0; j<stales.size(); ++j )
+		close( stales[j] );
+	return fd;
+}
+
+/// 将连接放回连接池
+/// 同时关闭该服务器超过保持时间的空闲连接,超过空闲连接数量上限时关闭最早放回的连接
+/// \param addr 服务器IP
+/// \param port 服务器端口
+/// \param fd 连接socket
+void HttpClient::pool_put( const string &addr, const int port, const int fd ) {
+	http_pool &pool = HttpClient::pool();
+	string key = addr + ":" + itos( port );
+	time_t now = time( NULL );
+	vector<int> closes;
+
+	pthread_mutex_lock( &pool.lock );
+	pool.check_pid();
+	vector<http_pool::http_idleconn> &idles = pool.conns[key];
+	size_t expired = 0;
+	while ( expired<idles.size() && 
+			( now-idles[expired].idle>=pool.timeout || idles.size()-expired>=pool.limit ) ) 
+	{
+		closes.push_back( idles[expired].fd );
+		++expired;
+	}
+	idles.erase( idles.begin(), idles.begin()+expired );
+
+	if ( pool.limit > 0 ) {
+		http_pool::http_idleconn conn;
+		conn.fd = fd;
+		conn.idle = now;
+		idles.push_back( conn );
+	} else {
+		closes.push_back( fd );
+	}
+	pthread_mutex_unlock( &pool.lock );
+
+	for ( size_t j=0; j<closes.size(); ++j )
+		close( closes[j] );
+}
+
+/// HTTP请求Method是否幂等
+/// 幂等的请求在复用的空闲连接被服务器关闭时可以重新发送(RFC 7230 6.3.1)
+/// \param method HTTP请求Method
+/// \retval true GET,HEAD,PUT,DELETE,OPTIONS,TRACE
+/// \retval false 其他Method,如POST
+bool HttpClient::idempotent( const string &method ) {
+	return ( method=="GET" || method=="HEAD" || method=="PUT" ||
+			 method=="DELETE" || method=="OPTIONS" || method=="TRACE" );
+}
+
+/// 发送HTTP请求并取得回应
+/// 保持连接时优先复用连接池中的空闲连接,复用的空闲连接在发送请求时已被服务器关闭,
+/// 或者请求幂等且已发送请求但未收到任何回应时,以新建连接重新请求,
+/// 回应允许保持连接且已完整读取时将连接放回连接池
+/// \param addr 服务器IP
+/// \param port 服务器端口
+/// \param head_only 回应是否只有回应头,HEAD请求时为true
+/// \param keepalive 是否使用连接池
+/// \param idempotent 请求是否幂等,参见 idempotent()
+/// \param deadline 截止时间,单位为毫秒,为0不判断超时,重新请求时不延长
+/// \return 错误信息代码,参见 tcp_request_ms()
+int HttpClient::send_request( const string &addr, const int port, const bool head_only,
+	const bool keepalive, const bool idempotent, const long long deadline )
+{
+	for ( int retry=0; retry<2; ++retry ) {
+		int fd = ( retry==0 && keepalive ) ? HttpClient::pool_get( addr, port ) : -1;
+		if ( fd>=0 && !HttpClient::set_nonblock(fd,true) ) {
+			close( fd );
+			fd = -1;
+		}
+		bool reused = ( fd >= 0 );
+
+		if ( !reused ) {
+			int res = HttpClient::connect_server( addr, port, deadline, fd );
+			if ( res != ERROR_NULL )
+				return res;
+		}
+
+		// 连接池中的连接为阻塞模式
+		int res = this->exchange( fd, head_only, deadline );
+		if ( res==ERROR_NULL && keepalive && _frame.keepalive && HttpClient::set_nonblock(fd,false) )
+			HttpClient::pool_put( addr, port, fd );
+		else
+			close( fd );
+
+		// 空闲连接已被服务器关闭,非幂等请求已发送时不能确定服务器是否已处理,不重新请求
+		if ( reused && _response=="" && 
+			 (res==ERROR_SEND_REQUEST || (res==ERROR_RESPONSE_NULL && idempotent)) )
+			continue;
+		return res;
+	}
+
+	return ERROR_UNKNOWN;
 }
 
-/// شϢ
-/// \return شϢ
+/// 返回错误信息描述
+/// \return 返回错误信息描述
 string HttpClient::error() const {
 	switch ( _errno ) {
 		case ERROR_NULL :
@@ -559,6 +1334,10 @@ string HttpClient::error() const {
 			return "ERROR_RESPONSE_INVALID";
 		case ERROR_HTTPSTATUS :
 			return "ERROR_HTTPSTATUS:" + status();
+		case ERROR_RESPONSE_TOOLARGE :
+			return "ERROR_RESPONSE_TOOLARGE";
+		case ERROR_WRITE_BODY :
+			return "ERROR_WRITE_BODY";
 		default : 
 			return "ERROR_UNKNOWN";
 	}
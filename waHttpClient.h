@@ -1,7 +1,7 @@
 /// \file waHttpClient.h
-/// HTTPͻͷļ
-///  webapp::String, webapp::Encode
-/// <a href="wa_httpclient.html">ʹ˵ĵ򵥷</a>
+/// HTTP客户端类头文件
+/// 依赖于 webapp::String, webapp::Encode
+/// <a href="wa_httpclient.html">使用说明文档及简单范例</a>
 
 #ifndef _WEBAPPLIB_HTTPCLIENT_H_
 #define _WEBAPPLIB_HTTPCLIENT_H_ 
@@ -18,141 +18,254 @@ namespace webapp {
 	
 const string HTTP_CRLF = "\r\n";
 const string DOUBLE_CRLF = "\r\n\r\n";
+
+/// 默认每个服务器保持的空闲连接数量上限
+const size_t HTTPCLIENT_POOL_SIZE = 8;
+/// 默认空闲连接保持时间,单位为秒
+const int HTTPCLIENT_POOL_IDLE = 15;
 	
-/// TCPȡûӦ
+/// \ingroup waHttpClient
+/// \typedef body_writer
+/// HTTP返回正文处理回调函数类型,
+/// 参数依次为正文数据,数据长度,HttpClient::set_body_writer()设置的参数,
+/// 正文完整读取后以 data 为NULL,len 为0调用一次,请求失败时不调用,返回false则中止请求
+typedef bool (*body_writer)( const char *data, const size_t len, void *arg );
+
+/// 发送TCP请求并取得回应内容
 int tcp_request( const string &server, const int port, const string &request, 
 	string &response, const int timeout );
-/// ݷȡIP
+/// 发送TCP请求并取得回应内容,超时时长单位为毫秒
+int tcp_request_ms( const string &server, const int port, const string &request, 
+	string &response, const int timeout_ms );
+/// 根据服务器域名取得IP
 string gethost_byname( const string &domain );
-/// жַǷΪЧIP
+/// 判断字符串是否为有效IP
 bool isip( const string &ipstr );
 
-/// HTTPͻ
-/// <a href="wa_httpclient.html">ʹ˵ĵ򵥷</a>
+/// HTTP客户端类
+/// <a href="wa_httpclient.html">使用说明文档及简单范例</a>
 class HttpClient {
 	public:
 	
-	/// \enum Ϣ
+	/// \enum 错误信息
 	enum error_msg {
-		/// ޴
+		/// 无错误
 		ERROR_NULL					= 0,
-		/// socketʧ
+		/// 创建socket失败
 		ERROR_CREATE_SOCKET			= 1,
-		/// ޷ӷ
+		/// 无法连接服务器
 		ERROR_CONNECT_SERVER		= 2,
-		/// ʧ
+		/// 发送请求失败
 		ERROR_SEND_REQUEST			= 3,
-		/// öʱʧܻӳʱ
+		/// 设置定时器失败或者连接超时
 		ERROR_RESPONSE_TIMEDOUT		= 4,
-		/// ڵַϢ
+		/// 服务期地址信息错误
 		ERROR_SERVERINFO_NULL		= 5,
-		/// HTTPʽ
+		/// HTTP请求格式错误
 		ERROR_REQUEST_NULL			= 6,
-		/// ӦΪ
+		/// 服务器回应为空
 		ERROR_RESPONSE_NULL			= 7,
-		/// Ӧʽ
+		/// 服务器回应格式错误
 		ERROR_RESPONSE_INVALID		= 8,
-		/// ӦHTTP״̬
+		/// 服务器回应HTTP状态错误
 		ERROR_HTTPSTATUS			= 9,
-		/// δ֪
-		ERROR_UNKNOWN				= 10
+		/// 未知错误
+		ERROR_UNKNOWN				= 10,
+		/// 服务器回应正文超过长度上限
+		ERROR_RESPONSE_TOOLARGE		= 11,
+		/// 回应正文处理回调函数或输出文件出错
+		ERROR_WRITE_BODY			= 12
 	};
 
-	/// ĬϹ캯
-	HttpClient(){};
+	/// 默认构造函数
+	HttpClient():
+	_errno(ERROR_NULL), _writer(NULL), _writerarg(NULL), _bodyfd(-1), _maxbody(0)
+	{
+		this->frame_init();
+	}
 	
-	/// 첢ִHTTP
-	/// \param url HTTPURL
-	/// \param server IP,Ϊַݲ1,ĬΪַ
-	/// \param port ˿,ĬΪ80
-	/// \param method HTTPMethod,ĬΪ"GET"
-	/// \param timeout HTTPʱʱ,λΪ,ĬΪ5,Ϊ0жϳʱ
+	/// 构造并执行HTTP请求
+	/// \param url HTTP请求URL
+	/// \param server 服务器IP,为空字符串则根据参数1获得,默认为空字符串
+	/// \param port 服务器端口,默认为80
+	/// \param method HTTP请求Method,默认为"GET"
+	/// \param timeout HTTP请求超时时长,单位为秒,默认为5秒,为0不判断超时
 	HttpClient( const string &url, const string &server = "", const int port = 80, 
-		const string &method = "GET", const int timeout = 5 ) 
+		const string &method = "GET", const int timeout = 5 ):
+	_errno(ERROR_NULL), _writer(NULL), _writerarg(NULL), _bodyfd(-1), _maxbody(0)
 	{
 		this->request( url, server, port, method, timeout );
 	}
 		  
-	/// 
+	/// 析构函数
 	virtual ~HttpClient(){};
 
-	/// ָHTTPHeader
+	/// 设置指定的HTTP请求Header
 	void set_header( const string &name, const string &value );
-	/// HTTPReferer Header
+	/// 设置HTTP请求Referer Header
 	void set_referer( const string &referer );
-	/// HTTPAuthorization Header
+	/// 设置HTTP请求Authorization Header
 	void set_auth( const string &username, const string &password );
-	/// HTTPCookie Header
+	/// 设置HTTP请求Cookie Header
 	void set_cookie( const string &name, const string &value );
-	/// HTTPCGI
+	/// 设置HTTP请求CGI参数
 	void set_param( const string &name, const string &value );
 
-	/// ִHTTP
+	/// 设置HTTP返回正文处理回调函数
+	void set_body_writer( body_writer writer, void *arg = NULL );
+	/// 设置HTTP返回正文输出文件
+	void set_body_fd( const int fd );
+	/// 设置HTTP返回正文长度上限
+	void set_max_body( const size_t size );
+
+	/// 执行HTTP请求
 	bool request( const string &url, const string &server = "", const int port = 80, 
 		const string &method = "GET", const int timeout = 5 );
-	/// URL ǷЧ
+	/// 执行HTTP请求,超时时长单位为毫秒
+	bool request_ms( const string &url, const string &server = "", const int port = 80, 
+		const string &method = "GET", const int timeout_ms = 5000 );
+	/// URL 是否有效
 	bool exist( const string &url, const string &server = "", const int port = 80 );
 
-	/// ȡָHTTPHeader
+	/// 获取指定的HTTP返回Header
 	string get_header( const string &name );
-	/// ȡHTTPSet-Cookie Header
+	/// 获取HTTP返回Set-Cookie Header
 	vector<String> get_cookie();
-	/// ȡHTTPHeader
+	/// 获取HTTP返回Header
 	string dump_header();
 	
-	/// ִHTTPǷɹ
+	/// 执行HTTP请求是否成功
 	bool done() const;
-	/// ü״ֵ̬
+	/// 清空所有设置及状态值
 	void clear();
+
+	/// 连接池统计
+	typedef struct {
+		size_t hits;					// 复用连接次数
+		size_t misses;					// 新建连接次数
+		size_t stales;					// 已失效而关闭的空闲连接数量
+		size_t idles;					// 当前空闲连接数量
+	} pool_stat;
+
+	/// 设置连接池
+	static void set_pool( const size_t max_idle, const int idle_timeout = HTTPCLIENT_POOL_IDLE );
+	/// 关闭连接池中的全部空闲连接
+	static void clear_pool();
+	/// 连接池统计
+	static pool_stat pool_stats();
 	
-	/// ȡHTTPStatus
-	/// \return HTTPStatusַ
+	/// 获取HTTP返回Status
+	/// \return HTTP返回Status字符串
 	inline string status() const {
 		return _status;
 	}
-	/// ȡHTTPContent
-	/// \return HTTPContent
-	inline string content() const {
+	/// 获取HTTP返回Content正文
+	/// \return HTTP返回Content正文
+	inline const string& content() const {
 		return _content;
 	}
-	/// ȡHTTPContentĳ(Content-Length)
-	/// \return HTTPContentĳ
+	/// 获取HTTP返回Content正文长度(Content-Length)
+	/// \return HTTP返回Content正文长度,正文输出至回调函数或文件时为已输出的长度
 	inline size_t content_length() const {
-		return _content.length();
+		return _content.length() + _frame.flushed;
 	}
 	
-	/// شϢ
-	/// Ϣμ Http::error_msg
+	/// 返回错误信息代码
+	/// 代码信息定义参见 Http::error_msg
 	inline error_msg errnum() const {
 		return _errno;
 	}
-	/// شϢ
+	/// 返回错误信息描述
 	string error() const;
 
-	/// ɵHTTPȫ
-	/// \return ɵHTTPȫ
+	/// 输出生成的HTTP请求全文
+	/// \return 返回生成的HTTP请求全文
 	inline string dump_request() const {
 		return _request;
 	}
-	/// õķȫ
-	/// \return ػõķȫ
+	/// 输出获得的服务器返回全文
+	/// \return 返回获得的服务器返回全文,chunked正文为解码后的内容
 	inline string dump_response() const {
-		return _response;
+		return _response + _content;
 	}
 	
 	////////////////////////////////////////////////////////////////////////////
 	private:
+	friend class HttpMulti;
+	friend int tcp_request_ms( const string &server, const int port, const string &request, 
+		string &response, const int timeout_ms );
+
+	typedef struct {					// HTTP回应分帧状态
+		size_t scan;					// 回应头已查找位置
+		size_t head;					// 回应头长度,包括空行,为0则回应头未读取完毕
+		size_t length;					// 回应全文长度,为npos则读取至连接关闭
+		size_t chunk;					// chunked正文待解码数据位置,为npos则不是chunked正文
+		size_t body;					// chunked正文已解码部分结束位置
+		size_t remain;					// chunked正文当前块未读取的长度
+		bool crlf;						// chunked正文当前块之后的换行是否未读取
+		size_t flushed;					// 已输出至回调函数或文件的正文长度
+		int status;						// 回应状态
+		int error;						// 错误信息代码
+		bool keepalive;					// 回应读取完毕后是否可以复用连接
+	} http_frame;
+
+	/// 准备HTTP请求
+	bool prepare( const string &url, const string &host, const int port,
+		const string &method, string &addr, int &addrport, bool &keepalive );
+	/// 完成HTTP请求
+	bool finish( const int reqres );
 
-	/// HTTP URLַ
+	/// 分析HTTP URL字符串
 	void parse_url( const string &url, string &parsed_host, string &parsed_addr,
 		string &parsed_url, string &parsed_param, int &parsed_port );
-	/// HTTPַ
+	/// 生成HTTP请求字符串
 	string gen_httpreq( const string &url, const string &params,
-		const string &host, const string &method );
-	/// HTTP
-	void parse_response( const string &response );
-	/// HTTPchunkedcontent
-	string parse_chunked( const string &chunkedstr );
+		const string &host, const string &method, const bool keepalive );
+	/// 分析HTTP返回
+	void parse_response();
+
+	/// 当前时间,单位为毫秒
+	static long long now_ms();
+	/// 设置socket是否非阻塞模式
+	static bool set_nonblock( const int fd, const bool nonblock );
+	/// 等待socket可读或可写
+	static bool wait_fd( const int fd, const short events, const long long deadline );
+	/// 以非阻塞模式开始连接服务器
+	static int connect_start( const string &addr, const int port, int &fd, bool &connected );
+	/// 取得非阻塞连接的结果
+	static int connect_result( const int fd );
+	/// 连接服务器
+	static int connect_server( const string &addr, const int port, const long long deadline, int &fd );
+	/// 在非阻塞socket上发送全部数据
+	static int send_all( const int fd, const string &data, const long long deadline );
+
+	struct http_pool;					// 连接池
+	/// 进程内唯一的连接池
+	static http_pool& pool();
+	/// 从连接池取得连接
+	static int pool_get( const string &addr, const int port );
+	/// 将连接放回连接池
+	static void pool_put( const string &addr, const int port, const int fd );
+	/// 发送HTTP请求并取得回应
+	int send_request( const string &addr, const int port, const bool head_only,
+		const bool keepalive, const bool idempotent, const long long deadline );
+	/// HTTP请求Method是否幂等
+	static bool idempotent( const string &method );
+	/// 在已建立的连接上发送HTTP请求并读取回应
+	int exchange( const int fd, const bool head_only, const long long deadline );
+
+	/// 初始化回应分帧状态
+	void frame_init();
+	/// 分析回应头
+	void frame_parsehead( const bool head_only );
+	/// 已读取的回应是否完整
+	bool frame_response( const bool head_only );
+	/// 分析已读取的回应
+	bool frame_decode( const bool head_only );
+	/// 连接关闭时回应是否完整
+	int frame_closed();
+	/// 检查正文长度并输出已读取的正文
+	void frame_flush();
 	
 	// set		
 	String _request;			// generated request
@@ -160,12 +273,17 @@ class HttpClient {
 	map<string,string> _sets;	// push http headers
 
 	// get
-	String _response;			// server response
+	String _response;			// server response, headers only after parsed
 	String _status;				// http response status
 	String _content;			// http response content
 	map<string,string> _gets;	// recv http headers
+	http_frame _frame;			// response framing state
 	
 	error_msg _errno;			// current error code
+	body_writer _writer;		// response body writer
+	void *_writerarg;			// response body writer argument
+	int _bodyfd;				// response body output file
+	size_t _maxbody;			// max response body size
 };
 
 } // namespace
@@ -0,0 +1,345 @@
+/// \file waHttpMulti.cpp
+/// webapp::HttpMulti类实现文件
+
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include "waHttpMulti.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+// 单次读取数据长度
+const size_t HTTPMULTI_READ_SIZE = 16384;
+// 单次epoll_wait()最大事件数量
+const int HTTPMULTI_EVENTS = 64;
+
+#ifdef MSG_NOSIGNAL
+const int HTTPMULTI_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int HTTPMULTI_SEND_FLAGS = 0;
+#endif
+
+/// 构造函数
+HttpMulti::HttpMulti():
+_epoll(-1), _active(0)
+{}
+
+/// 析构函数
+HttpMulti::~HttpMulti() {
+	this->clear();
+	if ( _epoll >= 0 )
+		close( _epoll );
+}
+
+/// 添加HTTP请求
+/// 参数同 HttpClient::request(),请求在调用 run() 时执行,
+/// 同一个 HttpClient 对象不能同时添加多次
+/// \param client 请求对象,执行结果保存在该对象中,run() 返回前不能删除
+/// \param url HTTP请求URL
+/// \param server 服务器IP或者域名,为空字符串则根据参数1获得,默认为空字符串
+/// \param port 服务器端口,默认为80
+/// \param method HTTP请求Method,默认为"GET"
+/// \param timeout_ms 请求超时时长,包括连接、发送请求及读取回应,单位为毫秒,
+/// 默认为5000毫秒,为0不判断超时
+/// \retval true 添加成功
+/// \retval false 服务器地址信息错误,client.errnum() 为错误信息代码
+bool HttpMulti::add( HttpClient &client, const string &url, const string &server,
+	const int port, const string &method, const int timeout_ms )
+{
+	http_req req;
+	req.client = &client;
+	req.head_only = ( method == "HEAD" );
+	req.idempotent = HttpClient::idempotent( method );
+	req.timeout = timeout_ms;
+	req.fd = -1;
+	req.reused = false;
+	req.sent = 0;
+	req.deadline = 0;
+	req.ok = false;
+
+	bool res = client.prepare( url, server, port, method, req.addr, req.port, req.keepalive );
+	req.state = res ? STATE_CONNECT : STATE_DONE;
+	_reqs.push_back( req );
+	return res;
+}
+
+/// 并发执行全部HTTP请求
+/// 全部请求完成或超时后返回,各请求的结果与 HttpClient::request() 相同
+/// \param timeout_ms 全部请求的超时时长,单位为毫秒,默认为0不判断超时,
+/// 与各请求的超时时长同时生效
+/// \return 执行成功的请求数量
+size_t HttpMulti::run( const int timeout_ms ) {
+	if ( _epoll<0 && (_epoll=epoll_create(HTTPMULTI_EVENTS))<0 ) {
+		for ( size_t i=0; i<_reqs.size(); ++i ) {
+			if ( _reqs[i].state != STATE_DONE ) {
+				++_active;
+				this->finish_req( _reqs[i], HttpClient::ERROR_CREATE_SOCKET );
+			}
+		}
+		return 0;
+	}
+
+	// start
+	long long now = HttpClient::now_ms();
+	long long overall = ( timeout_ms>0 ) ? now+timeout_ms : 0;
+	for ( size_t i=0; i<_reqs.size(); ++i ) {
+		http_req &req = _reqs[i];
+		if ( req.state == STATE_DONE )
+			continue;
+
+		req.deadline = ( req.timeout>0 ) ? now+req.timeout : 0;
+		if ( overall>0 && (req.deadline==0 || overall<req.deadline) )
+			req.deadline = overall;
+		this->start_req( i, req.keepalive );
+	}
+
+	struct epoll_event events[HTTPMULTI_EVENTS];
+	while ( _active > 0 ) {
+		// 最早的超时时间
+		long long deadline = 0;
+		for ( size_t i=0; i<_reqs.size(); ++i ) {
+			const http_req &req = _reqs[i];
+			if ( req.state!=STATE_DONE && req.deadline>0 &&
+				 (deadline==0 || req.deadline<deadline) )
+				deadline = req.deadline;
+		}
+
+		int wait = -1;
+		if ( deadline > 0 )
+			wait = ( deadline>now ) ? static_cast<int>( deadline-now ) : 0;
+
+		int n = epoll_wait( _epoll, events, HTTPMULTI_EVENTS, wait );
+		if ( n<0 && errno!=EINTR ) {
+			for ( size_t i=0; i<_reqs.size(); ++i ) {
+				if ( _reqs[i].state != STATE_DONE )
+					this->finish_req( _reqs[i], HttpClient::ERROR_UNKNOWN );
+			}
+			break;
+		}
+		for ( int i=0; i<n; ++i )
+			this->handle_req( events[i].data.u32, events[i].events );
+
+		// check timeout
+		now = HttpClient::now_ms();
+		for ( size_t i=0; i<_reqs.size(); ++i ) {
+			http_req &req = _reqs[i];
+			if ( req.state!=STATE_DONE && req.deadline>0 && now>=req.deadline )
+				this->finish_req( req, HttpClient::ERROR_RESPONSE_TIMEDOUT );
+		}
+	}
+
+	size_t done = 0;
+	for ( size_t i=0; i<_reqs.size(); ++i ) {
+		if ( _reqs[i].ok )
+			++done;
+	}
+	return done;
+}
+
+/// 清空HTTP请求列表
+/// 不影响已执行请求的 HttpClient 对象
+void HttpMulti::clear() {
+	for ( size_t i=0; i<_reqs.size(); ++i ) {
+		if ( _reqs[i].fd >= 0 )
+			close( _reqs[i].fd );
+	}
+	_reqs.clear();
+	_active = 0;
+}
+
+/// 开始执行HTTP请求
+/// \param index 请求位置
+/// \param pooled 是否使用连接池中的空闲连接
+void HttpMulti::start_req( const size_t index, const bool pooled ) {
+	http_req &req = _reqs[index];
+	HttpClient &client = *req.client;
+	++_active;
+
+	req.sent = 0;
+	req.fd = pooled ? HttpClient::pool_get( req.addr, req.port ) : -1;
+	req.reused = ( req.fd >= 0 );
+	client._response = "";
+	client.frame_init();
+
+	if ( req.reused ) {
+		req.state = STATE_SEND;
+		if ( !HttpClient::set_nonblock(req.fd,true) ) {
+			this->finish_req( req, HttpClient::ERROR_SEND_REQUEST );
+			return;
+		}
+	} else {
+		bool connected;
+		int res = HttpClient::connect_start( req.addr, req.port, req.fd, connected );
+		if ( res != HttpClient::ERROR_NULL ) {
+			this->finish_req( req, res );
+			return;
+		}
+		req.state = connected ? STATE_SEND : STATE_CONNECT;
+	}
+
+	// 连接完成及可以发送请求时均为可写
+	if ( !this->watch_req(index,EPOLLOUT,true) )
+		this->finish_req( req, HttpClient::ERROR_UNKNOWN );
+}
+
+/// 处理socket事件
+/// \param index 请求位置
+/// \param events epoll事件
+void HttpMulti::handle_req( const size_t index, const unsigned int events ) {
+	if ( index >= _reqs.size() )
+		return;
+	http_req &req = _reqs[index];
+
+	if ( req.state == STATE_CONNECT ) {
+		int res = HttpClient::connect_result( req.fd );
+		if ( res != HttpClient::ERROR_NULL ) {
+			this->finish_req( req, res );
+			return;
+		}
+		req.state = STATE_SEND;
+	}
+
+	if ( req.state == STATE_SEND ) {
+		if ( !this->send_req(req) ) {
+			// 空闲连接已被服务器关闭
+			if ( req.reused )
+				this->restart_req( index );
+			else
+				this->finish_req( req, HttpClient::ERROR_SEND_REQUEST );
+			return;
+		}
+
+		if ( req.sent == req.client->_request.length() ) {
+			req.state = STATE_RECV;
+			if ( !this->watch_req(index,EPOLLIN,false) )
+				this->finish_req( req, HttpClient::ERROR_UNKNOWN );
+		}
+		return;
+	}
+
+	if ( req.state == STATE_RECV && (events&(EPOLLIN|EPOLLERR|EPOLLHUP)) )
+		this->recv_req( index );
+}
+
+/// 发送请求
+/// 发送至socket发送缓冲区已满为止
+/// \param req 请求
+/// \retval true 成功
+/// \retval false 发送失败
+bool HttpMulti::send_req( http_req &req ) {
+	const string &request = req.client->_request;
+	while ( req.sent < request.length() ) {
+		ssize_t n = send( req.fd, request.data()+req.sent, request.length()-req.sent,
+			HTTPMULTI_SEND_FLAGS );
+		if ( n < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return ( errno==EAGAIN || errno==EWOULDBLOCK );
+		}
+		req.sent += n;
+	}
+	return true;
+}
+
+/// 读取回应
+/// 读取至socket接收缓冲区为空,回应读取完毕或连接关闭时完成请求
+/// \param index 请求位置
+void HttpMulti::recv_req( const size_t index ) {
+	http_req &req = _reqs[index];
+	HttpClient &client = *req.client;
+	char buff[HTTPMULTI_READ_SIZE];
+
+	while ( true ) {
+		ssize_t readed = recv( req.fd, buff, sizeof(buff), 0 );
+		if ( readed > 0 ) {
+			client._response.append( buff, readed );
+			if ( client.frame_response(req.head_only) ) {
+				this->finish_req( req, HttpClient::ERROR_NULL );
+				return;
+			}
+			if ( client._frame.error != HttpClient::ERROR_NULL ) {
+				this->finish_req( req, client._frame.error );
+				return;
+			}
+			continue;
+		}
+
+		if ( readed < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			if ( errno==EAGAIN || errno==EWOULDBLOCK )
+				return;
+		}
+
+		// connection closed
+		int error = client.frame_closed();
+		// 非幂等请求已发送时不能确定服务器是否已处理,不重新请求
+		if ( error==HttpClient::ERROR_RESPONSE_NULL && req.reused && req.idempotent )
+			this->restart_req( index );
+		else
+			this->finish_req( req, error );
+		return;
+	}
+}
+
+/// 以新建连接重新执行HTTP请求
+/// 用于复用的空闲连接在发送请求时,或者幂等请求在收到回应前被服务器关闭的情况
+/// \param index 请求位置
+void HttpMulti::restart_req( const size_t index ) {
+	http_req &req = _reqs[index];
+	struct epoll_event ev;
+	memset( &ev, 0, sizeof(ev) );
+	epoll_ctl( _epoll, EPOLL_CTL_DEL, req.fd, &ev );
+	close( req.fd );
+	req.fd = -1;
+	--_active;
+	this->start_req( index, false );
+}
+
+/// 完成HTTP请求
+/// 回应允许保持连接时将连接放回连接池,并分析HTTP返回
+/// \param req 请求
+/// \param error 错误信息代码
+void HttpMulti::finish_req( http_req &req, const int error ) {
+	HttpClient &client = *req.client;
+	if ( req.fd >= 0 ) {
+		struct epoll_event ev;
+		memset( &ev, 0, sizeof(ev) );
+		epoll_ctl( _epoll, EPOLL_CTL_DEL, req.fd, &ev );
+
+		// 连接池中的连接为阻塞模式
+		if ( error==HttpClient::ERROR_NULL && req.keepalive && client._frame.keepalive
+			 && HttpClient::set_nonblock(req.fd,false) )
+			HttpClient::pool_put( req.addr, req.port, req.fd );
+		else
+			close( req.fd );
+		req.fd = -1;
+	}
+
+	--_active;
+	req.state = STATE_DONE;
+	req.ok = client.finish( error );
+}
+
+/// 设置socket的epoll事件
+/// \param index 请求位置
+/// \param events epoll事件
+/// \param add 是否新加入epoll
+/// \retval true 成功
+/// \retval false 失败
+bool HttpMulti::watch_req( const size_t index, const unsigned int events, const bool add ) {
+	struct epoll_event ev;
+	memset( &ev, 0, sizeof(ev) );
+	ev.events = events;
+	ev.data.u32 = index;
+	return ( epoll_ctl(_epoll,add?EPOLL_CTL_ADD:EPOLL_CTL_MOD,_reqs[index].fd,&ev) == 0 );
+}
+
+} // namespace
+
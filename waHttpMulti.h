@@ -0,0 +1,101 @@
+/// \file waHttpMulti.h
+/// webapp::HttpMulti类头文件
+/// 基于epoll的HTTP请求并发执行类
+/// 依赖于 webapp::HttpClient
+/// 只支持Linux系统
+
+#ifndef _WEBAPPLIB_HTTPMULTI_H_
+#define _WEBAPPLIB_HTTPMULTI_H_
+
+#include <string>
+#include <vector>
+#include "waHttpClient.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+/// HTTP请求并发执行类
+/// 在当前线程中以epoll及非阻塞socket同时执行多个 HttpClient 请求,
+/// 执行完毕后各 HttpClient 的 status(),content(),get_header() 及 errnum()
+/// 与调用 HttpClient::request() 的结果相同,复用 HttpClient 连接池中的空闲连接
+class HttpMulti {
+	public:
+
+	/// 构造函数
+	HttpMulti();
+
+	/// 析构函数
+	virtual ~HttpMulti();
+
+	/// 添加HTTP请求
+	bool add( HttpClient &client, const string &url, const string &server = "",
+		const int port = 80, const string &method = "GET", const int timeout_ms = 5000 );
+
+	/// 并发执行全部HTTP请求
+	size_t run( const int timeout_ms = 0 );
+
+	/// 清空HTTP请求列表
+	void clear();
+
+	/// HTTP请求数量
+	inline size_t size() const {
+		return _reqs.size();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	private:
+
+	/// \enum HTTP请求执行状态
+	enum req_state {
+		STATE_CONNECT,					// 连接中
+		STATE_SEND,						// 发送请求
+		STATE_RECV,						// 读取回应
+		STATE_DONE						// 已完成
+	};
+
+	typedef struct {					// HTTP请求
+		HttpClient *client;				// 请求对象
+		string addr;					// 服务器IP
+		int port;						// 服务器端口
+		bool head_only;					// 回应是否只有回应头
+		bool keepalive;					// 是否使用连接池
+		bool idempotent;				// 请求是否幂等,复用的空闲连接被关闭时可以重新发送
+		int timeout;					// 超时时长,单位为毫秒,为0不判断超时
+		int fd;							// 连接socket
+		bool reused;					// 是否复用的空闲连接
+		req_state state;				// 执行状态
+		size_t sent;					// 已发送的请求长度
+		long long deadline;				// 超时时间,为0不判断超时
+		bool ok;						// 是否执行成功
+	} http_req;
+
+	/// 开始执行HTTP请求
+	void start_req( const size_t index, const bool pooled );
+	/// 处理socket事件
+	void handle_req( const size_t index, const unsigned int events );
+	/// 发送请求
+	bool send_req( http_req &req );
+	/// 读取回应
+	void recv_req( const size_t index );
+	/// 以新建连接重新执行HTTP请求
+	void restart_req( const size_t index );
+	/// 完成HTTP请求
+	void finish_req( http_req &req, const int error );
+	/// 设置socket的epoll事件
+	bool watch_req( const size_t index, const unsigned int events, const bool add );
+
+	/// 禁止调用拷贝构造函数
+	HttpMulti( HttpMulti &copy );
+	/// 禁止调用拷贝赋值操作
+	HttpMulti& operator = ( const HttpMulti& copy );
+
+	vector<http_req> _reqs;				// HTTP请求列表
+	int _epoll;							// epoll描述符
+	size_t _active;						// 执行中的请求数量
+};
+
+} // namespace
+
+#endif //_WEBAPPLIB_HTTPMULTI_H_
@@ -0,0 +1,738 @@
+/// \file waHttpServer.cpp
+/// HttpServer类实现文件
+
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "waString.h"
+#include "waEncode.h"
+#include "waHttpServer.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+// 请求头最大长度
+const size_t HTTPSERVER_MAX_HEAD = 65536;
+// 待发送回应数据超过该长度时暂停处理同一连接上的后续请求
+const size_t HTTPSERVER_MAX_OUTPUT = 1048576;
+// 单次读取数据长度
+const size_t HTTPSERVER_READ_SIZE = 16384;
+// 单次epoll_wait()最大事件数量
+const int HTTPSERVER_EVENTS = 256;
+
+#ifdef MSG_NOSIGNAL
+const int HTTPSERVER_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int HTTPSERVER_SEND_FLAGS = 0;
+#endif
+
+// 设置非阻塞模式
+static bool set_nonblock( const int fd ) {
+	int flags = fcntl( fd, F_GETFL, 0 );
+	if ( flags < 0 )
+		return false;
+	return ( fcntl(fd,F_SETFL,flags|O_NONBLOCK) == 0 );
+}
+
+// HTTP状态码描述
+static const char* status_reason( const int status ) {
+	switch ( status ) {
+		case 100: return "Continue";
+		case 200: return "OK";
+		case 201: return "Created";
+		case 204: return "No Content";
+		case 301: return "Moved Permanently";
+		case 302: return "Found";
+		case 303: return "See Other";
+		case 304: return "Not Modified";
+		case 400: return "Bad Request";
+		case 401: return "Unauthorized";
+		case 403: return "Forbidden";
+		case 404: return "Not Found";
+		case 405: return "Method Not Allowed";
+		case 408: return "Request Timeout";
+		case 411: return "Length Required";
+		case 413: return "Request Entity Too Large";
+		case 431: return "Request Header Fields Too Large";
+		case 500: return "Internal Server Error";
+		case 501: return "Not Implemented";
+		case 503: return "Service Unavailable";
+		case 505: return "HTTP Version Not Supported";
+		default: return "Unknown";
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////
+// HttpServer
+
+/// 构造函数
+HttpServer::HttpServer():
+_listen(-1), _ownlisten(false), _port(0), _epoll(-1), _running(false),
+_timeout(HTTPSERVER_TIMEOUT), _maxrequest(HTTPSERVER_MAX_REQUEST),
+_lastcheck(0), _datetime(0)
+{
+	_response = new Response( HttpServer::output_writer, this );
+	_response->set_buffer_size( 0 );
+}
+
+/// 析构函数
+/// 关闭全部连接及本对象创建的监听socket
+HttpServer::~HttpServer() {
+	while ( !_conns.empty() )
+		this->close_conn( _conns.begin()->first );
+	if ( _epoll >= 0 )
+		::close( _epoll );
+	if ( _ownlisten && _listen >= 0 )
+		::close( _listen );
+	delete _response;
+}
+
+/// 监听指定端口
+/// \param port 监听端口,为0则由系统分配,可由 port() 取得
+/// \param addr 监听地址,默认为空即全部地址
+/// \param reuseport 是否设置SO_REUSEPORT,多个进程各自监听同一端口时由内核分配连接,
+/// 系统不支持时忽略,默认为false
+/// \retval true 监听成功
+/// \retval false 失败
+bool HttpServer::listen( const int port, const string &addr, const bool reuseport ) {
+	struct sockaddr_in sa;
+	memset( &sa, 0, sizeof(sa) );
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons( port );
+	sa.sin_addr.s_addr = htonl( INADDR_ANY );
+	if ( addr!="" && inet_pton(AF_INET,addr.c_str(),&sa.sin_addr)!=1 )
+		return false;
+
+	int fd = ::socket( AF_INET, SOCK_STREAM, 0 );
+	if ( fd < 0 )
+		return false;
+
+	int on = 1;
+	setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on) );
+#ifdef SO_REUSEPORT
+	if ( reuseport )
+		setsockopt( fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on) );
+#endif
+	if ( ::bind(fd,(struct sockaddr*)&sa,sizeof(sa))<0 || ::listen(fd,SOMAXCONN)<0
+		 || !this->attach(fd) ) {
+		::close( fd );
+		return false;
+	}
+
+	_ownlisten = true;
+	return true;
+}
+
+/// 使用已创建的监听socket
+/// 用于多进程共享监听socket等场合,监听socket被设置为非阻塞模式,不由本对象关闭
+/// \param listen_fd 已调用 listen() 的socket
+/// \retval true 设置成功
+/// \retval false 失败
+bool HttpServer::attach( const int listen_fd ) {
+	if ( listen_fd<0 || !set_nonblock(listen_fd) )
+		return false;
+
+	if ( _ownlisten && _listen>=0 && _listen!=listen_fd )
+		::close( _listen );
+	_listen = listen_fd;
+	_ownlisten = false;
+
+	struct sockaddr_in sa;
+	socklen_t len = sizeof( sa );
+	_port = 0;
+	if ( getsockname(_listen,(struct sockaddr*)&sa,&len)==0 && sa.sin_family==AF_INET )
+		_port = ntohs( sa.sin_port );
+	return true;
+}
+
+/// 设置请求处理函数
+/// 请求路径等于该前缀或以"前缀/"开头时调用该处理函数,多个前缀匹配时选择最长者,
+/// 处理函数中环境变量 SCRIPT_NAME 为该前缀,PATH_INFO 为请求路径的其余部分
+/// \param path 请求路径前缀,如"/api","/"匹配全部请求
+/// \param handler 处理函数
+/// \param arg 传递给处理函数的参数
+void HttpServer::set_handler( const string &path, http_handler handler, void *arg ) {
+	string prefix = path;
+	if ( prefix=="" || prefix[0]!='/' )
+		prefix = "/" + prefix;
+	if ( prefix.length()>1 && prefix[prefix.length()-1]=='/' )
+		prefix.erase( prefix.length()-1 );
+
+	for ( size_t i=0; i<_routes.size(); ++i ) {
+		if ( _routes[i].path == prefix ) {
+			_routes[i].handler = handler;
+			_routes[i].arg = arg;
+			return;
+		}
+	}
+
+	http_route route;
+	route.path = prefix;
+	route.handler = handler;
+	route.arg = arg;
+	_routes.push_back( route );
+}
+
+/// 运行事件循环
+/// 直到调用 stop() 或出错才返回,返回前关闭全部连接
+/// \retval true 由 stop() 结束
+/// \retval false 未监听或出错
+bool HttpServer::run() {
+	if ( _listen < 0 )
+		return false;
+	if ( _epoll < 0 && (_epoll=epoll_create(HTTPSERVER_EVENTS)) < 0 )
+		return false;
+
+	struct epoll_event ev;
+	memset( &ev, 0, sizeof(ev) );
+	ev.events = EPOLLIN;
+	ev.data.fd = _listen;
+	if ( epoll_ctl(_epoll,EPOLL_CTL_ADD,_listen,&ev) < 0 )
+		return false;
+
+	struct epoll_event events[HTTPSERVER_EVENTS];
+	bool ok = true;
+	_running = true;
+
+	while ( _running ) {
+		int n = epoll_wait( _epoll, events, HTTPSERVER_EVENTS, 1000 );
+		if ( n < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			ok = false;
+			break;
+		}
+
+		for ( int i=0; i<n; ++i ) {
+			int fd = events[i].data.fd;
+			if ( fd == _listen ) {
+				this->accept_conn();
+				continue;
+			}
+
+			map<int,http_conn>::iterator conn = _conns.find( fd );
+			if ( conn == _conns.end() )
+				continue;
+
+			unsigned int revents = events[i].events;
+			if ( (revents&(EPOLLERR|EPOLLHUP)) && !(revents&EPOLLIN) ) {
+				this->close_conn( fd );
+				continue;
+			}
+			if ( (revents&EPOLLIN) && !this->read_conn(conn->second) ) {
+				this->close_conn( fd );
+				continue;
+			}
+			if ( !this->serve_conn(conn->second) )
+				this->close_conn( fd );
+		}
+
+		this->check_timeout();
+	}
+
+	epoll_ctl( _epoll, EPOLL_CTL_DEL, _listen, &ev );
+	while ( !_conns.empty() )
+		this->close_conn( _conns.begin()->first );
+	return ok;
+}
+
+/// 结束事件循环
+/// 可在请求处理函数或信号处理函数中调用,run() 在处理完当前事件后返回
+void HttpServer::stop() {
+	_running = false;
+}
+
+/// 接受新连接
+void HttpServer::accept_conn() {
+	while ( true ) {
+		struct sockaddr_in sa;
+		socklen_t len = sizeof( sa );
+		int fd = ::accept( _listen, (struct sockaddr*)&sa, &len );
+		if ( fd < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return; // EAGAIN, or out of resources
+		}
+
+		int on = 1;
+		setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on) );
+		if ( !set_nonblock(fd) ) {
+			::close( fd );
+			continue;
+		}
+
+		http_conn &conn = _conns[fd];
+		char addr[INET_ADDRSTRLEN] = {0};
+		if ( sa.sin_family == AF_INET )
+			inet_ntop( AF_INET, &sa.sin_addr, addr, sizeof(addr) );
+		conn.fd = fd;
+		conn.addr = addr;
+		conn.port = ntohs( sa.sin_port );
+		conn.sent = 0;
+		conn.active = time( 0 );
+		conn.events = 0;
+		conn.continued = false;
+		conn.eof = false;
+		conn.closing = false;
+
+		if ( !this->watch_conn(conn,EPOLLIN) )
+			this->close_conn( fd );
+	}
+}
+
+/// 读取请求数据
+/// \param conn 连接
+/// \retval true 读取成功或客户端已关闭发送
+/// \retval false 连接出错
+bool HttpServer::read_conn( http_conn &conn ) {
+	char buf[HTTPSERVER_READ_SIZE];
+	while ( true ) {
+		ssize_t n = ::recv( conn.fd, buf, sizeof(buf), 0 );
+		if ( n > 0 ) {
+			conn.input.append( buf, n );
+			conn.active = time( 0 );
+			if ( static_cast<size_t>(n) < sizeof(buf) )
+				return true;
+		} else if ( n == 0 ) {
+			conn.eof = true;
+			return true;
+		} else if ( errno == EINTR ) {
+			continue;
+		} else {
+			return ( errno==EAGAIN || errno==EWOULDBLOCK );
+		}
+	}
+}
+
+/// 处理请求并发送回应
+/// 依次处理已接收的完整请求,回应数据未发送完毕时等待连接可写
+/// \param conn 连接
+/// \retval true 成功
+/// \retval false 连接需要关闭
+bool HttpServer::serve_conn( http_conn &conn ) {
+	while ( true ) {
+		bool pending = false;
+		while ( !conn.closing ) {
+			if ( conn.output.length()-conn.sent >= HTTPSERVER_MAX_OUTPUT ) {
+				pending = true;
+				break;
+			}
+
+			CgiEnv env;
+			string body;
+			bool keepalive = false;
+			int ret = this->parse_request( conn, env, body, keepalive );
+			if ( ret == 0 )
+				break;
+
+			if ( ret == 1 ) {
+				this->handle_request( env, body, keepalive, conn.output );
+				if ( !keepalive )
+					conn.closing = true;
+			} else {
+				this->error_response( ret, false, conn.output );
+				conn.closing = true;
+			}
+		}
+
+		if ( !this->write_conn(conn) )
+			return false;
+		if ( conn.sent < conn.output.length() )
+			break; // wait for EPOLLOUT
+		if ( conn.closing || conn.eof )
+			return false;
+		if ( !pending )
+			break;
+	}
+
+	unsigned int events = ( conn.sent<conn.output.length() ) ? EPOLLOUT : EPOLLIN;
+	return this->watch_conn( conn, events );
+}
+
+/// 发送回应数据
+/// \param conn 连接
+/// \retval true 发送成功或暂时不可写
+/// \retval false 连接出错
+bool HttpServer::write_conn( http_conn &conn ) {
+	while ( conn.sent < conn.output.length() ) {
+		ssize_t n = ::send( conn.fd, conn.output.data()+conn.sent,
+			conn.output.length()-conn.sent, HTTPSERVER_SEND_FLAGS );
+		if ( n < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return ( errno==EAGAIN || errno==EWOULDBLOCK );
+		}
+		conn.sent += n;
+		conn.active = time( 0 );
+	}
+
+	conn.output.clear();
+	conn.sent = 0;
+	return true;
+}
+
+/// 设置连接的epoll事件
+/// \param conn 连接
+/// \param events epoll事件
+/// \retval true 设置成功
+/// \retval false 失败
+bool HttpServer::watch_conn( http_conn &conn, const unsigned int events ) {
+	if ( conn.events == events )
+		return true;
+
+	struct epoll_event ev;
+	memset( &ev, 0, sizeof(ev) );
+	ev.events = events;
+	ev.data.fd = conn.fd;
+	int op = ( conn.events==0 ) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+	if ( epoll_ctl(_epoll,op,conn.fd,&ev) < 0 )
+		return false;
+
+	conn.events = events;
+	return true;
+}
+
+/// 关闭连接
+/// \param fd 连接socket
+void HttpServer::close_conn( const int fd ) {
+	::close( fd );
+	_conns.erase( fd );
+}
+
+/// 关闭超时连接
+/// 每秒最多检查一次
+void HttpServer::check_timeout() {
+	time_t now = time( 0 );
+	if ( _timeout<=0 || now==_lastcheck )
+		return;
+	_lastcheck = now;
+
+	vector<int> expired;
+	for ( map<int,http_conn>::const_iterator i=_conns.begin(); i!=_conns.end(); ++i ) {
+		if ( now-i->second.active > _timeout )
+			expired.push_back( i->first );
+	}
+	for ( size_t i=0; i<expired.size(); ++i )
+		this->close_conn( expired[i] );
+}
+
+/// 分析请求
+/// 从连接已接收数据中读取一个完整请求,转换为CGI环境变量
+/// \param conn 连接,读取的请求从已接收数据中删除
+/// \param env 请求环境变量
+/// \param body 请求内容
+/// \param keepalive 回应后是否保持连接
+/// \return 读取到完整请求返回1,数据不完整返回0,请求出错返回HTTP状态码
+int HttpServer::parse_request( http_conn &conn, CgiEnv &env, string &body,
+	bool &keepalive )
+{
+	string &input = conn.input;
+
+	// empty lines between requests
+	size_t start = input.find_first_not_of( "\r\n" );
+	if ( start == input.npos ) {
+		input.clear();
+		return 0;
+	}
+	if ( start > 0 )
+		input.erase( 0, start );
+
+	// end of head
+	size_t headend = input.find( "\r\n\r\n" );
+	size_t headlen = 4;
+	size_t lfend = input.find( "\n\n" );
+	if ( lfend!=input.npos && (headend==input.npos || lfend<headend) ) {
+		headend = lfend;
+		headlen = 2;
+	}
+	if ( headend == input.npos )
+		return ( input.length()>HTTPSERVER_MAX_HEAD ) ? 431 : 0;
+	if ( headend > HTTPSERVER_MAX_HEAD )
+		return 431;
+
+	// request line: method uri protocol
+	size_t lineend = input.find( '\n' );
+	String line = input.substr( 0, lineend );
+	line.trim();
+	vector<String> items = line.split( " " );
+	if ( items.size()!=3 || items[1]=="" || items[1][0]!='/' )
+		return 400;
+	if ( items[2].compare(0,7,"HTTP/1.") != 0 )
+		return 505;
+
+	// headers
+	env.clear();
+	size_t pos = lineend + 1;
+	while ( pos < headend ) {
+		size_t next = input.find( '\n', pos );
+		if ( next==input.npos || next>headend )
+			next = headend;
+		String header = input.substr( pos, next-pos );
+		pos = next + 1;
+
+		size_t colon = header.find( ':' );
+		if ( colon == header.npos )
+			continue;
+		String name = header.substr( 0, colon );
+		String value = header.substr( colon+1 );
+		name.trim();
+		value.trim();
+		if ( name == "" )
+			continue;
+
+		name.upper();
+		name.replace_all( "-", "_" );
+		if ( name!="CONTENT_TYPE" && name!="CONTENT_LENGTH" )
+			name = "HTTP_" + name;
+
+		CgiEnv::iterator i = env.find( name );
+		if ( i == env.end() )
+			env[name] = value;
+		else
+			i->second += ( name=="HTTP_COOKIE" ? "; " : ", " ) + value;
+	}
+
+	// request body
+	if ( env.find("HTTP_TRANSFER_ENCODING") != env.end() )
+		return 411;
+
+	size_t length = 0;
+	CgiEnv::const_iterator cl = env.find( "CONTENT_LENGTH" );
+	if ( cl != env.end() ) {
+		if ( cl->second=="" || cl->second.find_first_not_of("0123456789")!=string::npos )
+			return 400;
+		length = strtoul( cl->second.c_str(), NULL, 10 );
+		if ( length > _maxrequest )
+			return 413;
+	}
+
+	if ( input.length() < headend+headlen+length ) {
+		// Expect: 100-continue
+		if ( !conn.continued && conn.output.length()==conn.sent ) {
+			CgiEnv::const_iterator expect = env.find( "HTTP_EXPECT" );
+			if ( expect!=env.end() && strcasecmp(expect->second.c_str(),"100-continue")==0 ) {
+				conn.output += "HTTP/1.1 100 Continue\r\n\r\n";
+				conn.continued = true;
+			}
+		}
+		return 0;
+	}
+	body.assign( input, headend+headlen, length );
+	input.erase( 0, headend+headlen+length );
+	conn.continued = false;
+
+	// keep-alive
+	String connection = env["HTTP_CONNECTION"];
+	connection.lower();
+	if ( items[2] == "HTTP/1.0" )
+		keepalive = ( connection.find("keep-alive") != connection.npos );
+	else
+		keepalive = ( connection.find("close") == connection.npos );
+
+	// CGI environment
+	string uri = items[1];
+	size_t query = uri.find( '?' );
+	string path = uri_decode( uri.substr(0,query) );
+
+	String host = env["HTTP_HOST"];
+	size_t port = host.find( ':' );
+	if ( port != host.npos )
+		host.erase( port );
+
+	env["GATEWAY_INTERFACE"] = "CGI/1.1";
+	env["SERVER_SOFTWARE"] = "webapplib";
+	env["SERVER_PROTOCOL"] = items[2];
+	env["SERVER_NAME"] = ( host!="" ) ? host : "localhost";
+	env["SERVER_PORT"] = itos( _port );
+	env["REQUEST_METHOD"] = items[0];
+	env["REQUEST_URI"] = uri;
+	env["QUERY_STRING"] = ( query!=uri.npos ) ? uri.substr(query+1) : "";
+	env["SCRIPT_NAME"] = path;
+	env["PATH_INFO"] = "";
+	env["REMOTE_ADDR"] = conn.addr;
+	env["REMOTE_PORT"] = itos( conn.port );
+	return 1;
+}
+
+/// 调用处理函数
+/// 处理函数运行期间 get_env(),Cgi,Cookie 读取该请求的数据,
+/// Response::current() 及 cout 输出至该请求
+/// \param env 请求环境变量
+/// \param body 请求内容
+/// \param keepalive 回应后是否保持连接
+/// \param output HTTP回应,追加至原有内容之后
+void HttpServer::handle_request( CgiEnv &env, const string &body,
+	const bool keepalive, string &output )
+{
+	string path = env["SCRIPT_NAME"];
+	const http_route *route = this->find_route( path );
+	if ( route == NULL ) {
+		this->error_response( 404, keepalive, output );
+		return;
+	}
+	if ( route->path != "/" ) {
+		env["SCRIPT_NAME"] = route->path;
+		env["PATH_INFO"] = path.substr( route->path.length() );
+	} else {
+		env["SCRIPT_NAME"] = "";
+		env["PATH_INFO"] = path;
+	}
+
+	// redirect request
+	_cgiout.clear();
+	set_cgi_request( &env, &body );
+	Response::current();
+	_response->reset();
+	Response::set_current( _response );
+
+	route->handler( route->arg );
+
+	// restore output
+	_response->finish();
+	Response::set_current( NULL );
+	set_cgi_request( NULL, NULL );
+
+	this->make_response( _cgiout, env["REQUEST_METHOD"]=="HEAD", keepalive, output );
+}
+
+/// 生成HTTP回应
+/// 将CGI格式的处理函数输出转换为HTTP/1.1回应,
+/// "Status"回应头转换为状态行,重新设置"Content-Length"及"Connection"回应头
+/// \param cgiout 处理函数输出
+/// \param head_only 是否只输出回应头
+/// \param keepalive 回应后是否保持连接
+/// \param output HTTP回应,追加至原有内容之后
+void HttpServer::make_response( const string &cgiout, const bool head_only,
+	const bool keepalive, string &output )
+{
+	// CGI head
+	size_t headend = cgiout.find( "\n\n" );
+	size_t bodypos = headend + 2;
+	size_t crlfend = cgiout.find( "\r\n\r\n" );
+	if ( crlfend!=cgiout.npos && (headend==cgiout.npos || crlfend<headend) ) {
+		headend = crlfend;
+		bodypos = crlfend + 4;
+	}
+	if ( headend == cgiout.npos ) {
+		// no head, all as body
+		headend = 0;
+		bodypos = 0;
+	}
+
+	string status;
+	string headers;
+	bool location = false;
+	bool type = false;
+
+	size_t pos = 0;
+	while ( pos < headend ) {
+		size_t next = cgiout.find( '\n', pos );
+		if ( next==cgiout.npos || next>headend )
+			next = headend;
+		String header = cgiout.substr( pos, next-pos );
+		pos = next + 1;
+
+		size_t colon = header.find( ':' );
+		if ( colon == header.npos )
+			continue;
+		String name = header.substr( 0, colon );
+		String value = header.substr( colon+1 );
+		name.trim();
+		value.trim();
+
+		if ( strcasecmp(name.c_str(),"Status") == 0 ) {
+			status = value;
+			if ( status.find(' ') == status.npos )
+				status += string( " " ) + status_reason( atoi(status.c_str()) );
+			continue;
+		}
+		if ( strcasecmp(name.c_str(),"Content-Length")==0 ||
+			 strcasecmp(name.c_str(),"Connection")==0 )
+			continue;
+		if ( strcasecmp(name.c_str(),"Location") == 0 )
+			location = true;
+		if ( strcasecmp(name.c_str(),"Content-Type") == 0 )
+			type = true;
+		headers += name + ": " + value + "\r\n";
+	}
+
+	if ( status == "" )
+		status = location ? "302 Found" : "200 OK";
+	if ( !type && !location )
+		headers += "Content-Type: text/html\r\n";
+
+	size_t length = cgiout.length() - bodypos;
+	output.reserve( output.length() + headers.length() + length + 128 );
+	output += "HTTP/1.1 " + status + "\r\n";
+	output += "Date: " + this->http_date() + "\r\n";
+	output += headers;
+	output += "Content-Length: " + itos( length ) + "\r\n";
+	output += keepalive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+	if ( !head_only )
+		output.append( cgiout, bodypos, length );
+}
+
+/// 生成出错回应
+/// \param status HTTP状态码
+/// \param keepalive 回应后是否保持连接
+/// \param output HTTP回应,追加至原有内容之后
+void HttpServer::error_response( const int status, const bool keepalive, string &output ) {
+	string reason = itos( status ) + " " + status_reason( status );
+	this->make_response( "Status: " + reason + "\nContent-Type: text/html\n\n"
+		"<html><body><h1>" + reason + "</h1></body></html>\n", false, keepalive, output );
+}
+
+/// 查找请求处理函数
+/// \param path 请求路径
+/// \return 前缀匹配的最长者,未找到返回NULL
+const HttpServer::http_route* HttpServer::find_route( const string &path ) const {
+	const http_route *found = NULL;
+	for ( size_t i=0; i<_routes.size(); ++i ) {
+		const string &prefix = _routes[i].path;
+		bool match = ( prefix == "/" ) || ( path.compare(0,prefix.length(),prefix)==0 &&
+			(path.length()==prefix.length() || path[prefix.length()]=='/') );
+		if ( match && (found==NULL || prefix.length()>found->path.length()) )
+			found = &_routes[i];
+	}
+	return found;
+}
+
+/// 当前时间HTTP格式字符串
+/// \return 如"Sun, 06 Nov 1994 08:49:37 GMT",每秒更新一次
+const string& HttpServer::http_date() {
+	time_t now = time( 0 );
+	if ( now != _datetime ) {
+		char buf[64];
+		struct tm gmt;
+		gmtime_r( &now, &gmt );
+		strftime( buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &gmt );
+		_date = buf;
+		_datetime = now;
+	}
+	return _date;
+}
+
+/// Response输出函数
+/// \param iov 数据块列表
+/// \param iovcnt 数据块数量
+/// \param arg HttpServer对象
+/// \retval true 输出成功
+bool HttpServer::output_writer( const struct iovec *iov, const int iovcnt, void *arg ) {
+	string &out = static_cast<HttpServer*>( arg )->_cgiout;
+	for ( int i=0; i<iovcnt; ++i )
+		out.append( static_cast<const char*>(iov[i].iov_base), iov[i].iov_len );
+	return true;
+}
+
+} // namespace
@@ -0,0 +1,174 @@
+/// \file waHttpServer.h
+/// webapp::HttpServer类头文件
+/// 基于epoll的内嵌HTTP/1.1服务器类,以Cgi方式调用请求处理函数
+/// 依赖于 webapp::Cgi, webapp::Response
+/// 只支持Linux系统
+
+#ifndef _WEBAPPLIB_HTTPSERVER_H_
+#define _WEBAPPLIB_HTTPSERVER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+#include "waCgi.h"
+#include "waResponse.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+/// \defgroup waHttpServer waHttpServer相关数据类型与全局函数
+
+/// \ingroup waHttpServer
+/// \typedef http_handler
+/// HTTP请求处理函数类型,参数为 HttpServer::set_handler() 指定的参数,
+/// 处理函数中 get_env(),Cgi,Cookie 读取当前请求数据,
+/// http_head(),Template::print() 及 cout 输出至当前请求
+typedef void (*http_handler)( void *arg );
+
+/// \ingroup waHttpServer
+/// 默认连接空闲超时时间,单位为秒
+const int HTTPSERVER_TIMEOUT = 30;
+
+/// \ingroup waHttpServer
+/// 默认请求内容最大长度,单位为byte
+const size_t HTTPSERVER_MAX_REQUEST = 8*1024*1024;
+
+/// 内嵌HTTP/1.1服务器类
+/// 单线程epoll事件循环,支持keep-alive及pipelining,
+/// 按请求路径前缀调用 set_handler() 设置的处理函数,
+/// 处理函数的输出在函数返回后以HTTP回应发送
+class HttpServer {
+	public:
+
+	/// 构造函数
+	HttpServer();
+
+	/// 析构函数
+	virtual ~HttpServer();
+
+	/// 监听指定端口
+	bool listen( const int port, const string &addr = "", const bool reuseport = false );
+	/// 使用已创建的监听socket
+	bool attach( const int listen_fd );
+
+	/// 监听端口
+	/// \return 监听端口,未监听时为0
+	inline int port() const {
+		return _port;
+	}
+
+	/// 监听socket
+	/// \return 监听socket,未监听时为-1
+	inline int listen_fd() const {
+		return _listen;
+	}
+
+	/// 设置请求处理函数
+	void set_handler( const string &path, http_handler handler, void *arg = NULL );
+
+	/// 设置连接空闲超时时间
+	/// \param timeout 超时时间,单位为秒,为0则不超时
+	inline void set_timeout( const int timeout ) {
+		_timeout = timeout;
+	}
+
+	/// 设置请求内容最大长度
+	/// \param size 最大长度,单位为byte,超过时回应"413 Request Entity Too Large"
+	inline void set_max_request( const size_t size ) {
+		_maxrequest = size;
+	}
+
+	/// 运行事件循环
+	bool run();
+	/// 结束事件循环
+	void stop();
+
+	/// 当前连接数量
+	inline size_t connections() const {
+		return _conns.size();
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	private:
+
+	typedef struct {					// 连接状态
+		int fd;							// 连接socket
+		string addr;					// 客户端地址
+		int port;						// 客户端端口
+		string input;					// 未处理的请求数据
+		string output;					// 待发送的回应数据
+		size_t sent;					// 已发送的回应数据长度
+		time_t active;					// 最后活动时间
+		unsigned int events;			// 已注册的epoll事件
+		bool continued;					// 是否已发送"100 Continue"
+		bool eof;						// 客户端是否已关闭发送
+		bool closing;					// 回应发送完毕后关闭连接
+	} http_conn;
+
+	typedef struct {					// 请求处理函数
+		string path;					// 请求路径前缀
+		http_handler handler;			// 处理函数
+		void *arg;						// 处理函数参数
+	} http_route;
+
+	/// 接受新连接
+	void accept_conn();
+	/// 读取请求数据
+	bool read_conn( http_conn &conn );
+	/// 处理请求并发送回应
+	bool serve_conn( http_conn &conn );
+	/// 发送回应数据
+	bool write_conn( http_conn &conn );
+	/// 设置连接的epoll事件
+	bool watch_conn( http_conn &conn, const unsigned int events );
+	/// 关闭连接
+	void close_conn( const int fd );
+	/// 关闭超时连接
+	void check_timeout();
+
+	/// 分析请求
+	int parse_request( http_conn &conn, CgiEnv &env, string &body, bool &keepalive );
+	/// 调用处理函数
+	void handle_request( CgiEnv &env, const string &body,
+		const bool keepalive, string &output );
+	/// 生成HTTP回应
+	void make_response( const string &cgiout, const bool head_only,
+		const bool keepalive, string &output );
+	/// 生成出错回应
+	void error_response( const int status, const bool keepalive, string &output );
+	/// 查找请求处理函数
+	const http_route* find_route( const string &path ) const;
+	/// 当前时间HTTP格式字符串
+	const string& http_date();
+	/// Response输出函数
+	static bool output_writer( const struct iovec *iov, const int iovcnt, void *arg );
+
+	/// 禁止调用拷贝构造函数
+	HttpServer( HttpServer &copy );
+	/// 禁止调用拷贝赋值操作
+	HttpServer& operator = ( const HttpServer& copy );
+
+	int _listen;						// 监听socket
+	bool _ownlisten;					// 是否由本对象关闭监听socket
+	int _port;							// 监听端口
+	int _epoll;							// epoll描述符
+	volatile bool _running;				// 事件循环是否运行中
+	int _timeout;						// 连接空闲超时时间
+	size_t _maxrequest;					// 请求内容最大长度
+	time_t _lastcheck;					// 上次检查超时时间
+
+	map<int,http_conn> _conns;			// 连接列表
+	vector<http_route> _routes;			// 请求处理函数列表
+
+	string _cgiout;						// 当前请求处理函数输出
+	Response *_response;				// 当前请求回应对象
+	time_t _datetime;					// _date 对应时间
+	string _date;						// 当前时间HTTP格式字符串
+};
+
+} // namespace
+
+#endif //_WEBAPPLIB_HTTPSERVER_H_
@@ -1,7 +1,7 @@
 /// \file waMysqlClient.cpp
-/// webapp::MysqlClient,webapp::MysqlDataʵļ
+/// webapp::MysqlClient,webapp::MysqlData类实现文件
 
-// :
+// 编译参数:
 // (CC) -I /usr/local/include/mysql/ -L /usr/local/lib/mysql -lmysqlclient -lm
 
 #include <cstring>
@@ -14,9 +14,9 @@ namespace webapp {
 
 /// \ingroup waMysqlClient
 /// \fn string escape_sql( const string &str )
-/// SQLַת
-/// \param ҪתSQLַ
-/// \return תַ
+/// SQL语句字符转义
+/// \param 要转换的SQL字符串
+/// \return 转义过的字符串
 string escape_sql( const string &str ) {
 	char *p = new char[str.length()*2+1];
 	mysql_escape_string( p, str.c_str(), str.length() );
@@ -28,7 +28,7 @@ string escape_sql( const string &str ) {
 ////////////////////////////////////////////////////////////////////////////
 // MysqlData
 
-/// MysqlData
+/// MysqlData析构函数
 MysqlData::~MysqlData() {
 	if ( _mysqlres != NULL )
 		mysql_free_result( _mysqlres );
@@ -36,14 +36,14 @@ MysqlData::~MysqlData() {
 	_mysqlfields = 0;
 }
 
-/// ָλõMysqlData
-/// \param row λ,ĬΪ0
-/// \param col λ,ĬΪ0
-/// \return ,򷵻ؿַ
+/// 返回指定位置的MysqlData数据
+/// \param row 数据行位置,默认为0
+/// \param col 数据列位置,默认为0
+/// \return 返回数据,不存在则返回空字符串
 string MysqlData::get_data( const size_t row, const size_t col ) {
 	if( _mysqlres!=NULL && row<_rows && col<_cols ) {
 		if ( row != _fetched ) {
-			if ( row != _curpos+1 ) {
+			if ( row != _fetched+1 ) {
 				mysql_data_seek( _mysqlres, row );
 			}
 			_mysqlrow = mysql_fetch_row( _mysqlres );
@@ -58,10 +58,10 @@ string MysqlData::get_data( const size_t row, const size_t col ) {
 	return string( "" );
 }
 
-/// ֶָεMysqlData
-/// \param row λ
-/// \param field ֶ
-/// \return ַ,ڷؿַ
+/// 返回指定字段的MysqlData数据
+/// \param row 行位置
+/// \param field 字段名
+/// \return 数据字符串,不存在返回空字符串
 string MysqlData::get_data( const size_t row, const string &field ) {
 	int col = this->field_pos( field );
 	if ( col != -1 )
@@ -70,19 +70,20 @@ string MysqlData::get_data( const size_t row, const string &field ) {
 		return string( "" );
 }
 
-/// ָλõMysqlData
-/// \param row λ,ĬΪ0һ
-/// \return ֵΪMysqlDataRow,map<string,string>
+/// 返回指定位置的MysqlData数据行
+/// \param row 数据行位置,默认为0即第一行
+/// \return 返回值类型为MysqlDataRow,即map<string,string>
 MysqlDataRow MysqlData::get_row( const size_t row ) {
 	MysqlDataRow datarow;
 	string field;
 		
 	if( _mysqlres!=NULL && row<_rows ) {
-		if ( row != _curpos ) {
-			if ( row != _curpos+1 ) {
+		if ( row != _fetched ) {
+			if ( row != _fetched+1 ) {
 				mysql_data_seek( _mysqlres, row );
 			}
 			_mysqlrow = mysql_fetch_row( _mysqlres );
+			_fetched = row;
 		}
 		
 		if ( _mysqlrow != NULL ) {
@@ -99,10 +100,40 @@ MysqlDataRow MysqlData::get_row( const size_t row ) {
 	return datarow;
 }
 
-/// MysqlData
-/// \param mysql MYSQL*
-/// \retval true ɹ
-/// \retval false ʧ
+/// 移动到指定行
+/// 由 Template 输出循环时调用,顺序读取时不重新定位
+/// \param row 行位置
+/// \retval true 成功
+/// \retval false 该行不存在
+bool MysqlData::fetch( const size_t row ) {
+	if ( _mysqlres==NULL || row>=_rows )
+		return false;
+	if ( row != _fetched ) {
+		if ( row != _fetched+1 )
+			mysql_data_seek( _mysqlres, row );
+		_mysqlrow = mysql_fetch_row( _mysqlres );
+		_fetched = row;
+	}
+	return ( _mysqlrow != NULL );
+}
+
+/// 返回当前行指定位置的数据
+/// 数据不复制,直接指向查询结果,当前行由 fetch() 指定
+/// \param col 列位置
+/// \param length 数据长度
+/// \return 数据,不存在或为NULL值时返回NULL
+const char* MysqlData::value( const int col, size_t &length ) {
+	if ( _mysqlrow==NULL || col<0 || static_cast<size_t>(col)>=_cols || _mysqlrow[col]==NULL )
+		return NULL;
+	unsigned long *lengths = mysql_fetch_lengths( _mysqlres );
+	length = ( lengths!=NULL ) ? lengths[col] : strlen( _mysqlrow[col] );
+	return _mysqlrow[col];
+}
+
+/// 填充MysqlData数据
+/// \param mysql MYSQL*参数
+/// \retval true 成功
+/// \retval false 失败
 bool MysqlData::fill_data( MYSQL *mysql ) {
 	if ( mysql == NULL )
 		return false;
@@ -131,9 +162,9 @@ bool MysqlData::fill_data( MYSQL *mysql ) {
 	return false;
 }
 
-/// ֶλ
-/// \param field ֶ
-/// \return ݽдڸֶ򷵻ֶλ,򷵻-1
+/// 返回字段位置
+/// \param field 字段名
+/// \return 若数据结果中存在该字段则返回字段位置,否则返回-1
 int MysqlData::field_pos( const string &field ) {
 	if ( _mysqlfields==0 || field=="" )
 		return -1;
@@ -152,9 +183,9 @@ int MysqlData::field_pos( const string &field ) {
 	return -1;
 }
 
-/// ֶ
-/// \param col ֶλ
-/// \return ݽдڸֶ򷵻ֶ,򷵻ؿַ
+/// 返回字段名称
+/// \param col 字段位置
+/// \return 若数据结果中存在该字段则返回字段名称,否则返回空字符串
 string MysqlData::field_name( size_t col ) const {
 	if ( _mysqlfields!=0 && col<=_cols )
 		return string( _mysqlfields[col].name );
@@ -165,15 +196,15 @@ string MysqlData::field_name( size_t col ) const {
 ////////////////////////////////////////////////////////////////////////////
 // MysqlClient
 
-/// ݿ
-/// \param host MySQLIP
-/// \param user MySQLû
-/// \param pwd û
-/// \param database Ҫ򿪵ݿ
-/// \param port ݿ˿ڣĬΪ0
-/// \param socket UNIX_SOCKETĬΪNULL
-/// \retval true ɹ
-/// \retval false ʧ
+/// 连接数据库
+/// \param host MySQL主机IP
+/// \param user MySQL用户名
+/// \param pwd 用户口令
+/// \param database 要打开的数据库
+/// \param port 数据库端口，默认为0
+/// \param socket UNIX_SOCKET，默认为NULL
+/// \retval true 成功
+/// \retval false 失败
 bool MysqlClient::connect( const string &host, const string &user, const string &pwd, 
 	const string &database, const int port, const char* socket ) 
 {
@@ -188,7 +219,7 @@ bool MysqlClient::connect( const string &host, const string &user, const string
 	return _connected;
 }
 
-/// Ͽݿ
+/// 断开数据库连接
 void MysqlClient::disconnect() {
 	if( _connected ) {
 		mysql_close( &_mysql );
@@ -196,9 +227,9 @@ void MysqlClient::disconnect() {
 	}
 }
 
-/// жǷݿ
-/// \retval true 
-/// \retval false Ͽ
+/// 判断是否连接数据库
+/// \retval true 连接
+/// \retval false 断开
 bool MysqlClient::is_connected() {
 	if ( _connected ) {
 		if ( mysql_ping(&_mysql) == 0 )
@@ -210,10 +241,10 @@ bool MysqlClient::is_connected() {
 	return _connected;
 }
 
-/// ѡݿ
-/// \param database ݿ
-/// \retval true ɹ
-/// \retval false ʧ
+/// 选择数据库
+/// \param database 数据库名
+/// \retval true 成功
+/// \retval false 失败
 bool MysqlClient::select_db( const string &database ) {
 	if ( _connected && mysql_select_db(&_mysql,database.c_str())==0 )
 		return true;
@@ -221,11 +252,11 @@ bool MysqlClient::select_db( const string &database ) {
 		return false;
 }
 
-/// ִSQL,ȡòѯ
-/// \param sqlstr ҪִеSQL
-/// \param records ݽMysqlData
-/// \retval true ɹ
-/// \retval false ʧ
+/// 执行SQL语句,取得查询结果
+/// \param sqlstr 要执行的SQL语句
+/// \param records 保存数据结果的MysqlData对象
+/// \retval true 成功
+/// \retval false 失败
 bool MysqlClient::query( const string &sqlstr, MysqlData &records ) {
 	if ( _connected && mysql_real_query(&_mysql,sqlstr.c_str(),sqlstr.length())==0 ) {
 		if( records.fill_data(&_mysql) )
@@ -234,10 +265,10 @@ bool MysqlClient::query( const string &sqlstr, MysqlData &records ) {
 	return false;
 }
 
-/// ִSQL
-/// \param sqlstr ҪִеSQL
-/// \retval true ɹ
-/// \retval false ʧ
+/// 执行SQL语句
+/// \param sqlstr 要执行的SQL语句
+/// \retval true 成功
+/// \retval false 失败
 bool MysqlClient::query( const string &sqlstr ) {
 	if ( _connected && mysql_real_query(&_mysql,sqlstr.c_str(),sqlstr.length())==0 )
 		return true;			
@@ -245,11 +276,11 @@ bool MysqlClient::query( const string &sqlstr ) {
 		return false;
 }
 
-/// زѯָλõֵַ
-/// \param sqlstr SQLѯַ
-/// \param row λ,ĬΪ0
-/// \param col λ,ĬΪ0
-/// \return ѯɹַ,򷵻ؿַ
+/// 返回查询结果中指定位置的字符串值
+/// \param sqlstr SQL查询字符串
+/// \param row 数据行位置,默认为0
+/// \param col 数据列位置,默认为0
+/// \return 查询成功返回字符串,否则返回空字符串
 string MysqlClient::query_val( const string &sqlstr, const size_t row, 
 	const size_t col ) 
 {
@@ -261,10 +292,10 @@ string MysqlClient::query_val( const string &sqlstr, const size_t row,
 	return string( "" );
 }
 
-/// زѯָ
-/// \param sqlstr SQLѯַ
-/// \param row λ,ĬΪ0
-/// \return ֵΪMysqlDataRow,map<string,string>
+/// 返回查询结果中指定行
+/// \param sqlstr SQL查询字符串
+/// \param row 数据行位置,默认为0
+/// \return 返回值类型为MysqlDataRow,即map<string,string>
 MysqlDataRow MysqlClient::query_row( const string &sqlstr, const size_t row ) {
     MysqlData data;
     MysqlDataRow datarow;
@@ -276,8 +307,8 @@ MysqlDataRow MysqlClient::query_row( const string &sqlstr, const size_t row ) {
     return datarow;
 }
 
-/// ϴβѯӰļ¼
-/// \return ؼ¼,size_t
+/// 上次查询动作所影响的记录条数
+/// \return 返回记录条数,类型size_t
 size_t MysqlClient::affected() {
 	if ( _connected )
 		return mysql_affected_rows( &_mysql );
@@ -285,9 +316,9 @@ size_t MysqlClient::affected() {
 		return 0;
 }
 
-/// ȡϴβѯһAUTO_INCREMENTɵID
-/// һMysqlֻһAUTO_INCREMENT,ұΪ
-/// \return ɵID
+/// 取得上次查询的一个AUTO_INCREMENT列生成的ID
+/// 一个Mysql表只能有一个AUTO_INCREMENT列,且必须为索引
+/// \return 返回生成的ID
 size_t MysqlClient::last_id() {
 	if ( _connected )
 		return mysql_insert_id( &_mysql );
@@ -295,8 +326,8 @@ size_t MysqlClient::last_id() {
 		return 0;
 }
 
-/// ȡøϢ
-/// \return ظϢ
+/// 取得更新信息
+/// \return 返回更新信息
 string MysqlClient::info() {
 	if ( _connected )
 		return string( mysql_info(&_mysql) );
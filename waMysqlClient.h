@@ -1,8 +1,9 @@
 /// \file waMysqlClient.h
-/// webapp::ysqlClient,webapp::MysqlDataͷļ
-/// MySQLݿC++ӿ
+/// webapp::ysqlClient,webapp::MysqlData类头文件
+/// MySQL数据库C++接口
+/// 依赖于 waTemplate
 
-// :
+// 编译参数:
 // (CC) -I /usr/local/include/mysql/ -L /usr/local/lib/mysql -lmysqlclient -lm
 
 #ifndef _WEBAPPLIB_MYSQLCLIENT_H_
@@ -12,29 +13,31 @@
 #include <vector>
 #include <map>
 #include <mysql.h>
+#include "waTemplate.h"
 
 using namespace std;
 
 /// Web Application Library namaspace
 namespace webapp {
 
-/// \defgroup waMysqlClient waMysqlClientȫֺ
+/// \defgroup waMysqlClient waMysqlClient相关数据类型与全局函数
 
 /// \ingroup waMysqlClient
 /// \typedef MysqlDataRow 
-/// MysqlData  (map<string,string>)
+/// MysqlData 数据行类型 (map<string,string>)
 typedef map<string,string> MysqlDataRow;
 
-/// SQLַת
+/// SQL语句字符转义
 string escape_sql( const string &str );
 
-/// MySQLݼ
-class MysqlData {
+/// MySQL数据集类
+/// 可作为 Template::set_loop() 的循环数据源,输出时直接读取查询结果数据
+class MysqlData : public TemplateSource {
 	friend class MysqlClient;
 	
 	protected:
 	
-	/// MysqlData
+	/// 填充MysqlData数据
 	bool fill_data( MYSQL *mysql );
 	
 	size_t _rows, _cols, _curpos;
@@ -48,77 +51,82 @@ class MysqlData {
 	////////////////////////////////////////////////////////////////////////////
 	public:
 
-	/// MysqlData캯
+	/// MysqlData构造函数
 	MysqlData():
 	_rows(0), _cols(0), _curpos(0), _fetched(0),
 	_mysqlres(0), _mysqlfields(0)
 	{};
 	
-	/// MysqlData
+	/// MysqlData析构函数
 	virtual ~MysqlData();
 	
-	/// ָλõMysqlData
-	/// \param row λ
-	/// \param col λ
-	/// \return ַ
+	/// 返回指定位置的MysqlData数据
+	/// \param row 行位置
+	/// \param col 列位置
+	/// \return 数据字符串
 	inline string operator() ( const size_t row, const size_t col ) {
 		return this->get_data( row, col );
 	}
-	/// ָλõMysqlData
+	/// 返回指定位置的MysqlData数据
 	string get_data( const size_t row, const size_t col );
 
-	/// ֶָεMysqlData
-	/// \param row λ
-	/// \param field ֶ
-	/// \return ַ
+	/// 返回指定字段的MysqlData数据
+	/// \param row 行位置
+	/// \param field 字段名
+	/// \return 数据字符串
 	inline string operator() ( const size_t row, const string &field ) {
 		return this->get_data( row, field );
 	}
-	/// ֶָεMysqlData
+	/// 返回指定字段的MysqlData数据
 	string get_data( const size_t row, const string &field );
 
-	/// ָλõMysqlData
+	/// 返回指定位置的MysqlData数据行
 	MysqlDataRow get_row( const size_t row = 0 );
 
-	/// MysqlData
+	/// 返回MysqlData数据行数
 	inline size_t rows() const {
 		return _rows;
 	}
-	/// MysqlData
+	/// 返回MysqlData数据列数
 	inline size_t cols() const {
 		return _cols;
 	}
 	
-	/// ֶλ
+	/// 返回字段位置
 	int field_pos( const string &field );
-	/// ֶ
+	/// 返回字段名称
 	string field_name( const size_t col ) const;
 
+	/// 移动到指定行
+	bool fetch( const size_t row );
+	/// 返回当前行指定位置的数据
+	const char* value( const int col, size_t &length );
+
 	////////////////////////////////////////////////////////////////////////////
 	private:
 	
-	/// ֹÿ캯
+	/// 禁止调用拷贝构造函数
 	MysqlData( MysqlData &copy );
-	/// ֹÿֵ
+	/// 禁止调用拷贝赋值操作
 	MysqlData& operator = ( const MysqlData& copy );
 };
 
-/// MySQLݿ
+/// MySQL数据库连接类
 class MysqlClient {
 	public:
 	
-	/// MysqlĬϹ캯
+	/// Mysql默认构造函数
 	MysqlClient():
 	_connected(false)
 	{};
 	
-	/// Mysql캯
-	/// \param host MySQLIP
-	/// \param user MySQLû
-	/// \param pwd û
-	/// \param database Ҫ򿪵ݿ
-	/// \param port ݿ˿ڣĬΪ0
-	/// \param socket UNIX_SOCKETĬΪNULL
+	/// Mysql构造函数
+	/// \param host MySQL主机IP
+	/// \param user MySQL用户名
+	/// \param pwd 用户口令
+	/// \param database 要打开的数据库
+	/// \param port 数据库端口，默认为0
+	/// \param socket UNIX_SOCKET，默认为NULL
 	MysqlClient( const string &host, const string &user, const string &pwd, 
 		const string &database, const int port = 0, const char* socket = NULL ):
 	_connected(false) 
@@ -126,59 +134,59 @@ class MysqlClient {
 		this->connect( host, user, pwd, database, port, socket );
 	}
 	
-	/// Mysql
+	/// Mysql析构函数
 	virtual ~MysqlClient() {
 		this->disconnect();
 	}
 	
-	/// ݿ
+	/// 连接数据库
 	bool connect( const string &host, const string &user, const string &pwd, 
 		const string &database, const int port = 0, const char* socket = NULL );
-	/// Ͽݿ
+	/// 断开数据库连接
 	void disconnect();
-	/// жǷݿ
+	/// 判断是否连接数据库
 	bool is_connected();
 	
-	/// ѡݿ
+	/// 选择数据库
 	bool select_db( const string &database );
 
-	/// ִSQL,ȡòѯ
+	/// 执行SQL语句,取得查询结果
 	bool query( const string &sqlstr, MysqlData &records );
-	/// ִSQL
+	/// 执行SQL语句
 	bool query( const string &sqlstr );
 	
-	/// زѯָλõֵַ
+	/// 返回查询结果中指定位置的字符串值
 	string query_val( const string &sqlstr, 
 		const size_t row = 0, const size_t col = 0 );
 	
-	/// زѯָ
+	/// 返回查询结果中指定行
 	MysqlDataRow query_row( const string &sqlstr, const size_t row = 0 );
 
-	/// ϴβѯӰļ¼
+	/// 上次查询动作所影响的记录条数
 	size_t affected();
-	/// ȡϴβѯһAUTO_INCREMENTɵID
+	/// 取得上次查询的一个AUTO_INCREMENT列生成的ID
 	size_t last_id();
 	
-	/// ȡMysqlϢ
-	/// \return شϢַ
+	/// 取得Mysql错误信息
+	/// \return 返回错误信息字符串
 	inline string error() {
 		return string( mysql_error(&_mysql) );
 	}
-	/// ȡMysql
-	/// \return شϢ
+	/// 取得Mysql错误编号
+	/// \return 返回错误信息编号
 	inline size_t errnum() {
 		return mysql_errno( &_mysql );
 	}
 
-	/// ȡøϢ
+	/// 取得更新信息
 	string info();
 
 	////////////////////////////////////////////////////////////////////////////
 	private:
 	
-	/// ֹÿ캯
+	/// 禁止调用拷贝构造函数
 	MysqlClient( MysqlClient &copy );
-	/// ֹÿֵ
+	/// 禁止调用拷贝赋值操作
 	MysqlClient& operator = ( const MysqlClient& copy );
 
 	MYSQL _mysql;
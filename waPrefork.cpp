@@ -0,0 +1,270 @@
+/// \file waPrefork.cpp
+/// Prefork类实现文件
+
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <iostream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "waPrefork.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+// 派生失败重试间隔上限,单位为秒
+const int PREFORK_RETRY_MAX = 32;
+
+// 主进程信号状态
+static volatile sig_atomic_t WEBAPP_PREFORK_STOP = 0;
+static volatile sig_atomic_t WEBAPP_PREFORK_RELOAD = 0;
+
+// 工作进程结束函数,由 Prefork::on_stop() 设置
+static prefork_stop WEBAPP_PREFORK_STOPFUNC = NULL;
+static void *WEBAPP_PREFORK_STOPARG = NULL;
+
+// 主进程信号处理函数
+static void prefork_master_signal( int sig ) {
+	if ( sig == SIGHUP )
+		WEBAPP_PREFORK_RELOAD = 1;
+	else if ( sig==SIGTERM || sig==SIGINT )
+		WEBAPP_PREFORK_STOP = 1;
+	// SIGCHLD only wakes up sigsuspend()
+}
+
+// 工作进程信号处理函数
+static void prefork_worker_signal( int sig ) {
+	if ( WEBAPP_PREFORK_STOPFUNC != NULL ) {
+		WEBAPP_PREFORK_STOPFUNC( WEBAPP_PREFORK_STOPARG );
+	} else {
+		// no stop function, terminate now
+		signal( sig, SIG_DFL );
+		raise( sig );
+	}
+}
+
+// 设置信号处理函数
+static void set_signal( const int sig, void (*handler)(int) ) {
+	struct sigaction sa;
+	memset( &sa, 0, sizeof(sa) );
+	sa.sa_handler = handler;
+	sigemptyset( &sa.sa_mask );
+	sa.sa_flags = 0; // no SA_RESTART, interrupt blocking calls
+	sigaction( sig, &sa, NULL );
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Prefork
+
+/// 构造函数
+/// \param workers 工作进程数量,默认为0即系统CPU数量
+Prefork::Prefork( const int workers ):
+_generation(0), _main(NULL), _arg(NULL), _retry(0), _backoff(0)
+{
+	this->set_workers( workers );
+}
+
+/// 设置工作进程数量
+/// 必须在 run() 之前调用
+/// \param workers 工作进程数量,为0则为系统CPU数量
+void Prefork::set_workers( const int workers ) {
+	_workers = ( workers>0 ) ? workers : Prefork::cpus();
+}
+
+/// 派生工作进程并监视其运行
+/// 工作进程中调用主函数,主函数返回后工作进程退出,
+/// 工作进程收到SIGTERM或SIGINT时调用 on_stop() 设置的结束函数,未设置则直接退出,
+/// 共享监听socket时应在调用本函数前创建,
+/// 派生失败的工作进程由主进程按1秒起倍增至32秒的间隔重试派生
+/// \param main 工作进程主函数
+/// \param arg 传递给主函数的参数
+/// \retval true 收到SIGTERM或SIGINT,全部工作进程已退出
+/// \retval false 参数错误
+bool Prefork::run( prefork_main main, void *arg ) {
+	if ( main == NULL )
+		return false;
+	_main = main;
+	_arg = arg;
+	WEBAPP_PREFORK_STOP = 0;
+	WEBAPP_PREFORK_RELOAD = 0;
+	_failed.clear();
+	_retry = 0;
+
+	// block signals, wait for them in sigsuspend() only
+	sigset_t block, origmask;
+	sigemptyset( &block );
+	sigaddset( &block, SIGCHLD );
+	sigaddset( &block, SIGTERM );
+	sigaddset( &block, SIGINT );
+	sigaddset( &block, SIGHUP );
+	sigprocmask( SIG_BLOCK, &block, &origmask );
+
+	struct sigaction oldchld, oldterm, oldint, oldhup;
+	sigaction( SIGCHLD, NULL, &oldchld );
+	sigaction( SIGTERM, NULL, &oldterm );
+	sigaction( SIGINT, NULL, &oldint );
+	sigaction( SIGHUP, NULL, &oldhup );
+	set_signal( SIGCHLD, prefork_master_signal );
+	set_signal( SIGTERM, prefork_master_signal );
+	set_signal( SIGINT, prefork_master_signal );
+	set_signal( SIGHUP, prefork_master_signal );
+
+	for ( int i=0; i<_workers; ++i )
+		this->spawn( i );
+
+	bool stopping = false;
+	while ( true ) {
+		// reap exited workers
+		int status;
+		pid_t pid;
+		while ( (pid=waitpid(-1,&status,WNOHANG)) > 0 ) {
+			map<pid_t,prefork_worker>::iterator i = _pids.find( pid );
+			if ( i == _pids.end() )
+				continue;
+			prefork_worker exited = i->second;
+			_pids.erase( i );
+
+			// respawn worker of current generation
+			if ( !stopping && exited.generation==_generation ) {
+				if ( time(0)-exited.started < 1 )
+					sleep( 1 ); // crashed at startup, slow down
+				this->spawn( exited.worker );
+			}
+		}
+
+		if ( WEBAPP_PREFORK_STOP && !stopping ) {
+			stopping = true;
+			_failed.clear();
+			this->stop_workers( -1 );
+		}
+
+		if ( WEBAPP_PREFORK_RELOAD && !stopping ) {
+			// start new generation, then stop the old one
+			WEBAPP_PREFORK_RELOAD = 0;
+			++_generation;
+			_failed.clear();
+			for ( int i=0; i<_workers; ++i )
+				this->spawn( i );
+			this->stop_workers( _generation );
+		}
+
+		if ( stopping && _pids.empty() )
+			break;
+
+		// retry failed workers with backoff
+		if ( !_failed.empty() ) {
+			if ( _retry == 0 ) {
+				_backoff = 1;
+				_retry = time( 0 ) + _backoff;
+			} else if ( time(0) >= _retry ) {
+				this->retry_failed();
+			}
+		}
+		if ( _failed.empty() ) {
+			_retry = 0;
+			sigsuspend( &origmask );
+		} else {
+			// wait for signals until next retry
+			time_t wait = _retry - time( 0 );
+			struct timespec ts;
+			ts.tv_sec = ( wait>0 ) ? wait : 0;
+			ts.tv_nsec = 0;
+			int sig = sigtimedwait( &block, NULL, &ts );
+			if ( sig > 0 )
+				prefork_master_signal( sig );
+		}
+	}
+
+	// restore signals
+	sigaction( SIGCHLD, &oldchld, NULL );
+	sigaction( SIGTERM, &oldterm, NULL );
+	sigaction( SIGINT, &oldint, NULL );
+	sigaction( SIGHUP, &oldhup, NULL );
+	sigprocmask( SIG_SETMASK, &origmask, NULL );
+	return true;
+}
+
+/// 设置工作进程结束函数
+/// 在工作进程主函数中调用,工作进程收到SIGTERM或SIGINT时在信号处理函数中调用该函数,
+/// 如 HttpServer::stop(),FastCgi::stop(),使主函数处理完当前请求后返回
+/// \param stop 结束函数,为NULL则收到信号时直接退出
+/// \param arg 传递给结束函数的参数
+void Prefork::on_stop( prefork_stop stop, void *arg ) {
+	WEBAPP_PREFORK_STOPFUNC = stop;
+	WEBAPP_PREFORK_STOPARG = arg;
+}
+
+/// 系统CPU数量
+/// \return 在线CPU数量,无法取得时为1
+int Prefork::cpus() {
+	long n = sysconf( _SC_NPROCESSORS_ONLN );
+	return ( n>0 ) ? static_cast<int>( n ) : 1;
+}
+
+/// 派生工作进程
+/// \param worker 工作进程序号
+/// \retval true 派生成功
+/// \retval false 失败,记录为待重试
+bool Prefork::spawn( const int worker ) {
+	pid_t pid = fork();
+	if ( pid < 0 ) {
+		// retry later in run()
+		cerr << "Prefork::spawn:  fork() failed for worker " << worker
+			 << ": " << strerror(errno) << endl;
+		_failed.insert( worker );
+		return false;
+	}
+
+	if ( pid == 0 ) {
+		// worker process
+		WEBAPP_PREFORK_STOPFUNC = NULL;
+		WEBAPP_PREFORK_STOPARG = NULL;
+		signal( SIGCHLD, SIG_DFL );
+		signal( SIGHUP, SIG_DFL );
+		set_signal( SIGTERM, prefork_worker_signal );
+		set_signal( SIGINT, prefork_worker_signal );
+
+		sigset_t empty;
+		sigemptyset( &empty );
+		sigprocmask( SIG_SETMASK, &empty, NULL );
+
+		_main( worker, _arg );
+		exit( 0 );
+	}
+
+	prefork_worker info;
+	info.worker = worker;
+	info.generation = _generation;
+	info.started = time( 0 );
+	_pids[pid] = info;
+	return true;
+}
+
+/// 重新派生派生失败的工作进程
+/// 仍有失败时重试间隔加倍,上限为 PREFORK_RETRY_MAX 秒
+void Prefork::retry_failed() {
+	set<int> failed;
+	failed.swap( _failed );
+	for ( set<int>::const_iterator i=failed.begin(); i!=failed.end(); ++i )
+		this->spawn( *i );
+
+	if ( !_failed.empty() ) {
+		_backoff = ( _backoff*2<PREFORK_RETRY_MAX ) ? _backoff*2 : PREFORK_RETRY_MAX;
+		_retry = time( 0 ) + _backoff;
+	}
+}
+
+/// 通知工作进程结束
+/// 向工作进程发送SIGTERM
+/// \param generation 保留该代工作进程,为-1则通知全部工作进程
+void Prefork::stop_workers( const int generation ) {
+	for ( map<pid_t,prefork_worker>::const_iterator i=_pids.begin(); i!=_pids.end(); ++i ) {
+		if ( i->second.generation != generation )
+			kill( i->first, SIGTERM );
+	}
+}
+
+} // namespace
@@ -0,0 +1,92 @@
+/// \file waPrefork.h
+/// webapp::Prefork类头文件
+/// 多进程预派生工作进程管理类,用于HttpServer,FastCgi等常驻进程模式
+
+#ifndef _WEBAPPLIB_PREFORK_H_
+#define _WEBAPPLIB_PREFORK_H_
+
+#include <map>
+#include <set>
+#include <ctime>
+#include <sys/types.h>
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+/// \defgroup waPrefork waPrefork相关数据类型与全局函数
+
+/// \ingroup waPrefork
+/// \typedef prefork_main
+/// 工作进程主函数类型,
+/// 参数依次为工作进程序号(0至工作进程数量-1),Prefork::run()指定的参数,
+/// 函数返回后工作进程退出
+typedef void (*prefork_main)( const int worker, void *arg );
+
+/// \ingroup waPrefork
+/// \typedef prefork_stop
+/// 工作进程结束函数类型,在信号处理函数中调用,只能执行异步信号安全的操作,
+/// 参数为 Prefork::on_stop() 指定的参数
+typedef void (*prefork_stop)( void *arg );
+
+/// 多进程预派生工作进程管理类
+/// 主进程派生指定数量的工作进程并监视其运行,工作进程异常退出时重新派生,
+/// 主进程收到SIGHUP时派生新的工作进程并通知原工作进程结束(平滑重启),
+/// 收到SIGTERM或SIGINT时通知全部工作进程结束并等待其退出,
+/// 工作进程可共享主进程创建的监听socket,或各自以SO_REUSEPORT方式监听同一端口
+class Prefork {
+	public:
+
+	/// 构造函数
+	Prefork( const int workers = 0 );
+
+	/// 析构函数
+	virtual ~Prefork(){};
+
+	/// 设置工作进程数量
+	void set_workers( const int workers );
+
+	/// 工作进程数量
+	inline int workers() const {
+		return _workers;
+	}
+
+	/// 派生工作进程并监视其运行
+	bool run( prefork_main main, void *arg = NULL );
+
+	/// 设置工作进程结束函数
+	static void on_stop( prefork_stop stop, void *arg = NULL );
+
+	/// 系统CPU数量
+	static int cpus();
+
+	////////////////////////////////////////////////////////////////////////////
+	private:
+
+	/// 派生工作进程
+	bool spawn( const int worker );
+	/// 通知工作进程结束
+	void stop_workers( const int generation );
+	/// 重新派生派生失败的工作进程
+	void retry_failed();
+
+	typedef struct {				// 工作进程信息
+		int worker;					// 工作进程序号
+		int generation;				// 工作进程代数,平滑重启后加1
+		time_t started;				// 启动时间
+	} prefork_worker;
+
+	int _workers;					// 工作进程数量
+	int _generation;				// 当前工作进程代数
+	prefork_main _main;				// 工作进程主函数
+	void *_arg;						// 工作进程主函数参数
+	map<pid_t,prefork_worker> _pids;	// 工作进程列表
+	set<int> _failed;				// 派生失败待重试的工作进程序号
+	time_t _retry;					// 下次重试派生时间,为0则无待重试的工作进程
+	int _backoff;					// 当前重试间隔,单位为秒
+};
+
+} // namespace
+
+#endif //_WEBAPPLIB_PREFORK_H_
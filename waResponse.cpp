@@ -0,0 +1,560 @@
+/// \file waResponse.cpp
+/// Response类实现文件
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <strings.h>
+#include <algorithm>
+#ifndef _WEBAPPLIB_NOZLIB
+#include <zlib.h>
+#endif
+#include "waString.h"
+#include "waResponse.h"
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+// 回应内容数据块大小
+const size_t RESPONSE_SEGMENT_SIZE = 16384;
+
+// 单次writev()最大数据块数量
+#ifdef IOV_MAX
+const int RESPONSE_IOV_MAX = IOV_MAX;
+#else
+const int RESPONSE_IOV_MAX = 16;
+#endif
+
+// 输出方式
+enum response_output {
+	RESPONSE_OUTPUT_AUTO,		// 缓存内容超过阈值自动输出
+	RESPONSE_OUTPUT_FLUSH,		// flush()
+	RESPONSE_OUTPUT_FINISH		// finish()
+};
+
+////////////////////////////////////////////////////////////////////////////
+// ResponseBuf
+
+/// 回应输出流缓冲类
+/// 不另行缓冲,写入内容直接追加至Response对象,
+/// sync()不触发输出,endl不会导致逐行输出
+class ResponseBuf : public streambuf {
+	public:
+
+	/// 构造函数
+	/// \param response 输出目标,为NULL则输出至 Response::current()
+	ResponseBuf( Response *response ):
+	_response(response) {
+	}
+
+	protected:
+
+	// 输出单个字符
+	virtual int overflow( int c ) {
+		if ( c == EOF )
+			return 0;
+		char ch = c;
+		this->target().write( &ch, 1 );
+		return c;
+	}
+
+	// 输出字符串
+	virtual streamsize xsputn( const char *s, streamsize n ) {
+		this->target().write( s, n );
+		return n;
+	}
+
+	private:
+
+	// 输出目标
+	Response& target() {
+		return ( _response!=NULL ) ? *_response : Response::current();
+	}
+
+	Response *_response;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// ResponseZip
+
+#ifndef _WEBAPPLIB_NOZLIB
+/// 回应内容压缩类
+/// zlib deflate数据流的封装,输出gzip或zlib(HTTP deflate)格式
+class ResponseZip {
+	public:
+
+	/// 构造函数
+	/// \param level 压缩级别
+	/// \param gzip 为true输出gzip格式,否则输出zlib格式
+	ResponseZip( const int level, const bool gzip ) {
+		memset( &_zs, 0, sizeof(_zs) );
+		_ok = ( deflateInit2(&_zs,level,Z_DEFLATED,gzip?MAX_WBITS+16:MAX_WBITS,
+			8,Z_DEFAULT_STRATEGY) == Z_OK );
+	}
+
+	/// 析构函数
+	~ResponseZip() {
+		if ( _ok )
+			deflateEnd( &_zs );
+	}
+
+	/// 压缩数据
+	/// \param data 待压缩数据
+	/// \param len 数据长度
+	/// \param flush zlib deflate()输出方式
+	/// \param out 压缩结果,追加至原有内容之后
+	/// \retval true 压缩成功
+	/// \retval false 失败
+	bool deflate( const char *data, const size_t len, const int flush, string &out ) {
+		if ( !_ok )
+			return false;
+
+		char buf[RESPONSE_SEGMENT_SIZE];
+		_zs.next_in = reinterpret_cast<Bytef*>( const_cast<char*>(data) );
+		_zs.avail_in = len;
+		do {
+			_zs.next_out = reinterpret_cast<Bytef*>( buf );
+			_zs.avail_out = sizeof( buf );
+			if ( ::deflate(&_zs,flush) == Z_STREAM_ERROR )
+				return false;
+			out.append( buf, sizeof(buf)-_zs.avail_out );
+		} while ( _zs.avail_out == 0 );
+		return true;
+	}
+
+	private:
+
+	z_stream _zs;
+	bool _ok;
+};
+#else
+class ResponseZip {
+};
+#endif //_WEBAPPLIB_NOZLIB
+
+////////////////////////////////////////////////////////////////////////////
+// Response
+
+// 当前请求的回应对象,由 Response::set_current() 设置
+static Response *WEBAPP_RESPONSE = NULL;
+// 默认输出至stdout的回应对象
+static Response *WEBAPP_STDOUT_RESPONSE = NULL;
+// cout 原输出缓冲
+static streambuf *WEBAPP_COUT_BUF = NULL;
+
+// 进程退出时输出未输出内容并恢复 cout
+static void response_exit() {
+	if ( WEBAPP_COUT_BUF != NULL ) {
+		cout.rdbuf( WEBAPP_COUT_BUF );
+		WEBAPP_COUT_BUF = NULL;
+	}
+	if ( WEBAPP_RESPONSE != NULL )
+		WEBAPP_RESPONSE->finish();
+	if ( WEBAPP_STDOUT_RESPONSE != NULL )
+		WEBAPP_STDOUT_RESPONSE->finish();
+}
+
+/// 构造函数
+/// \param fd 输出文件描述符,默认为stdout
+Response::Response( const int fd ):
+_fd(fd), _writer(NULL), _arg(NULL), _headend(false), _headsent(false),
+_size(0), _bufsize(RESPONSE_BUFFER_SIZE), _buf(new ResponseBuf(this)), _stream(_buf),
+_level(0), _minsize(RESPONSE_COMPRESS_MINSIZE), _zip(NULL)
+{
+}
+
+/// 构造函数
+/// \param writer 输出函数,用于FastCGI等需要封装输出数据的场合
+/// \param arg 输出函数参数
+Response::Response( response_writer writer, void *arg ):
+_fd(-1), _writer(writer), _arg(arg), _headend(false), _headsent(false),
+_size(0), _bufsize(RESPONSE_BUFFER_SIZE), _buf(new ResponseBuf(this)), _stream(_buf),
+_level(0), _minsize(RESPONSE_COMPRESS_MINSIZE), _zip(NULL)
+{
+}
+
+/// 析构函数
+/// 输出未输出的内容
+Response::~Response() {
+	this->finish();
+	if ( WEBAPP_RESPONSE == this )
+		WEBAPP_RESPONSE = NULL;
+	delete _zip;
+	delete _buf;
+}
+
+/// 当前请求的回应对象
+/// 首次调用时将 cout 重定向至当前请求的回应对象,并在进程退出时输出未输出内容
+/// \return 由 set_current() 设置的回应对象,未设置则为输出至stdout的回应对象
+Response& Response::current() {
+	if ( WEBAPP_STDOUT_RESPONSE == NULL ) {
+		WEBAPP_STDOUT_RESPONSE = new Response( STDOUT_FILENO );
+
+		// redirect cout
+		static ResponseBuf coutbuf( NULL );
+		cout.flush();
+		WEBAPP_COUT_BUF = cout.rdbuf( &coutbuf );
+		atexit( response_exit );
+	}
+
+	if ( WEBAPP_RESPONSE != NULL )
+		return *WEBAPP_RESPONSE;
+	return *WEBAPP_STDOUT_RESPONSE;
+}
+
+/// 设置当前请求的回应对象
+/// 用于FastCGI等常驻进程模式,设置后 Response::current() 及 cout 输出至该对象
+/// \param response 回应对象,为NULL则恢复为输出至stdout
+void Response::set_current( Response *response ) {
+	WEBAPP_RESPONSE = response;
+}
+
+/// 设置回应状态
+/// 输出为"Status: 状态码 状态描述"回应头
+/// \param status HTTP状态码,如404
+/// \param reason 状态描述,如"Not Found",默认为空
+void Response::set_status( const int status, const string &reason ) {
+	_status = itos( status );
+	if ( reason != "" )
+		_status += " " + reason;
+}
+
+/// 设置回应头,替换同名回应头
+/// 回应头已输出时直接作为回应内容输出
+/// \param name 回应头名称,大小写不敏感
+/// \param value 回应头值
+void Response::set_header( const string &name, const string &value ) {
+	if ( !_headsent )
+		this->del_header( name );
+	this->add_header( name, value );
+}
+
+/// 增加回应头,允许同名回应头
+/// 回应头已输出时直接作为回应内容输出
+/// \param name 回应头名称
+/// \param value 回应头值
+void Response::add_header( const string &name, const string &value ) {
+	if ( _headsent )
+		this->write( name + ": " + value + "\n" );
+	else
+		_headers.push_back( make_pair(name,value) );
+}
+
+/// 是否已设置指定回应头
+/// \param name 回应头名称,大小写不敏感
+/// \retval true 已设置
+/// \retval false 未设置
+bool Response::has_header( const string &name ) const {
+	for ( size_t i=0; i<_headers.size(); ++i ) {
+		if ( strcasecmp(_headers[i].first.c_str(),name.c_str()) == 0 )
+			return true;
+	}
+	return false;
+}
+
+/// 删除指定回应头
+/// \param name 回应头名称,大小写不敏感
+void Response::del_header( const string &name ) {
+	for ( size_t i=0; i<_headers.size(); ) {
+		if ( strcasecmp(_headers[i].first.c_str(),name.c_str()) == 0 )
+			_headers.erase( _headers.begin()+i );
+		else
+			++i;
+	}
+}
+
+/// 结束回应头
+/// 输出时在回应头后增加空行,回应头已输出时直接输出空行,
+/// 输出至stdout的默认回应对象不压缩时立即输出回应头,
+/// 使回应头在之后以 printf() 等直接输出至stdout的内容之前
+void Response::end_head() {
+	if ( _headend )
+		return;
+	if ( _headsent )
+		this->write( "\n", 1 );
+	_headend = true;
+
+	if ( this==WEBAPP_STDOUT_RESPONSE && _encoding=="" )
+		this->flush();
+}
+
+/// 输出回应内容
+/// 内容追加至缓存,缓存内容超过 set_buffer_size() 指定大小后自动输出
+/// \param data 回应内容
+/// \param len 回应内容长度
+void Response::write( const char *data, const size_t len ) {
+	if ( len == 0 )
+		return;
+
+	if ( len >= RESPONSE_SEGMENT_SIZE ) {
+		// large data as a single segment
+		_body.push_back( string() );
+		_body.back().assign( data, len );
+	} else {
+		if ( _body.empty() || _body.back().length()+len > RESPONSE_SEGMENT_SIZE ) {
+			_body.push_back( string() );
+			_body.back().reserve( RESPONSE_SEGMENT_SIZE );
+		}
+		_body.back().append( data, len );
+	}
+
+	_size += len;
+	if ( _bufsize>0 && _size>=_bufsize )
+		this->output( RESPONSE_OUTPUT_AUTO );
+}
+
+/// 输出已缓存的回应头及回应内容
+/// 回应头在第一次输出时与回应内容一起输出,之后只输出回应内容,
+/// 压缩输出时已缓存内容全部压缩输出,可用于提前输出页面头部
+/// \retval true 输出成功
+/// \retval false 输出出错
+bool Response::flush() {
+	return this->output( RESPONSE_OUTPUT_FLUSH );
+}
+
+/// 输出全部回应头及回应内容,结束压缩数据
+/// 回应对象析构或进程退出时自动调用,之后的输出不再压缩
+/// \retval true 输出成功
+/// \retval false 输出出错
+bool Response::finish() {
+	return this->output( RESPONSE_OUTPUT_FINISH );
+}
+
+/// 设置回应内容压缩
+/// 设置后调用 accept_encoding() 选择压缩方式,http_head() 自动调用,
+/// 编译时使用 -D_WEBAPPLIB_NOZLIB 参数则不压缩
+/// \param level 压缩级别,1-9,为0则不压缩,默认为 RESPONSE_COMPRESS_LEVEL
+/// \param min_size 回应内容小于该大小时不压缩,单位为byte,
+/// 默认为 RESPONSE_COMPRESS_MINSIZE,提前调用 flush() 时不检查
+void Response::set_compress( const int level, const size_t min_size ) {
+#ifndef _WEBAPPLIB_NOZLIB
+	_level = min( max(level,0), 9 );
+#endif
+	_minsize = min_size;
+}
+
+/// 根据客户端 Accept-Encoding 请求头选择压缩方式
+/// 必须在回应头输出前调用,已调用 set_compress() 时增加"Vary: Accept-Encoding"回应头,
+/// 同时接受gzip及deflate时优先选择gzip
+/// \param accept 客户端 Accept-Encoding 请求头,如"gzip, deflate;q=0.5"
+/// \retval true 回应内容将被压缩
+/// \retval false 不压缩
+bool Response::accept_encoding( const string &accept ) {
+	_encoding = "";
+	if ( _level<=0 || _headsent )
+		return false;
+	if ( !this->has_header("Vary") )
+		this->add_header( "Vary", "Accept-Encoding" );
+
+	// q-value of each coding, -1 for not mentioned
+	double gzip = -1, deflate = -1, any = -1;
+	vector<String> items = String( accept ).split( "," );
+	for ( size_t i=0; i<items.size(); ++i ) {
+		vector<String> params = items[i].split( ";" );
+		if ( params.size() == 0 )
+			continue;
+
+		String coding = params[0];
+		coding.trim();
+		coding.lower();
+
+		double q = 1;
+		for ( size_t j=1; j<params.size(); ++j ) {
+			params[j].trim();
+			if ( params[j].length()>2 && strncasecmp(params[j].c_str(),"q=",2)==0 )
+				q = webapp::stof( params[j].substr(2) );
+		}
+
+		if ( coding=="gzip" || coding=="x-gzip" )
+			gzip = q;
+		else if ( coding == "deflate" )
+			deflate = q;
+		else if ( coding == "*" )
+			any = q;
+	}
+
+	if ( gzip < 0 )
+		gzip = max( any, 0.0 );
+	if ( deflate < 0 )
+		deflate = max( any, 0.0 );
+
+	if ( gzip>0 && gzip>=deflate )
+		_encoding = "gzip";
+	else if ( deflate > 0 )
+		_encoding = "deflate";
+	return ( _encoding != "" );
+}
+
+/// 输出已缓存的回应头及回应内容
+/// \param mode 输出方式
+/// \retval true 输出成功
+/// \retval false 输出出错
+bool Response::output( const int mode ) {
+	if ( !_headsent && _zip==NULL )
+		this->start_compress( mode==RESPONSE_OUTPUT_FINISH );
+
+	bool ok = true;
+	if ( _zip != NULL )
+		ok = this->compress( mode );
+
+	string head;
+	if ( !_headsent )
+		this->build_head( head );
+	if ( head.length()==0 && _size==0 ) {
+		if ( mode == RESPONSE_OUTPUT_FINISH ) {
+			delete _zip;
+			_zip = NULL;
+		}
+		return ok;
+	}
+
+	vector<struct iovec> iov;
+	iov.reserve( _body.size()+1 );
+	if ( head.length() > 0 ) {
+		struct iovec item;
+		item.iov_base = const_cast<char*>( head.data() );
+		item.iov_len = head.length();
+		iov.push_back( item );
+	}
+	for ( size_t i=0; i<_body.size(); ++i ) {
+		struct iovec item;
+		item.iov_base = const_cast<char*>( _body[i].data() );
+		item.iov_len = _body[i].length();
+		iov.push_back( item );
+	}
+
+	ok = this->send( &iov[0], iov.size() ) && ok;
+	_headsent = true;
+	_body.clear();
+	_size = 0;
+
+	if ( _zip == NULL ) {
+		_encoding = "";
+	} else if ( mode == RESPONSE_OUTPUT_FINISH ) {
+		delete _zip;
+		_zip = NULL;
+	}
+	return ok;
+}
+
+/// 清空回应状态,回应头及缓存内容,用于开始新的回应
+void Response::reset() {
+	_status.clear();
+	_headers.clear();
+	_headend = false;
+	_headsent = false;
+	_body.clear();
+	_size = 0;
+	_stream.clear();
+	_encoding = "";
+	delete _zip;
+	_zip = NULL;
+}
+
+/// 生成回应头
+/// \param head 生成结果,未设置任何回应头时为空
+void Response::build_head( string &head ) const {
+	if ( _status != "" )
+		head += "Status: " + _status + "\n";
+	for ( size_t i=0; i<_headers.size(); ++i )
+		head += _headers[i].first + ": " + _headers[i].second + "\n";
+	if ( _headend )
+		head += "\n";
+}
+
+/// 开始压缩回应内容
+/// 回应头已结束且已选择压缩方式时设置"Content-Encoding"回应头,
+/// 回应内容过小或已设置"Content-Encoding"回应头时不压缩
+/// \param finish 是否为最后一次输出
+void Response::start_compress( const bool finish ) {
+#ifndef _WEBAPPLIB_NOZLIB
+	if ( _encoding=="" || !_headend )
+		return;
+
+	if ( (finish && _size<_minsize) || this->has_header("Content-Encoding") ||
+		 _status.compare(0,3,"204")==0 || _status.compare(0,3,"304")==0 ) {
+		_encoding = "";
+		return;
+	}
+
+	_zip = new ResponseZip( _level, _encoding=="gzip" );
+	this->del_header( "Content-Length" );
+	this->add_header( "Content-Encoding", _encoding );
+#endif
+}
+
+/// 压缩已缓存的回应内容
+/// 压缩结果替换已缓存内容
+/// \param mode 输出方式,自动输出时压缩结果可能暂存于压缩数据流中
+/// \retval true 压缩成功
+/// \retval false 失败
+bool Response::compress( const int mode ) {
+#ifndef _WEBAPPLIB_NOZLIB
+	int flush = Z_NO_FLUSH;
+	if ( mode == RESPONSE_OUTPUT_FLUSH )
+		flush = Z_SYNC_FLUSH;
+	else if ( mode == RESPONSE_OUTPUT_FINISH )
+		flush = Z_FINISH;
+
+	string out;
+	out.reserve( _size/4 );
+
+	bool ok = true;
+	for ( size_t i=0; i<_body.size() && ok; ++i ) {
+		ok = _zip->deflate( _body[i].data(), _body[i].length(),
+			(i+1<_body.size())?Z_NO_FLUSH:flush, out );
+	}
+	if ( _body.empty() && flush!=Z_NO_FLUSH )
+		ok = _zip->deflate( NULL, 0, flush, out );
+
+	_body.clear();
+	_size = out.length();
+	if ( _size > 0 ) {
+		_body.push_back( string() );
+		_body.back().swap( out );
+	}
+	return ok;
+#else
+	return true;
+#endif
+}
+
+/// 输出数据块
+/// \param iov 数据块列表,输出过程中被修改
+/// \param iovcnt 数据块数量
+/// \retval true 输出成功
+/// \retval false 输出出错
+bool Response::send( struct iovec *iov, int iovcnt ) {
+	if ( _writer != NULL )
+		return _writer( iov, iovcnt, _arg );
+
+	// keep order with stdio output
+	if ( _fd == STDOUT_FILENO )
+		fflush( stdout );
+
+	while ( iovcnt > 0 ) {
+		ssize_t n = writev( _fd, iov, min(iovcnt,RESPONSE_IOV_MAX) );
+		if ( n < 0 && errno == EINTR )
+			continue;
+		if ( n < 0 )
+			return false;
+
+		// skip sent data
+		while ( iovcnt>0 && static_cast<size_t>(n)>=iov->iov_len ) {
+			n -= iov->iov_len;
+			++iov;
+			--iovcnt;
+		}
+		if ( iovcnt > 0 ) {
+			iov->iov_base = static_cast<char*>( iov->iov_base ) + n;
+			iov->iov_len -= n;
+		}
+	}
+	return true;
+}
+
+} // namespace
@@ -0,0 +1,182 @@
+/// \file waResponse.h
+/// webapp::Response类头文件
+/// HTTP回应输出缓冲类,以writev()批量输出回应头及内容
+/// 编译时使用 -D_WEBAPPLIB_NOZLIB 参数则不支持gzip/deflate压缩输出
+
+#ifndef _WEBAPPLIB_RESPONSE_H_
+#define _WEBAPPLIB_RESPONSE_H_
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unistd.h>
+#include <sys/uio.h>
+
+using namespace std;
+
+/// Web Application Library namaspace
+namespace webapp {
+
+/// \defgroup waResponse waResponse相关数据类型与全局函数
+
+/// \ingroup waResponse
+/// \typedef response_writer
+/// 回应输出函数类型,
+/// 参数依次为待输出数据块列表,数据块数量,Response构造时指定的参数,
+/// 返回false表示输出出错
+typedef bool (*response_writer)( const struct iovec *iov, const int iovcnt, void *arg );
+
+/// \ingroup waResponse
+/// 回应内容默认自动输出阈值,单位为byte
+const size_t RESPONSE_BUFFER_SIZE = 65536;
+
+/// \ingroup waResponse
+/// 回应内容默认压缩级别,1-9,数值越大压缩率越高
+const int RESPONSE_COMPRESS_LEVEL = 6;
+
+/// \ingroup waResponse
+/// 回应内容默认最小压缩大小,单位为byte
+const size_t RESPONSE_COMPRESS_MINSIZE = 1024;
+
+/// 回应输出流缓冲类,在cpp文件中实现
+class ResponseBuf;
+/// 回应内容压缩类,在cpp文件中实现
+class ResponseZip;
+
+/// HTTP回应输出缓冲类
+/// 缓存回应状态,回应头,Set-Cookie及回应内容,调用 flush() 或缓存内容超过阈值时
+/// 以一次 writev() 输出,
+/// Response::current() 为当前请求的回应对象,http_head(),Cookie::set_cookie(),
+/// Template::print() 及 cout 均输出至该对象,
+/// 调用 set_compress() 后回应内容按客户端 Accept-Encoding 以gzip/deflate压缩输出
+class Response {
+	public:
+
+	/// 构造函数
+	Response( const int fd = STDOUT_FILENO );
+	/// 构造函数
+	Response( response_writer writer, void *arg = NULL );
+
+	/// 析构函数
+	virtual ~Response();
+
+	/// 当前请求的回应对象
+	static Response& current();
+	/// 设置当前请求的回应对象
+	static void set_current( Response *response );
+
+	/// 设置回应状态
+	void set_status( const int status, const string &reason = "" );
+	/// 设置回应头,替换同名回应头
+	void set_header( const string &name, const string &value );
+	/// 增加回应头,允许同名回应头
+	void add_header( const string &name, const string &value );
+	/// 是否已设置指定回应头
+	bool has_header( const string &name ) const;
+	/// 删除指定回应头
+	void del_header( const string &name );
+
+	/// 结束回应头
+	void end_head();
+
+	/// 回应头是否已结束
+	inline bool head_ended() const {
+		return _headend;
+	}
+
+	/// 回应头是否已输出
+	inline bool head_sent() const {
+		return _headsent;
+	}
+
+	/// 输出回应内容
+	void write( const char *data, const size_t len );
+	/// 输出回应内容
+	/// \param data 回应内容
+	inline void write( const string &data ) {
+		this->write( data.data(), data.length() );
+	}
+
+	/// 回应内容输出流
+	/// \return 写入该输出流的内容直接追加至回应内容,不另行缓冲
+	inline ostream& stream() {
+		return _stream;
+	}
+
+	/// 输出已缓存的回应头及回应内容
+	bool flush();
+	/// 输出全部回应头及回应内容,结束压缩数据
+	bool finish();
+
+	/// 设置自动输出阈值
+	/// \param size 缓存内容超过该大小时自动输出,为0则只在 flush() 或析构时输出
+	inline void set_buffer_size( const size_t size ) {
+		_bufsize = size;
+	}
+
+	/// 已缓存的回应内容大小
+	inline size_t buffered() const {
+		return _size;
+	}
+
+	/// 设置回应内容压缩
+	void set_compress( const int level = RESPONSE_COMPRESS_LEVEL,
+		const size_t min_size = RESPONSE_COMPRESS_MINSIZE );
+	/// 根据客户端 Accept-Encoding 请求头选择压缩方式
+	bool accept_encoding( const string &accept );
+
+	/// 回应内容压缩方式
+	/// \return "gzip","deflate",不压缩时为空字符串
+	inline const string& encoding() const {
+		return _encoding;
+	}
+
+	/// 清空回应状态,回应头及缓存内容,用于开始新的回应
+	void reset();
+
+	////////////////////////////////////////////////////////////////////////////
+	private:
+
+	/// 输出已缓存的回应头及回应内容
+	bool output( const int mode );
+	/// 生成回应头
+	void build_head( string &head ) const;
+	/// 开始压缩回应内容
+	void start_compress( const bool finish );
+	/// 压缩已缓存的回应内容
+	bool compress( const int mode );
+	/// 输出数据块
+	bool send( struct iovec *iov, int iovcnt );
+
+	/// 禁止调用拷贝构造函数
+	Response( Response &copy );
+	/// 禁止调用拷贝赋值操作
+	Response& operator = ( const Response& copy );
+
+	typedef vector< pair<string,string> > headers;
+
+	int _fd;						// 输出文件描述符
+	response_writer _writer;		// 输出函数,为NULL则输出至_fd
+	void *_arg;						// 输出函数参数
+
+	string _status;					// 回应状态
+	headers _headers;				// 回应头列表
+	bool _headend;					// 回应头是否已结束
+	bool _headsent;					// 回应头是否已输出
+
+	vector<string> _body;			// 回应内容数据块列表
+	size_t _size;					// 已缓存回应内容大小
+	size_t _bufsize;				// 自动输出阈值
+
+	ResponseBuf *_buf;				// 输出流缓冲
+	ostream _stream;				// 回应内容输出流
+
+	int _level;						// 压缩级别,为0则不压缩
+	size_t _minsize;				// 最小压缩大小
+	string _encoding;				// 压缩方式,为空则不压缩
+	ResponseZip *_zip;				// 压缩数据流,为NULL则未开始压缩
+};
+
+} // namespace
+
+#endif //_WEBAPPLIB_RESPONSE_H_
@@ -1,5 +1,5 @@
 /// \file waString.cpp
-/// webapp::Stringʵļ
+/// webapp::String类实现文件
 
 #include <cstdio>
 #include <cstdarg>
@@ -13,18 +13,18 @@ namespace webapp {
 	
 ////////////////////////////////////////////////////////////////////////////////	
 
-/// \defgroup waString waStringȫֺ
+/// \defgroup waString waString相关全局函数
 
 /// \ingroup waString
 /// \fn string itos( const long i, const ios::fmtflags base )
-/// long intתΪstring
-/// \param i long intint
-/// \param base תƲ,ѡ
-/// - ios::dec 10
-/// - ios::oct 8
-/// - ios::hex 16
-/// - ĬΪ10
-/// \return ؽstring,תʧܷ"0"
+/// long int转换为string
+/// \param i long int或者int
+/// \param base 转换进制参数,可选
+/// - ios::dec 10进制
+/// - ios::oct 8进制
+/// - ios::hex 16进制
+/// - 默认为10进制
+/// \return 返回结果string,转换失败返回"0"
 string itos( const long i, const ios::fmtflags base ) {
 	char format[] = "%ld";
 	if ( base == ios::oct )
@@ -52,14 +52,14 @@ string itos( const long i, const ios::fmtflags base ) {
 
 /// \ingroup waString
 /// \fn long stoi( const string &s, const ios::fmtflags base )
-/// stringתΪlong int
+/// string转换为long int
 /// \param s string
-/// \param base תƲ,ѡ
-/// - ios::dec 10
-/// - ios::oct 8
-/// - ios::hex 16
-/// - ĬΪ10
-/// \return ؽlong int,תʧܷ0
+/// \param base 转换进制参数,可选
+/// - ios::dec 10进制
+/// - ios::oct 8进制
+/// - ios::hex 16进制
+/// - 默认为10进制
+/// \return 返回结果long int,转换失败返回0
 long stoi( const string &s, const ios::fmtflags base ) {
 	int ibase = 10;
 	char *ep;
@@ -76,10 +76,10 @@ long stoi( const string &s, const ios::fmtflags base ) {
 
 /// \ingroup waString
 /// \fn string ftos( const doule f, const int ndigit )
-/// doubleתΪstring
+/// double转换为string
 /// \param f double
-/// \param ndigit Сλ,ĬΪ2
-/// \return תɹstring,򷵻"0"
+/// \param ndigit 小数点后保留位数,默认为2
+/// \return 转换成功返回string,否则返回"0"
 string ftos( const double f, const int ndigit ) {
 	int fmtlen = 10;
 	int strlen = 64;
@@ -115,9 +115,9 @@ string ftos( const double f, const int ndigit ) {
 
 /// \ingroup waString
 /// \fn double stof( const string &s )
-/// stringתΪdouble
+/// string转换为double
 /// \param s string
-/// \return תɹdouble,򷵻0
+/// \return 转换成功返回double,否则返回0
 double stof( const string &s ) {
 	char *ep;
 	return strtod( s.c_str(), &ep );
@@ -125,11 +125,11 @@ double stof( const string &s ) {
 
 /// \ingroup waString
 /// \fn bool isgbk( const unsigned char c1, const unsigned char c2 )
-/// жһ˫ַֽǷGBK뺺
-/// \param c1 ˫ַֽ1
-/// \param c2 ˫ַֽ2
-/// \retval true 
-/// \retval false 
+/// 判断一个双字节字符是否是GBK编码汉字
+/// \param c1 双字节字符1
+/// \param c2 双字节字符2
+/// \retval true 是
+/// \retval false 否
 bool isgbk( const unsigned char c1, const unsigned char c2 ) {
 	if ( (c1>=0x81&&c1<=0xFE) && ((c2>=0x40&&c2<=0x7E)||(c2>=0xA1&&c2<=0xFE)) )
 		return true;
@@ -139,10 +139,10 @@ bool isgbk( const unsigned char c1, const unsigned char c2 ) {
 
 /// \ingroup waString
 /// \fn string va_sprintf( va_list ap, const string &format )
-/// ɱַʽva_start()va_end()ʹ
-/// \param format ַʽ
-/// \param ap ɱб
-/// \return ʽַ
+/// 可变参数字符串格式化，与va_start()、va_end()宏配合使用
+/// \param format 字符串格式
+/// \param ap 可变参数列表
+/// \return 格式化字符串结果
 string va_sprintf( va_list ap, const string &format ) {
 	int strlen = 256;
 	char *buf = new char[strlen];
@@ -163,8 +163,8 @@ string va_sprintf( va_list ap, const string &format ) {
 
 /// \ingroup waString
 /// \fn string va_str( const char *format, ... )
-/// ʽַأ׼sprintf()ȫͬ
-/// \return ʽַ
+/// 格式化字符串并返回，各参数定义与标准sprintf()函数完全相同
+/// \return 格式化字符串结果
 string va_str( const char *format, ... ) {
 	va_list ap;
 	va_start( ap, format );
@@ -173,8 +173,8 @@ string va_str( const char *format, ... ) {
 	return result;
 }
 
-///  char* ͽ߱ delete[] ͷڴ
-/// \return char*ݽ
+/// 返回 char* 型结果，调用者必须调用 delete[] 释放所返回内存
+/// \return char*类型数据结果
 char* String::c_char() const {
 	size_t size = this->length();
 	char *buf = new char[ size + 1 ];
@@ -183,8 +183,8 @@ char* String::c_char() const {
 	return buf;
 }
 
-/// ַGBKһַ
-/// \return ַ
+/// 返回字符数量，GBK汉字算作一个字符
+/// \return 字符数量
 string::size_type String::w_length() const {
 	size_t wlen = 0;
 	size_t len = this->length();
@@ -198,12 +198,12 @@ string::size_type String::w_length() const {
 	return wlen;
 }
 
-/// ȡַ,ְ
-/// ȡβΪɾ,ɾֺΪַ,
-/// úڽȡʱһַֿ,ַԭеĲַ
-/// \param pos ʼλ,ĬΪ0,ֽڼʽ
-/// \param n Ҫȡַ,ĬΪĩβ,ֽڼʽ
-/// \return ȡַ
+/// 截取子字符串,避免出现半个汉字
+/// 若截取结果的首尾为半个汉字则删除,删除半个汉字后结果可能为空字符串,
+/// 该函数避免在截取时将一个完整汉字分开,对字符串中原有的不完整汉字字符不作处理
+/// \param pos 起始位置,默认为0,单字节计数方式
+/// \param n 要截取的字符串长度,默认为到末尾,单字节计数方式
+/// \return 所截取的字符串
 String String::w_substr( const string::size_type pos, 
 	const string::size_type n ) const 
 {
@@ -232,40 +232,40 @@ String String::w_substr( const string::size_type pos,
         return String( "" );
 }
 
-/// հַ
-/// \param blank Ҫ˵Ŀհַб,ĬΪwebapp::BLANK_CHARS
+/// 清除左侧空白字符
+/// \param blank 要过滤掉的空白字符列表,默认为webapp::BLANK_CHARS
 void String::trim_left( const string &blank ) {
 	while ( this->length()>0 && blank.find(this->at(0))!=npos )
 		this->erase( 0, 1 );
 }
 
-/// Ҳհַ
-/// \param blank Ҫ˵Ŀհַб,ĬΪwebapp::BLANK_CHARS
+/// 清除右侧空白字符
+/// \param blank 要过滤掉的空白字符列表,默认为webapp::BLANK_CHARS
 void String::trim_right( const string &blank ) {
 	while ( this->length()>0 && blank.find(this->at(length()-1))!=npos )
 		erase( this->length()-1, 1 );
 }
 
-/// հַ
-/// \param blank Ҫ˵Ŀհַб,ĬΪwebapp::BLANK_CHARS
+/// 清除两侧空白字符
+/// \param blank 要过滤掉的空白字符列表,默认为webapp::BLANK_CHARS
 void String::trim( const string &blank ) {
 	this->trim_left( blank );
 	this->trim_right( blank );
 }
 
-/// ߽ȡָӴ
-/// \param n Ҫȡַ,ȳ򷵻ԭַ
-/// \return ȡַ
+/// 从左边截取指定长度子串
+/// \param n 要截取的字符串长度,若长度超出则返回原字符串
+/// \return 所截取的字符串
 String String::left( const string::size_type n ) const {
 	size_t len = this->length();
 	len = ( n>len ) ? len : n;
 	return String( this->substr(0,len) );
 }
 
-/// мȡָӴ
-/// \param pos ʼȡλ
-/// \param n Ҫȡַ,ȳ򷵻ԭַ,ĬΪĩβ
-/// \return ȡַ
+/// 从中间截取指定长度子串
+/// \param pos 开始截取的位置
+/// \param n 要截取的字符串长度,若长度超出则返回原字符串,默认为到末尾
+/// \return 所截取的字符串
 String String::mid( const string::size_type pos, 
 	const string::size_type n ) const 
 {
@@ -274,17 +274,17 @@ String String::mid( const string::size_type pos,
 	return String( this->substr(pos,n) );
 }		
 
-/// ұ߽ȡָӴ
-/// \param n Ҫȡַ,ȳ򷵻ԭַ
-/// \return ȡַ
+/// 从右边截取指定长度子串
+/// \param n 要截取的字符串长度,若长度超出则返回原字符串
+/// \return 所截取的字符串
 String String::right( const string::size_type n ) const {
 	size_t len = this->length();
 	len = ( n>len )? n : len;
 	return String( this->substr(len-n,n) );
 }		
 
-/// ַ
-/// \param n ַ,Сڵǰض,ڵǰ򲹳հַ
+/// 调整字符串长度
+/// \param n 新字符串长度,若小于当前长度则截断,若大于当前长度则补充空白字符
 void String::resize( const string::size_type n ) {
 	size_t len = this->length();
 	if ( n < len ) {
@@ -295,9 +295,9 @@ void String::resize( const string::size_type n ) {
 	}
 }
 
-/// ͳָӴֵĴ
-/// \param str ҪҵӴ
-/// \return ӴظֵĴ
+/// 统计指定子串出现的次数
+/// \param str 要查找的子串
+/// \return 子串不重复出现的次数
 int String::count( const string &str ) const {
 	size_t pos = 0;
 	size_t count = 0;
@@ -311,14 +311,14 @@ int String::count( const string &str ) const {
 	return count;
 }
 	
-/// ݷַָָ
-/// \param tag ַָ
-/// \param limit ָ,ĬΪ0
-/// \param mode ģʽ,ѡ
-/// - String::SPLIT_IGNORE_BLANK ָؽֶ
-/// - String::SPLIT_KEEP_BLANK ָؽֶ
-/// - ĬΪString::SPLIT_IGNORE_BLANK
-/// \return ַָ vector<String>
+/// 根据分割符分割字符串
+/// \param tag 分割标记字符串
+/// \param limit 分割次数限制,默认为0即不限制
+/// \param mode 结果返回模式,可选
+/// - String::SPLIT_IGNORE_BLANK 忽略连续多个分隔符，返回结果不含空字段
+/// - String::SPLIT_KEEP_BLANK 不忽略连续多个分隔符，返回结果包含空字段
+/// - 默认为String::SPLIT_IGNORE_BLANK
+/// \return 分割结果字符串数组 vector<String>
 vector<String> String::split( const string &tag, const int limit, 
 	const split_mode mode ) const 
 {
@@ -357,10 +357,10 @@ vector<String> String::split( const string &tag, const int limit,
 	return list;
 }
 
-/// תַΪMAPṹ(map<string,string>)
-/// \param itemtag ʽ֮ķָ,ĬΪ"&"
-/// \param exptag ʽбֵ֮ķָ,ĬΪ"="
-/// \return ת map<string,string>
+/// 转换字符串为MAP结构(map<string,string>)
+/// \param itemtag 表达式之间的分隔符,默认为"&"
+/// \param exptag 表达式中变量名与变量值之间的分隔符,默认为"="
+/// \return 转换结果 map<string,string>
 map<string,string> String::tomap( const string &itemtag, 
 	const string &exptag ) const 
 {
@@ -382,9 +382,9 @@ map<string,string> String::tomap( const string &itemtag,
 	return hashmap;
 }
 
-/// ַ,split()෴
-/// \param strings ַ
-/// \param tag Ϸָ
+/// 组合字符串,与split()相反
+/// \param strings 字符串数组
+/// \param tag 组合分隔符
 void String::join( const vector<string> &strings, const string &tag ) {
 	if ( strings.size() > 0 ) {
 		this->erase();
@@ -405,10 +405,10 @@ void String::join( const vector<String> &strings, const string &tag ) {
 	}
 }
 
-/// ʽֵ
-/// ׼sprintf()ȫͬ
-/// \retval true ִгɹ
-/// \retval false ʧ
+/// 格式化赋值
+/// 各参数定义与标准sprintf()函数完全相同
+/// \retval true 执行成功
+/// \retval false 失败
 bool String::sprintf( const char *format, ... ) {
 	va_list ap;
 	va_start( ap, format );
@@ -417,12 +417,12 @@ bool String::sprintf( const char *format, ... ) {
 	return true;
 }
 
-/// 滻
-/// ústring::replace()
-/// \param oldstr 滻ַ
-/// \param newstr 滻ַַ
-/// \retval 1 滻ɹ
-/// \retval 0 ʧ
+/// 替换
+/// 该函数重载了string::replace()
+/// \param oldstr 被替换掉的字符串
+/// \param newstr 用来替换旧字符串的新字符串
+/// \retval 1 替换成功
+/// \retval 0 失败
 int String::replace( const string &oldstr, const string &newstr ) {
 	size_t pos = 0;
 	if ( oldstr!="" && (pos=this->find(oldstr))!=npos ) {
@@ -432,10 +432,10 @@ int String::replace( const string &oldstr, const string &newstr ) {
 	return 0;
 }
 
-/// ȫ滻
-/// \param oldstr 滻ַ
-/// \param newstr 滻ַַ
-/// \return ִ滻Ĵ
+/// 全文替换
+/// \param oldstr 被替换掉的字符串
+/// \param newstr 用来替换旧字符串的新字符串
+/// \return 执行替换的次数
 int String::replace_all( const string &oldstr, const string &newstr ) {
 	if ( oldstr == "" )
 		return 0;
@@ -451,21 +451,21 @@ int String::replace_all( const string &oldstr, const string &newstr ) {
 	return i;
 }
 
-/// תΪдĸ
+/// 转换为大写字母
 void String::upper() {
 	for( size_t i=0; i<this->length(); i++ )
 		(*this)[i] = toupper( (*this)[i] );
 }
 
-/// תΪСдĸ
+/// 转换为小写字母
 void String::lower() {
 	for( size_t i=0; i<this->length(); i++ )
 		(*this)[i] = tolower( (*this)[i] );
 }
 
-/// ַǷȫ
-/// \retval true 
-/// \retval false 
+/// 字符串是否完全由数字组成
+/// \retval true 是
+/// \retval false 否
 bool String::isnum() const {
 	if ( this->length() == 0 )
 		return false;
@@ -477,10 +477,10 @@ bool String::isnum() const {
 	return true;
 }
 
-/// ȡļַ
-/// \param filename Ҫȡļ·
-/// \retval true ȡɹ
-/// \retval false ʧ
+/// 读取文件到字符串
+/// \param filename 要读取的文件完整路径名称
+/// \retval true 读取成功
+/// \retval false 失败
 bool String::load_file( const string &filename ) {
 	FILE *fp = fopen( filename.c_str(), "rb" );
 	if ( fp == NULL ) return false;
@@ -499,12 +499,12 @@ bool String::load_file( const string &filename ) {
 	return true;
 }
 
-/// ַļ
-/// \param filename Ҫдļ·
-/// \param mode д뷽ʽ,ĬΪios::trunc|ios::out
-/// \param permission ļԲĬΪ0666
-/// \retval true дɹ
-/// \retval false ʧ
+/// 保存字符串到文件
+/// \param filename 要写入的文件路径名称
+/// \param mode 写入方式,默认为ios::trunc|ios::out
+/// \param permission 文件属性参数，默认为0666
+/// \retval true 写入成功
+/// \retval false 失败
 bool String::save_file( const string &filename, const ios::openmode mode,
 	const mode_t permission ) const 
 {
@@ -1,7 +1,8 @@
 /// \file waTemplate.cpp
-/// HTMLģ崦ʵļ
+/// HTML模板处理类实现文件
 
 #include <cstdio>
+#include <cctype>
 #include <cstdarg>
 #include <ctime>
 #include <iostream>
@@ -9,6 +10,11 @@
 #include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <list>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "waResponse.h"
 #include "waTemplate.h"
 
 using namespace std;
@@ -16,15 +22,464 @@ using namespace std;
 /// Web Application Library namaspace
 namespace webapp {
 	
+/// 模板缓存
+/// 以模板文件名为索引保存编译后的模板,按最近使用顺序淘汰
+struct Template::tmpl_cache {
+	typedef struct {					// 缓存项
+		tmpl_program *program;			// 编译后的模板
+		time_t mtime;					// 文件修改时间
+		off_t size;						// 文件长度
+		ino_t ino;						// 文件inode
+		list<string>::iterator lru;		// 在LRU列表中的位置
+	} tmpl_cacheitem;
+	typedef map<string,tmpl_cacheitem> tmpl_cacheitems;
+
+	pthread_mutex_t lock;				// 互斥锁
+	size_t limit;						// 内存上限,为0则不缓存
+	size_t bytes;						// 已缓存模板占用内存估计值
+	size_t hits;						// 命中次数
+	size_t misses;						// 未命中次数
+	tmpl_cacheitems items;				// 缓存项列表 <模板文件名,缓存项>,包含模板文件名前加 TMPL_INCLUDE
+	list<string> lru;					// 最近使用的模板文件名在前
+
+	tmpl_cache():
+	limit(TMPL_CACHE_SIZE), bytes(0), hits(0), misses(0)
+	{
+		pthread_mutex_init( &lock, NULL );
+	}
+
+	// 删除缓存项
+	void erase( tmpl_cacheitems::iterator i ) {
+		bytes -= i->second.program->bytes;
+		Template::release( i->second.program );
+		lru.erase( i->second.lru );
+		items.erase( i );
+	}
+
+	// 淘汰最久未使用的缓存项直到不超过内存上限
+	void shrink() {
+		while ( !lru.empty() && bytes>limit )
+			this->erase( items.find(lru.back()) );
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Template
+
+/// 拷贝构造函数
+/// 与原对象共享编译后的模板
+/// \param copy 原对象
+Template::Template( const Template &copy ):
+_program(NULL), _lastloop(NULL), _escape(ESCAPE_NONE), _curloop(NULL), _exec(NULL), _slotmap(NULL), _colbase(0),
+_flushrows(0), _response(NULL), _outbytes(0), _profile(false), _debug(TMPL_OUTPUT_RELEASE)
+{
+	*this = copy;
+}
+
+/// 拷贝赋值操作
+/// 与原对象共享编译后的模板
+/// \param copy 原对象
+Template& Template::operator = ( const Template &copy ) {
+	if ( this == &copy )
+		return *this;
+
+	if ( copy._program != NULL )
+		__sync_add_and_fetch( &copy._program->refs, 1 );
+	Template::release( _program );
+	_program = copy._program;
+
+	_values = copy._values;
+	_sets = copy._sets;
+	_loops = copy._loops;
+	_lastloop = NULL;
+	_escape = copy._escape;
+	_curloop = NULL;
+	_cursor = 0;
+	_colcache.assign( copy._colcache.size(), tmpl_colcache(NULL,-1) );
+	_flushrows = copy._flushrows;
+	_profile = copy._profile;
+	_stats.clear();
+	_tmplfile = copy._tmplfile;
+	memcpy( _date, copy._date, sizeof(_date) );
+	memcpy( _time, copy._time, sizeof(_time) );
+	_debug = copy._debug;
+	_errlog = copy._errlog;
+	return *this;
+}
+
+/// 析构函数
+Template::~Template() {
+	Template::release( _program );
+}
+
+/// 片段缓存
+/// 以缓存键为索引保存 {{#CACHE}} 块的输出结果,按最近使用顺序淘汰
+struct Template::tmpl_fragments {
+	typedef struct {					// 缓存项
+		string html;					// 块输出结果
+		time_t expire;					// 过期时间,为0则不过期
+		list<string>::iterator lru;		// 在LRU列表中的位置
+	} tmpl_fragitem;
+	typedef map<string,tmpl_fragitem> tmpl_fragitems;
+
+	pthread_mutex_t lock;				// 互斥锁
+	size_t limit;						// 内存上限,为0则不缓存
+	size_t bytes;						// 已缓存内容占用内存估计值
+	tmpl_fragitems items;				// 缓存项列表 <缓存键,缓存项>
+	list<string> lru;					// 最近使用的缓存键在前
+
+	tmpl_fragments():
+	limit(TMPL_FRAGMENT_SIZE), bytes(0)
+	{
+		pthread_mutex_init( &lock, NULL );
+	}
+
+	// 缓存项占用内存估计值
+	static size_t size( const string &key, const string &html ) {
+		return key.size()*2 + html.size() + sizeof(tmpl_fragitem);
+	}
+
+	// 删除缓存项
+	void erase( tmpl_fragitems::iterator i ) {
+		bytes -= size( i->first, i->second.html );
+		lru.erase( i->second.lru );
+		items.erase( i );
+	}
+
+	// 淘汰最久未使用的缓存项直到不超过内存上限
+	void shrink() {
+		while ( !lru.empty() && bytes>limit )
+			this->erase( items.find(lru.back()) );
+	}
+};
+
+/// 片段缓存块输出状态
+/// 未命中片段缓存时块内输出写入 html,块结束时保存并输出至上层输出流
+struct Template::tmpl_capture {
+	ostream *output;					// 上层输出流
+	ostringstream html;					// 块输出结果
+	string key;							// 缓存键
+	int ttl;							// 缓存时间
+};
+
+////////////////////////////////////////////////////////////////////////////
+// TemplateStream
+
+/// 构造函数
+/// \param reader 读取函数,每次调用读取一行数据
+/// \param arg 传递给读取函数的参数
+/// \param field_0 field_0及field_0之后为字段名称列表,最后一个参数必须是NULL
+/// \param ... 字段名称列表,最后一个参数必须是NULL
+TemplateStream::TemplateStream( tmpl_row_reader reader, void *arg, const char* field_0, ... ):
+_reader(reader), _arg(arg), _rows(0), _eof(false)
+{
+	va_list ap;
+	const char *p;
+	int cols = 0;
+
+	va_start( ap, field_0 );
+	for ( p=field_0; p; p=va_arg(ap,const char*) ) {
+		if ( *p != '\0' )
+			_fieldspos[p] = cols++;
+	}
+	va_end( ap );
+	_ends.reserve( cols );
+}
+
+/// 添加一个字段值到当前行
+/// 在读取函数中按构造时定义的字段顺序依次调用
+/// \param value 字段值
+/// \param length 字段值长度
+void TemplateStream::append( const char *value, const size_t length ) {
+	_arena.append( value, length );
+	_ends.push_back( _arena.size() );
+}
+
+/// 添加一个整数字段值到当前行
+/// \param value 字段值
+void TemplateStream::append( const long value ) {
+	char buf[32];
+	int len = snprintf( buf, sizeof(buf), "%ld", value );
+	this->append( buf, len );
+}
+
+/// 返回字段位置
+/// \param field 字段名
+/// \return 字段位置,不存在返回-1
+int TemplateStream::field_pos( const string &field ) {
+	map<string,int>::const_iterator i = _fieldspos.find( field );
+	return ( i!=_fieldspos.end() ) ? i->second : -1;
+}
+
+/// 读取指定行
+/// 只能读取当前行或下一行,读取下一行时调用读取函数
+/// \param row 行位置
+/// \retval true 成功
+/// \retval false 数据已结束或该行不能读取
+bool TemplateStream::fetch( const size_t row ) {
+	if ( _rows>0 && row==_rows-1 )
+		return true;
+	if ( _eof || row!=_rows || _reader==NULL )
+		return false;
+
+	// read next row, reuse buffer
+	_arena.clear();
+	_ends.clear();
+	if ( !_reader(*this,_arg) ) {
+		_eof = true;
+		return false;
+	}
+	++_rows;
+	return true;
+}
+
+/// 返回当前行指定位置的字段值
+/// \param col 字段位置
+/// \param length 字段值长度
+/// \return 字段值,读取函数未添加该字段时返回NULL
+const char* TemplateStream::value( const int col, size_t &length ) {
+	if ( col<0 || static_cast<size_t>(col)>=_ends.size() )
+		return NULL;
+	size_t start = ( col>0 ) ? _ends[col-1] : 0;
+	length = _ends[col] - start;
+	return _arena.data() + start;
+}
+
+////////////////////////////////////////////////////////////////////////////
+// template cache
+
+/// 模板缓存
+/// \return 进程内唯一的模板缓存
+Template::tmpl_cache& Template::cache() {
+	static tmpl_cache cache;
+	return cache;
+}
+
+/// 从模板缓存读取模板文件
+/// 文件修改时间、长度或inode与缓存不同,或任一层包含模板文件已修改时重新读取并编译
+/// \param tmpl_file 模板路径文件名
+/// \param depth 包含模板嵌套层数,大于0时作为包含模板编译,与直接读取的模板分别缓存
+/// \return 编译后的模板,已增加引用计数,读取失败返回NULL
+Template::tmpl_program* Template::cache_load( const string &tmpl_file, const int depth ) {
+	struct stat st;
+	if ( stat(tmpl_file.c_str(),&st) != 0 )
+		return NULL;
+	const string key = ( depth>0 ) ? string(TMPL_INCLUDE)+" "+tmpl_file : tmpl_file;
+
+	// cached and not modified
+	tmpl_cache &cache = Template::cache();
+	pthread_mutex_lock( &cache.lock );
+	tmpl_cache::tmpl_cacheitems::iterator i = cache.items.find( key );
+	if ( i!=cache.items.end() && i->second.mtime==st.st_mtime &&
+		 i->second.size==st.st_size && i->second.ino==st.st_ino ) {
+		++cache.hits;
+		cache.lru.splice( cache.lru.begin(), cache.lru, i->second.lru );
+		tmpl_program *program = i->second.program;
+		__sync_add_and_fetch( &program->refs, 1 );
+		pthread_mutex_unlock( &cache.lock );
+
+		// check included files without lock
+		if ( program->includes.empty() || !Template::modified(program) )
+			return program;
+		Template::release( program );
+		pthread_mutex_lock( &cache.lock );
+		--cache.hits;
+	}
+	++cache.misses;
+	pthread_mutex_unlock( &cache.lock );
+
+	// read and compile without lock
+	tmpl_program *program = new tmpl_program;
+	program->refs = 1;
+	program->file = tmpl_file;
+	program->mtime = st.st_mtime;
+	program->size = st.st_size;
+	program->ino = st.st_ino;
+	if ( !program->tmpl.load_file(tmpl_file) ) {
+		delete program;
+		return NULL;
+	}
+	Template::compile( *program, depth );
+
+	// add to cache
+	pthread_mutex_lock( &cache.lock );
+	if ( program->bytes <= cache.limit ) {
+		if ( (i=cache.items.find(key)) != cache.items.end() )
+			cache.erase( i ); // modified or loaded by other thread
+		
+		tmpl_cache::tmpl_cacheitem &item = cache.items[key];
+		item.program = program;
+		item.mtime = st.st_mtime;
+		item.size = st.st_size;
+		item.ino = st.st_ino;
+		cache.lru.push_front( key );
+		item.lru = cache.lru.begin();
+		cache.bytes += program->bytes;
+		__sync_add_and_fetch( &program->refs, 1 );
+		cache.shrink();
+	}
+	pthread_mutex_unlock( &cache.lock );
+	return program;
+}
+
+/// 检查包含模板文件是否已修改
+/// \param program 编译后的模板
+/// \retval true 任一层包含模板文件已修改或已删除
+/// \retval false 未修改
+bool Template::modified( const tmpl_program *program ) {
+	struct stat st;
+	for ( size_t i=0; i<program->includes.size(); ++i ) {
+		const tmpl_program *include = program->includes[i].program;
+		if ( stat(include->file.c_str(),&st)!=0 || include->mtime!=st.st_mtime ||
+			 include->size!=st.st_size || include->ino!=st.st_ino )
+			return true;
+		if ( Template::modified(include) )
+			return true;
+	}
+	return false;
+}
+
+/// 释放编译后的模板
+/// 减少引用计数,为0时删除并释放包含模板
+/// \param program 编译后的模板,可为NULL
+void Template::release( tmpl_program *program ) {
+	if ( program!=NULL && __sync_sub_and_fetch(&program->refs,1)==0 ) {
+		for ( size_t i=0; i<program->includes.size(); ++i )
+			Template::release( program->includes[i].program );
+		delete program;
+	}
+}
+
+/// 设置模板缓存内存上限
+/// 超过上限时淘汰最久未使用的模板,正在使用的模板在释放后删除,
+/// 默认为 TMPL_CACHE_SIZE,线程安全
+/// \param max_bytes 内存上限,单位为byte,为0则不缓存模板
+void Template::set_cache( const size_t max_bytes ) {
+	tmpl_cache &cache = Template::cache();
+	pthread_mutex_lock( &cache.lock );
+	cache.limit = max_bytes;
+	cache.shrink();
+	pthread_mutex_unlock( &cache.lock );
+}
+
+/// 清空模板缓存
+/// 不清除命中次数统计,线程安全
+void Template::clear_cache() {
+	tmpl_cache &cache = Template::cache();
+	pthread_mutex_lock( &cache.lock );
+	while ( !cache.items.empty() )
+		cache.erase( cache.items.begin() );
+	pthread_mutex_unlock( &cache.lock );
+}
+
+/// 模板缓存统计
+/// 线程安全
+/// \return 命中次数,未命中次数,已缓存模板数量及占用内存估计值
+Template::cache_stat Template::cache_stats() {
+	tmpl_cache &cache = Template::cache();
+	cache_stat stat;
+	pthread_mutex_lock( &cache.lock );
+	stat.hits = cache.hits;
+	stat.misses = cache.misses;
+	stat.files = cache.items.size();
+	stat.bytes = cache.bytes;
+	pthread_mutex_unlock( &cache.lock );
+	return stat;
+}
+
+/// 片段缓存
+/// \return 进程内唯一的片段缓存
+Template::tmpl_fragments& Template::fragments() {
+	static tmpl_fragments fragments;
+	return fragments;
+}
+
+/// 设置片段缓存内存上限
+/// 超过上限时淘汰最久未使用的片段,默认为 TMPL_FRAGMENT_SIZE,线程安全
+/// \param max_bytes 内存上限,单位为byte,为0则不缓存片段
+void Template::set_fragment_cache( const size_t max_bytes ) {
+	tmpl_fragments &fragments = Template::fragments();
+	pthread_mutex_lock( &fragments.lock );
+	fragments.limit = max_bytes;
+	fragments.shrink();
+	pthread_mutex_unlock( &fragments.lock );
+}
+
+/// 清除片段缓存
+/// 用于片段内容对应的数据修改后立即更新,线程安全
+/// \param key 缓存键,即 {{#CACHE}} 中变量替换后的缓存键,默认为空即清除全部片段
+void Template::clear_fragment( const string &key ) {
+	tmpl_fragments &fragments = Template::fragments();
+	pthread_mutex_lock( &fragments.lock );
+	if ( key == "" ) {
+		fragments.items.clear();
+		fragments.lru.clear();
+		fragments.bytes = 0;
+	} else {
+		tmpl_fragments::tmpl_fragitems::iterator i = fragments.items.find( key );
+		if ( i != fragments.items.end() )
+			fragments.erase( i );
+	}
+	pthread_mutex_unlock( &fragments.lock );
+}
+
+/// 读取片段缓存
+/// 命中时缓存内容复制到 _fragment
+/// \param key 缓存键
+/// \retval true 命中
+/// \retval false 未缓存或已过期
+bool Template::fetch_fragment( const string &key ) {
+	tmpl_fragments &fragments = Template::fragments();
+	bool hit = false;
+	pthread_mutex_lock( &fragments.lock );
+	tmpl_fragments::tmpl_fragitems::iterator i = fragments.items.find( key );
+	if ( i != fragments.items.end() ) {
+		if ( i->second.expire!=0 && i->second.expire<=time(0) ) {
+			fragments.erase( i );
+		} else {
+			_fragment.assign( i->second.html );
+			fragments.lru.splice( fragments.lru.begin(), fragments.lru, i->second.lru );
+			hit = true;
+		}
+	}
+	pthread_mutex_unlock( &fragments.lock );
+	return hit;
+}
+
+/// 保存片段缓存
+/// \param key 缓存键
+/// \param html 块输出结果
+/// \param ttl 缓存时间,单位为秒,为0则不过期
+void Template::store_fragment( const string &key, const string &html, const int ttl ) {
+	tmpl_fragments &fragments = Template::fragments();
+	pthread_mutex_lock( &fragments.lock );
+	if ( fragments.limit > 0 ) {
+		tmpl_fragments::tmpl_fragitems::iterator i = fragments.items.find( key );
+		if ( i != fragments.items.end() )
+			fragments.erase( i );
+
+		tmpl_fragments::tmpl_fragitem &item = fragments.items[key];
+		item.html = html;
+		item.expire = ( ttl>0 ) ? time(0)+ttl : 0;
+		item.lru = fragments.lru.insert( fragments.lru.begin(), key );
+		fragments.bytes += tmpl_fragments::size( key, html );
+		fragments.shrink();
+	}
+	pthread_mutex_unlock( &fragments.lock );
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // set functions
 
-/// ȡHTMLģļ
-/// \param tmpl_file ģ·ļ
-/// \retval true ȡɹ
-/// \retval false ʧ
+/// 读取HTML模板文件
+/// 优先使用模板缓存中未修改的编译结果
+/// \param tmpl_file 模板路径文件名
+/// \retval true 读取成功
+/// \retval false 失败
 bool Template::load( const string &tmpl_file ) {
-	if ( _tmpl.load_file(tmpl_file) ) {
+	tmpl_program *program = Template::cache_load( tmpl_file );
+	if ( program != NULL ) {
+		this->bind( program );
 		_tmplfile = tmpl_file;
 		return true;
 	} else {
@@ -34,115 +489,185 @@ bool Template::load( const string &tmpl_file ) {
 	}
 }
 
-/// HTMLģ
-/// \param tmpl ģַ
+/// 设置HTML模板内容
+/// 从字符串设置的模板不使用模板缓存
+/// \param tmpl 模板内容字符串
 void Template::tmpl( const string &tmpl ) {
+	tmpl_program *program = new tmpl_program;
+	program->refs = 1;
+	program->mtime = 0;
+	program->size = 0;
+	program->ino = 0;
+	program->tmpl = tmpl;
+	Template::compile( *program );
+
+	this->bind( program );
 	_tmplfile = "Read from string";
-	_tmpl = tmpl;
 }
 
-/// 滻
-/// \param name ģ
-/// \param value 滻ֵ
+/// 使用编译后的模板
+/// 已设置的替换值按模板域名称转移到新模板的模板域位置
+/// \param program 编译后的模板,已增加引用计数
+void Template::bind( tmpl_program *program ) {
+	// values of old template
+	if ( _program != NULL ) {
+		for ( size_t i=0; i<_values.size(); ++i ) {
+			if ( _values[i] != "" )
+				_sets[_program->names[i]].swap( _values[i] );
+		}
+	}
+	Template::release( _program );
+	_program = program;
+	_stats.clear();
+
+	// field positions cached by parse(), included templates after own codes
+	_colcache.assign( program->cols, tmpl_colcache(NULL,-1) );
+
+	// values of new template
+	_values.clear();
+	_values.resize( program->names.size() );
+	for ( size_t i=0; i<_values.size(); ++i ) {
+		map<string,string>::iterator v = _sets.find( program->names[i] );
+		if ( v != _sets.end() ) {
+			_values[i].swap( v->second );
+			_sets.erase( v );
+		}
+	}
+}
+
+/// 返回模板域位置
+/// 模板域位置在读取模板后有效,重新读取模板后需要重新获取
+/// \param name 模板域名称
+/// \return 模板域位置,模板中没有该模板域时返回-1
+int Template::slot( const string &name ) const {
+	if ( _program == NULL )
+		return -1;
+	map<string,int>::const_iterator i = _program->slots.find( name );
+	return ( i!=_program->slots.end() ) ? i->second : -1;
+}
+
+/// 设置替换规则
+/// \param name 模板域名称
+/// \param value 替换值
 void Template::set( const string &name, const string &value ) {
-	if ( name != "" )
+	if ( name == "" )
+		return;
+	int slot = this->slot( name );
+	if ( slot >= 0 )
+		_values[slot] = value;
+	else
 		_sets[name] = value;
 }
 
-/// ½ѭ
-/// \param loop ѭ
-/// \param field_0 field_0field_0֮Ϊֶб,һNULL
-/// \param ... ֶб,һNULL
+/// 设置替换规则
+/// \param slot 模板域位置,由 slot() 返回
+/// \param value 替换值
+void Template::set( const int slot, const string &value ) {
+	if ( slot>=0 && static_cast<size_t>(slot)<_values.size() )
+		_values[slot] = value;
+}
+
+#if __cplusplus >= 201103L
+/// 设置替换规则
+/// 不复制替换值
+/// \param name 模板域名称
+/// \param value 替换值
+void Template::set( const string &name, string &&value ) {
+	if ( name == "" )
+		return;
+	int slot = this->slot( name );
+	if ( slot >= 0 )
+		_values[slot] = std::move( value );
+	else
+		_sets[name] = std::move( value );
+}
+
+/// 设置替换规则
+/// 不复制替换值
+/// \param slot 模板域位置,由 slot() 返回
+/// \param value 替换值
+void Template::set( const int slot, string &&value ) {
+	if ( slot>=0 && static_cast<size_t>(slot)<_values.size() )
+		_values[slot] = std::move( value );
+}
+#endif
+
+/// 新建循环
+/// \param loop 循环名称
+/// \param field_0 field_0及field_0之后为字段名称列表,最后一个参数必须是NULL
+/// \param ... 字段名称列表,最后一个参数必须是NULL
 void Template::def_loop( const string &loop, const char* field_0, ... ) {
 	va_list ap;
 	const char *p;
 	string field;
-	strings fields;
-	size_t cols = 0;
-	
-	// check same name loop
-	if ( _loops.find(loop) != _loops.end() )
-		this->error_log( 0, "Warning: loop name \""+loop+"\" redefined" );
-	
+	tmpl_loop &data = this->init_loop( loop );
+
 	// get fields
 	va_start( ap, field_0 );
 	for ( p=field_0; p; p=va_arg(ap,const char*) ) {
 		if ( (field=p) != "" ) {
-			fields.push_back( field );
-			_loops[loop].fieldspos[field] = cols; // for speed
-			++cols;
+			data.fields.push_back( field );
+			data.fieldspos[field] = data.cols; // for speed
+			++data.cols;
 		}
 	}
 	va_end( ap );
+}
 
-	// for waTemplate old version templet script ( < v0.7 )
-	if ( _sets.find(loop) == _sets.end() )
-		set( loop, loop );
-
-	// init loop
-	_loops[loop].fields = fields;
-	for ( size_t i=0; i<_loops[loop].datas.size(); ++i )
-		_loops[loop].datas[i].clear();
-	_loops[loop].datas.clear();
-	_loops[loop].cursor = 0;
-	_loops[loop].rows = 0;
-	_loops[loop].cols = cols;
-}
-
-/// һݵѭ
-/// ȵTemplate::def_loop()ʼѭֶζ,ֹ
-/// \param loop ѭ
-/// \param value_0 value_0value_0֮Ϊֶб,һNULL
-/// \param ... ֶб,һNULL
+/// 添加一行数据到循环
+/// 必须先调用Template::def_loop()初始化循环字段定义,否则中止
+/// \param loop 循环名称
+/// \param value_0 value_0及value_0之后为字段名称列表,最后一个参数必须是NULL
+/// \param ... 字段名称列表,最后一个参数必须是NULL
 void Template::append_row( const string &loop, const char* value_0, ... ) {
 	// loop must exist
-	if ( _loops.find(loop) == _loops.end() ) {
+	tmpl_loop *data = this->find_loop( loop );
+	if ( data == NULL ) {
 		this->error_log( 0, "Error: Call def_loop() to init $"+loop+" first, in append_row()" );
 		return;
 	}
+	if ( data->cols == 0 ) {
+		++data->rows;
+		return;
+	}
 	
 	// get values
 	va_list ap;
 	const char *p;
-	string value;
-	strings values;
 	int cols = 0;
 	
 	va_start( ap, value_0 );
 	for ( p=value_0; p; p=va_arg(ap,const char*) ) {
-		value = p;
-		values.push_back( value );
-		++cols;
+		this->append_cell( *data, p, strlen(p) );
 		
 		// enough now
-		if ( cols >= _loops[loop].cols )
+		if ( ++cols >= data->cols )
 			break;
 	}
 	va_end( ap );
 
 	// fill blank if not enough
-	if( cols < _loops[loop].cols ) {
-		for ( int i=cols; i<_loops[loop].cols; ++i )
-			values.push_back( "" );
-	}
-	
-	// insert into loop
-	_loops[loop].datas.push_back( values );
-	++_loops[loop].rows;
+	for ( ; cols<data->cols; ++cols )
+		this->append_cell( *data, "", 0 );
 }
 
-/// һָʽݵѭ
-/// ȵTemplate::def_loop()ʼѭֶζ,ֹ
-/// \param loop ѭ
-/// \param format ֶѭʽ,"%d,%s,..."ʽ
-/// \param ... Ϊֵֶб,
-/// ֵֶڸʽformatָĸ
+/// 添加一行指定格式的数据到循环
+/// 必须先调用Template::def_loop()初始化循环字段定义,否则中止
+/// \param loop 循环名称
+/// \param format 字段列循环式定义,"%d,%s,..."格式
+/// \param ... 第三个参数起为字段值列表,
+/// 字段值参数个数不能少于格式定义参数format中指定的个数
 void Template::append_format( const string &loop, const char* format, ... ) {
 	// loop must exist
-	if ( _loops.find(loop) == _loops.end() ) {
+	tmpl_loop *data = this->find_loop( loop );
+	if ( data == NULL ) {
 		this->error_log( 0, "Error: Call def_loop() to init $"+loop+" first, in append_format()" );
 		return;
 	}
+	if ( data->cols == 0 ) {
+		++data->rows;
+		return;
+	}
 	
 	// split format string
 	String fmtstr = format;
@@ -150,66 +675,171 @@ void Template::append_format( const string &loop, const char* format, ... ) {
 	
 	// get values
 	va_list ap;
-	string value;
-	strings values;
 	int cols = 0;
+	char buf[32];
 	
 	va_start( ap, format );
 	for ( size_t i=0; i<fmtlist.size(); ++i ) {
-		// read
+		// read and push data
 		fmtlist[i].trim();
-		if ( fmtlist[i] == TMPL_FMTSTR )
-			value = va_arg( ap, const char* ); // %s
-		else
-			value = itos( va_arg(ap,long) ); // %d or other
-			
-		// push data
-		values.push_back( value );
-		++cols;
+		if ( fmtlist[i] == TMPL_FMTSTR ) {
+			// %s
+			const char *value = va_arg( ap, const char* );
+			this->append_cell( *data, value, strlen(value) );
+		} else {
+			// %d or other
+			int len = snprintf( buf, sizeof(buf), "%ld", va_arg(ap,long) );
+			this->append_cell( *data, buf, len );
+		}
 
 		// enough now
-		if ( cols >= _loops[loop].cols )
+		if ( ++cols >= data->cols )
 			break;
 	}
 	va_end( ap );
 
 	// fill blank if not enough
-	if( cols < _loops[loop].cols ) {
-		for ( int i=cols; i<_loops[loop].cols; ++i )
-			values.push_back( "" );
+	for ( ; cols<data->cols; ++cols )
+		this->append_cell( *data, "", 0 );
+}
+
+/// 预留循环数据空间
+/// 必须先调用Template::def_loop()初始化循环字段定义
+/// \param loop 循环名称
+/// \param rows 预计数据行数
+/// \param bytes 预计全部字段值总长度,默认为0即不预留
+void Template::reserve( const string &loop, const size_t rows, const size_t bytes ) {
+	tmpl_loop *data = this->find_loop( loop );
+	if ( data == NULL ) {
+		this->error_log( 0, "Error: Call def_loop() to init $"+loop+" first, in reserve()" );
+		return;
 	}
-	
-	// insert into loop
-	_loops[loop].datas.push_back( values );
-	++_loops[loop].rows;
+	data->ends.reserve( rows*data->cols );
+	if ( bytes > 0 )
+		data->arena.reserve( bytes );
+}
+
+/// 添加一个字段值到循环
+/// 按 def_loop() 定义的字段顺序依次添加,添加满一行的字段值后开始新的一行,
+/// 同一行中不能与 append_row(),append_format() 混用,
+/// 必须先调用Template::def_loop()初始化循环字段定义,否则中止
+/// \param loop 循环名称
+/// \param value 字段值
+/// \param length 字段值长度
+void Template::append( const string &loop, const char *value, const size_t length ) {
+	tmpl_loop *data = this->find_loop( loop );
+	if ( data == NULL ) {
+		this->error_log( 0, "Error: Call def_loop() to init $"+loop+" first, in append()" );
+		return;
+	}
+	this->append_cell( *data, value, length );
+}
+
+/// 添加一个整数字段值到循环
+/// \param loop 循环名称
+/// \param value 字段值
+void Template::append( const string &loop, const long value ) {
+	char buf[32];
+	int len = snprintf( buf, sizeof(buf), "%ld", value );
+	this->append( loop, buf, len );
+}
+
+/// 添加一个浮点数字段值到循环
+/// \param loop 循环名称
+/// \param value 字段值
+/// \param ndigit 小数位数,默认为2
+void Template::append( const string &loop, const double value, const int ndigit ) {
+	char buf[64];
+	int len = snprintf( buf, sizeof(buf), "%.*f", ndigit, value );
+	if ( len >= static_cast<int>(sizeof(buf)) )
+		this->append( loop, ftos(value,ndigit) );
+	else
+		this->append( loop, buf, len );
 }
 
-/// 滻
-/// ѭ滻
+/// 设置循环数据源
+/// 输出时按行从数据源读取字段值,字段名称由数据源 TemplateSource::field_pos() 转换为字段位置,
+/// 数据源对象由调用者管理,输出前不能释放,
+/// 重复调用或调用 def_loop() 则替换原循环数据
+/// \param loop 循环名称
+/// \param source 循环数据源,如 MysqlData
+void Template::set_loop( const string &loop, TemplateSource &source ) {
+	this->init_loop( loop ).source = &source;
+}
+
+/// 清空所有替换规则
+/// 包括所有循环替换规则
 void Template::clear_set() {
+	_values.assign( _values.size(), "" );
 	_sets.clear();
 	_loops.clear();
+	_lastloop = NULL;
+	_colcache.assign( _colcache.size(), tmpl_colcache(NULL,-1) );
 }
 
-////////////////////////////////////////////////////////////////////////////
-// parse functions
+/// 初始化循环
+/// \param loop 循环名称
+/// \return 已清空的循环模板设置结构
+Template::tmpl_loop& Template::init_loop( const string &loop ) {
+	// check same name loop
+	if ( _loops.find(loop) != _loops.end() )
+		this->error_log( 0, "Warning: loop name \""+loop+"\" redefined" );
+	
+	// init loop
+	tmpl_loop &data = _loops[loop];
+	data.fields.clear();
+	data.fieldspos.clear();
+	data.arena.clear();
+	data.ends.clear();
+	data.source = NULL;
+	data.cursor = 0;
+	data.rows = 0;
+	data.cols = 0;
 
-/// ֶλ
-/// \param loop ѭ
-/// \param field ֶ
-/// \return ҵֶλ,򷵻-1
-int Template::field_pos( const string &loop, const string &field ) {
-	if ( _loops[loop].fieldspos.find(field) == _loops[loop].fieldspos.end() )
-		return -1;
-	return _loops[loop].fieldspos[field];
+	// for waTemplate old version templet script ( < v0.7 )
+	int slot = this->slot( loop );
+	if ( (slot>=0 && _values[slot]=="") || (slot<0 && _sets.find(loop)==_sets.end()) )
+		this->set( loop, loop );
+
+	// field positions cached by parse()
+	_colcache.assign( _colcache.size(), tmpl_colcache(NULL,-1) );
+	return data;
+}
+
+/// 查找循环
+/// 连续添加数据时不重复查找
+/// \param loop 循环名称
+/// \return 循环模板设置结构,未定义返回NULL
+Template::tmpl_loop* Template::find_loop( const string &loop ) {
+	if ( _lastloop!=NULL && _lastname==loop )
+		return _lastloop;
+	map<string,tmpl_loop>::iterator i = _loops.find( loop );
+	if ( i == _loops.end() )
+		return NULL;
+	_lastname = loop;
+	return ( _lastloop = &i->second );
+}
+
+/// 添加一个字段值到循环数据
+/// \param data 循环模板设置结构
+/// \param value 字段值
+/// \param length 字段值长度
+void Template::append_cell( tmpl_loop &data, const char *value, const size_t length ) {
+	data.arena.append( value, length );
+	data.ends.push_back( data.arena.size() );
+	if ( data.ends.size() == static_cast<size_t>(data.rows+1)*data.cols )
+		++data.rows;
 }
 
-/// ȡָλõģűͼʽ
-/// \param tmpl ģַ
-/// \param pos ʼλ
-/// \param exp ȡıʽַ
-/// \param type Ľű
-/// \return ֵΪηַ,-1
+////////////////////////////////////////////////////////////////////////////
+// parse functions
+
+/// 读取指定位置的模板脚本类型及表达式
+/// \param tmpl 模板字符串
+/// \param pos 开始分析的位置
+/// \param exp 读取出的表达式字符串
+/// \param type 分析出的脚本语句类型
+/// \return 返回值为本次分析的字符串长度,若出错返回-1
 int Template::parse_script( const string &tmpl, const size_t pos, 
 	string &exp, int &type ) 
 {
@@ -261,6 +891,22 @@ int Template::parse_script( const string &tmpl, const size_t pos,
 		// if end: #ENDIF
 		type = TMPL_S_ENDIF;
 	
+	} else if ( strncmp(content.c_str(),TMPL_CACHE,TMPL_CACHE_LEN) == 0 ) {
+		// fragment cache begin: #CACHE key ttl
+		type = TMPL_S_CACHE;
+		content = tmpl.substr( begin+TMPL_CACHE_LEN, end-begin-TMPL_CACHE_LEN );
+		content.trim();
+	
+	} else if ( strcmp(content.c_str(),TMPL_ENDCACHE) == 0 ) {
+		// fragment cache end: #ENDCACHE
+		type = TMPL_S_ENDCACHE;
+	
+	} else if ( strncmp(content.c_str(),TMPL_INCLUDE,TMPL_INCLUDE_LEN) == 0 ) {
+		// include template file: #INCLUDE file
+		type = TMPL_S_INCLUDE;
+		content = tmpl.substr( begin+TMPL_INCLUDE_LEN, end-begin-TMPL_INCLUDE_LEN );
+		content.trim();
+	
 	} else if ( strncmp(content.c_str(),TMPL_CURSOR,TMPL_CURSOR_LEN) == 0 ) {
 		// current loop cursor: %CURSOR
 		type = TMPL_S_CURSOR;
@@ -294,88 +940,32 @@ int Template::parse_script( const string &tmpl, const size_t pos,
 	return ( end-pos+TMPL_END_LEN );
 }
 
-/// ʽֵ
-/// \param exp ʽַ
-/// \return ֵΪñʽֵ,ʽǷ򷵻رʽַ
-string Template::exp_value( const string &exp ) {
-	if ( strncmp(exp.c_str(),TMPL_VALUE,TMPL_VALUE_LEN) == 0 ) {
-		// simple value: $xxx
-		string val = exp.substr( TMPL_VALUE_LEN );
-		return _sets[val];
-		
-	} else if ( strncmp(exp.c_str(),TMPL_LOOPVALUE,TMPL_LOOPVALUE_LEN) == 0 ) {
-		// current value in loop: .$xxx
-		string val = exp.substr( TMPL_LOOPVALUE_LEN );
-		return this->loop_value( val );
-		
-	} else if ( strncmp(exp.c_str(),TMPL_CURSOR,TMPL_CURSOR_LEN) == 0 ) {
-		// current loop cursor: %CURSOR
-		size_t pos = exp.find( TMPL_LOOPSCOPE );
-		if ( pos != exp.npos ) {
-			string loop_name = this->exp_value( exp.substr(pos+TMPL_LOOPSCOPE_LEN) );
-			int cursor = _loops[loop_name].cursor;
-			return itos(cursor+1);
-		} else {
-			return itos(_cursor+1);
-		}
-	
-	} else if ( strncmp(exp.c_str(),TMPL_ROWS,TMPL_ROWS_LEN) == 0 ) {
-		// current loop cursor: %ROWS
-		size_t pos = exp.find( TMPL_LOOPSCOPE );
-		if ( pos != exp.npos ) {
-			string loop_name = this->exp_value( exp.substr(pos+TMPL_LOOPSCOPE_LEN) );
-			return itos( _loops[loop_name].rows );
-		} else {
-			return itos( _loops[_loop].rows );
-		}
-
-	} else if ( strcmp(exp.c_str(),TMPL_DATE) == 0 ) {
-		// date: %DATE
-		return _date;
-	
-	} else if ( strcmp(exp.c_str(),TMPL_TIME) == 0 ) {
-		// time: %TIME
-		return _time;
-	
-	} else if ( strcmp(exp.c_str(),TMPL_SPACE) == 0 ) {
-		// space char: %SPACE
-		return " ";
-	
-	} else if ( strcmp(exp.c_str(),TMPL_BLANK) == 0 ) {
-		// blank string: %BLANK
-		return "";
-	
-	} else  {
-		// string
-		return exp;
-	}
-}
-
-/// ģ
-/// \param tmpl ģַ
-/// \param output 
-void Template::parse( const string &tmpl, ostream &output ) {
-	// init datetime
-	struct tm stm;
-	time_t tt = time( 0 );
-	localtime_r( &tt, &stm );
-	snprintf( _date, 15, "%d-%d-%d", stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday );
-	snprintf( _time, 15, "%d:%d:%d", stm.tm_hour, stm.tm_min, stm.tm_sec );
-
-	// confirm if inited
-	if ( _tmpl == "" ) {
-		this->error_log( 0, "Error: Templet not initialized" );
-		return;
-	}
-	
-	// parse init
-	_loop = "";
-	_cursor = 0;
-	_lines = 0;
-	
+/// 编译模板
+/// 将模板内容转换为指令列表,静态文本只纪录位置及长度,
+/// 条件及循环语句转换为跳转指令:
+/// - TMPL_S_IF,TMPL_S_ELSIF 的 jump 为条件不成立时下一个分支指令位置
+/// - TMPL_S_ELSIF,TMPL_S_ELSE 的 end 为分支结束时跳转的 TMPL_S_ENDIF 位置
+/// - TMPL_S_LOOP 的 jump 为对应 TMPL_S_ENDLOOP 位置
+/// - TMPL_S_ENDLOOP 的 jump 为对应 TMPL_S_LOOP 位置,缺少 TMPL_ENDLOOP 时为-1,不循环
+/// - TMPL_S_CACHE 的 jump 为对应 TMPL_S_ENDCACHE 位置,命中片段缓存时跳过整个块
+/// - TMPL_S_INCLUDE 的 include 为包含模板位置,包含模板从模板缓存读取,
+///   编译结果由包含同一文件的全部模板共享
+/// 语法错误在编译时纪录,每次分析时加入分析错误纪录
+/// \param program 编译结果,program.tmpl 为模板内容
+/// \param depth 包含模板嵌套层数,本模板为其它模板的包含模板时大于0
+void Template::compile( tmpl_program &program, const int depth ) {
+	program.codes.clear();
+	program.conds.clear();
+	program.frags.clear();
+	program.errlog.clear();
+
+	const string &tmpl = program.tmpl;
+	vector<int> blocks;	// open #IF/#FOR, last branch code position
 	size_t lastpos = 0;
 	size_t currpos = 0;
-
+	size_t linepos = 0;
+	int line = 0;
+	
 	// for parse_script()
 	string exp;
 	int type;
@@ -383,27 +973,54 @@ void Template::parse( const string &tmpl, ostream &output ) {
 	
 	// search TMPL_BEGIN in tmpl
 	while( (currpos=tmpl.find(TMPL_BEGIN,lastpos)) != tmpl.npos ) {
-		// output html before TMPL_BEGIN
-		output << tmpl.substr( lastpos, currpos-lastpos );
+		// html before TMPL_BEGIN
+		add_text( program, lastpos, currpos-lastpos, line );
 		
-		// log current position
-		if ( _debug == TMPL_OUTPUT_DEBUG ) {
-			String orightml = tmpl.substr( lastpos, currpos-lastpos );
-			_lines += orightml.count( TMPL_NEWLINE );
-		}
+		// current line
+		line += count( tmpl.begin()+linepos, tmpl.begin()+currpos, TMPL_NEWLINE[0] );
+		linepos = currpos;
 		
 		// get script content between TMPL_BEGIN and TMPL_END
-		parsed = this->parse_script( tmpl, currpos, exp, type );
+		parsed = parse_script( tmpl, currpos, exp, type );
 		
 		if ( parsed < 0 ) {
 			// can't find TMPL_END
 			lastpos = currpos;
-			this->error_log( _lines, "Error: Can't find TMPL_END" );
+			program.errlog.insert( multimap<int,string>::value_type(line,"Error: Can't find TMPL_END") );
 			break;
 		}
+
+		// current block
+		int block = TMPL_S_UNKNOWN;
+		const char *where = "parse()";
+		if ( !blocks.empty() ) {
+			if ( program.codes[blocks.back()].type == TMPL_S_LOOP ) {
+				block = TMPL_S_LOOP;
+				where = "parse_loop()";
+			} else if ( program.codes[blocks.back()].type == TMPL_S_CACHE ) {
+				block = TMPL_S_CACHE;
+				where = "parse_cache()";
+			} else {
+				block = TMPL_S_IF;
+				where = "parse_if()";
+			}
+		}
 		
-		// parse by script type
+		// compile by script type
+		string error;
+		int pc;
 		switch ( type ) {
+			case TMPL_S_LOOPVALUE:
+				// loop value
+			case TMPL_S_CURSOR:
+				// loop cursor
+			case TMPL_S_ROWS:
+				// loop rows, included template may be included in loop
+				if ( block==TMPL_S_UNKNOWN && depth==0 ) {
+					error = string( "Error: Unexpected script, in " ) + where;
+					break;
+				}
+				// fall through
 			case TMPL_S_VALUE:
 				// replace
 			case TMPL_S_DATE:
@@ -412,576 +1029,1030 @@ void Template::parse( const string &tmpl, ostream &output ) {
 				// replace with time
 			case TMPL_S_SPACE:
 				// replace with space char
-			case TMPL_S_BLANK:
+			case TMPL_S_BLANK: {
 				// replace with blank string
-				output << this->exp_value( exp );
+				int escape = -1;
+				if ( type==TMPL_S_VALUE || type==TMPL_S_LOOPVALUE ) {
+					// output escape mode: $xxx|html
+					escape = compile_escape( exp, error );
+					if ( error != "" )
+						error += string( ", in " ) + where;
+				}
+				pc = add_code( program, type, line );
+				compile_exp( program, exp, program.codes[pc].exp );
+				program.codes[pc].escape = escape;
+				}
 				break;
 
 			case TMPL_S_IF:
-				// condition replace
-				parsed = this->parse_if( tmpl.substr(currpos), output, true, exp, parsed );
+				// condition begin
+				pc = add_code( program, type, line );
+				program.codes[pc].cond = compile_cond( program, exp );
+				program.codes[pc].script = exp;
+				blocks.push_back( pc );
+				break;
+
+			case TMPL_S_ELSIF:
+				// condition branch
+			case TMPL_S_ELSE:
+				// default branch
+				if ( block != TMPL_S_IF ) {
+					error = string( "Error: Unexpected script, in " ) + where;
+					break;
+				}
+				pc = add_code( program, type, line );
+				if ( type == TMPL_S_ELSIF )
+					program.codes[pc].cond = compile_cond( program, exp );
+				program.codes[blocks.back()].jump = pc;
+				blocks.back() = pc;
+				break;
+
+			case TMPL_S_ENDIF:
+				// condition end
+				if ( block != TMPL_S_IF ) {
+					error = string( "Error: Unexpected script, in " ) + where;
+					break;
+				}
+				pc = add_code( program, type, line );
+				program.codes[blocks.back()].jump = pc;
+				blocks.pop_back();
 				break;
-				
+
 			case TMPL_S_LOOP:
-				// cycle replace
-				parsed = this->parse_loop( tmpl.substr(currpos), output, true, exp, parsed );
-				// restore loop status
-				_loop = "";
-				_cursor = 0;
+				// cycle begin
+				pc = add_code( program, type, line );
+				compile_exp( program, exp, program.codes[pc].exp );
+				program.codes[pc].script = exp;
+				blocks.push_back( pc );
+				break;
+
+			case TMPL_S_ENDLOOP:
+				// cycle end
+				if ( block != TMPL_S_LOOP ) {
+					error = string( "Error: Unexpected script, in " ) + where;
+					break;
+				}
+				pc = add_code( program, type, line );
+				program.codes[pc].jump = blocks.back();
+				program.codes[blocks.back()].jump = pc;
+				blocks.pop_back();
+				break;
+
+			case TMPL_S_CACHE:
+				// fragment cache begin
+				pc = add_code( program, type, line );
+				program.codes[pc].frag = compile_frag( program, exp );
+				program.codes[pc].script = exp;
+				if ( program.frags[program.codes[pc].frag].key.empty() )
+					error = string( "Warning: Empty cache key, in " ) + where;
+				blocks.push_back( pc );
+				break;
+
+			case TMPL_S_ENDCACHE:
+				// fragment cache end
+				if ( block != TMPL_S_CACHE ) {
+					error = string( "Error: Unexpected script, in " ) + where;
+					break;
+				}
+				pc = add_code( program, type, line );
+				program.codes[pc].jump = blocks.back();
+				program.codes[blocks.back()].jump = pc;
+				blocks.pop_back();
+				break;
+
+			case TMPL_S_INCLUDE: {
+				// include template file
+				int include = compile_include( program, exp, depth, error );
+				if ( include >= 0 ) {
+					pc = add_code( program, type, line );
+					program.codes[pc].include = include;
+					program.codes[pc].script = exp;
+				}
+				if ( error != "" )
+					error += string( ", in " ) + where;
+				}
 				break;
 
 			case TMPL_S_UNKNOWN:
 				// unknown script, maybe html code
-				this->error_log( _lines, "Warning: Unknown script, in parse()" );
-				
+				error = string( "Warning: Unknown script, in " ) + where;
+
 				// for syntax error
 				size_t backlen;
 				if ( (backlen=exp.find(TMPL_BEGIN)) != exp.npos )
 					parsed = backlen+TMPL_BEGIN_LEN;
-					
-				output << tmpl.substr( currpos, parsed );
+
+				add_text( program, currpos, parsed, line );
 				break;
-				
-			default:
-				// syntax error
-				this->error_log( _lines, "Error: Unexpected script, in parse()" );
 		}
-
+		
+		if ( error != "" )
+			program.errlog.insert( multimap<int,string>::value_type(line,error) );
+	
 		// location to next position
 		lastpos = currpos + parsed;
 	}
-	
-	// output tail html
-	output << tmpl.substr( lastpos );
+
+	// tail html
+	add_text( program, lastpos, tmpl.size()-lastpos, line );
+
+	// close unterminated blocks, innermost first
+	while ( !blocks.empty() ) {
+		int pc;
+		if ( program.codes[blocks.back()].type == TMPL_S_LOOP ) {
+			program.errlog.insert( multimap<int,string>::value_type(line,"Error: Can't find TMPL_ENDLOOP") );
+			pc = add_code( program, TMPL_S_ENDLOOP, line );
+			program.codes[blocks.back()].jump = pc;
+		} else if ( program.codes[blocks.back()].type == TMPL_S_CACHE ) {
+			program.errlog.insert( multimap<int,string>::value_type(line,"Error: Can't find TMPL_ENDCACHE") );
+			pc = add_code( program, TMPL_S_ENDCACHE, line );
+			program.codes[pc].jump = blocks.back();
+			program.codes[blocks.back()].jump = pc;
+		} else {
+			program.errlog.insert( multimap<int,string>::value_type(line,"Error: Can't find TMPL_ENDIF") );
+			pc = add_code( program, TMPL_S_ENDIF, line );
+			program.codes[blocks.back()].jump = pc;
+		}
+		blocks.pop_back();
+	}
+
+	// branch end position
+	for ( size_t i=program.codes.size(); i>0; --i ) {
+		tmpl_code &code = program.codes[i-1];
+		if ( code.type == TMPL_S_ENDIF )
+			code.end = i-1;
+		else if ( code.type==TMPL_S_IF || code.type==TMPL_S_ELSIF || code.type==TMPL_S_ELSE )
+			code.end = program.codes[code.jump].end;
+	}
+
+	// field position cache, included templates after own codes
+	program.cols = program.codes.size();
+	for ( size_t i=0; i<program.includes.size(); ++i ) {
+		program.includes[i].colbase = program.cols;
+		program.cols += program.includes[i].program->cols;
+	}
+
+	// memory size, included templates are shared and not counted
+	program.bytes = sizeof(tmpl_program) + program.tmpl.capacity() +
+		program.codes.capacity()*sizeof(tmpl_code) + program.conds.capacity()*sizeof(tmpl_cond) +
+		program.frags.capacity()*sizeof(tmpl_frag);
+	for ( size_t i=0; i<program.conds.size(); ++i )
+		program.bytes += program.conds[i].cmps.capacity()*sizeof(tmpl_cmp);
 }
 
-/// ʽǷ
-/// \param exp Ϊʽ,
-/// ʽΪַ,ֵΪ""ҲΪ"0"ʱtrue,򷵻false,
-/// ΪȽϱʽ,true,򷵻false
-/// \retval true ʽ
-/// \retval false ʽ
-bool Template::compare( const string &exp ) {
-	// read compare type
-	// supported: ==,!=,<=,<,>=,>
-	string cmpop;
-	size_t oppos;
-	tmpl_cmptype optype;
-	
-	if ( (oppos=exp.find(TMPL_EQ)) != exp.npos ) {
-		// ==
-		cmpop = TMPL_EQ;
-		optype = TMPL_C_EQ;
+/// 添加模板指令
+/// \param program 编译结果
+/// \param type 指令类型
+/// \param line 所在模板行数
+/// \return 指令位置
+int Template::add_code( tmpl_program &program, const int type, const int line ) {
+	tmpl_code code;
+	code.type = type;
+	code.pos = 0;
+	code.len = 0;
+	code.line = line;
+	code.jump = -1;
+	code.end = -1;
+	code.cond = -1;
+	code.frag = -1;
+	code.include = -1;
+	code.escape = -1;
+	code.exp.type = TMPL_S_UNKNOWN;
+	code.exp.slot = -1;
+	code.exp.scope = -1;
+	program.codes.push_back( code );
+	return program.codes.size()-1;
+}
+
+/// 添加静态文本指令
+/// 与前一个静态文本指令相连时合并
+/// \param program 编译结果
+/// \param pos 静态文本在模板中的位置
+/// \param len 静态文本长度
+/// \param line 所在模板行数
+void Template::add_text( tmpl_program &program, const size_t pos, 
+	const size_t len, const int line ) 
+{
+	if ( len == 0 )
+		return;
+	if ( !program.codes.empty() ) {
+		tmpl_code &last = program.codes.back();
+		if ( last.type==TMPL_S_TEXT && last.pos+last.len==pos ) {
+			last.len += len;
+			return;
+		}
+	}
+	int pc = add_code( program, TMPL_S_TEXT, line );
+	program.codes[pc].pos = pos;
+	program.codes[pc].len = len;
+}
+
+/// 编译表达式
+/// 模板域名称在编译时转换为模板域位置
+/// \param program 编译结果
+/// \param exp 表达式字符串
+/// \param result 编译结果
+void Template::compile_exp( tmpl_program &program, const string &exp, tmpl_exp &result ) {
+	result.slot = -1;
+	result.scope = -1;
+
+	if ( strncmp(exp.c_str(),TMPL_VALUE,TMPL_VALUE_LEN) == 0 ) {
+		// simple value: $xxx
+		result.type = TMPL_S_VALUE;
+		result.name = exp.substr( TMPL_VALUE_LEN );
+		result.slot = add_slot( program, result.name );
+		
+	} else if ( strncmp(exp.c_str(),TMPL_LOOPVALUE,TMPL_LOOPVALUE_LEN) == 0 ) {
+		// current value in loop: .$xxx or .$xxx@loop
+		result.type = TMPL_S_LOOPVALUE;
+		result.name = exp.substr( TMPL_LOOPVALUE_LEN );
+		size_t pos = result.name.find( TMPL_LOOPSCOPE );
+		if ( pos != result.name.npos ) {
+			result.scope = compile_scope( program, result.name.substr(pos+TMPL_LOOPSCOPE_LEN) );
+			result.name.erase( pos );
+		}
+		
+	} else if ( strncmp(exp.c_str(),TMPL_CURSOR,TMPL_CURSOR_LEN) == 0 ) {
+		// current loop cursor: %CURSOR or %CURSOR@loop
+		result.type = TMPL_S_CURSOR;
+		size_t pos = exp.find( TMPL_LOOPSCOPE );
+		if ( pos != exp.npos )
+			result.scope = compile_scope( program, exp.substr(pos+TMPL_LOOPSCOPE_LEN) );
 	
-	} else if ( (oppos=exp.find(TMPL_NE)) != exp.npos ) {
-		// !=
-		cmpop = TMPL_NE;
-		optype = TMPL_C_NE;
+	} else if ( strncmp(exp.c_str(),TMPL_ROWS,TMPL_ROWS_LEN) == 0 ) {
+		// current loop rows: %ROWS or %ROWS@loop
+		result.type = TMPL_S_ROWS;
+		size_t pos = exp.find( TMPL_LOOPSCOPE );
+		if ( pos != exp.npos )
+			result.scope = compile_scope( program, exp.substr(pos+TMPL_LOOPSCOPE_LEN) );
 	
-	} else if ( (oppos=exp.find(TMPL_LE)) != exp.npos ) {
-		// <=
-		cmpop = TMPL_LE;
-		optype = TMPL_C_LE;
+	} else if ( strcmp(exp.c_str(),TMPL_DATE) == 0 ) {
+		// date: %DATE
+		result.type = TMPL_S_DATE;
 	
-	} else if ( (oppos=exp.find(TMPL_LT)) != exp.npos ) {
-		// <
-		cmpop = TMPL_LT;
-		optype = TMPL_C_LT;
+	} else if ( strcmp(exp.c_str(),TMPL_TIME) == 0 ) {
+		// time: %TIME
+		result.type = TMPL_S_TIME;
 	
-	} else if ( (oppos=exp.find(TMPL_GE)) != exp.npos ) {
-		// >=
-		cmpop = TMPL_GE;
-		optype = TMPL_C_GE;
+	} else if ( strcmp(exp.c_str(),TMPL_SPACE) == 0 ) {
+		// space char: %SPACE
+		result.type = TMPL_S_SPACE;
+		result.name = " ";
 	
-	} else if ( (oppos=exp.find(TMPL_GT)) != exp.npos ) {
-		// >
-		cmpop = TMPL_GT;
-		optype = TMPL_C_GT;
+	} else if ( strcmp(exp.c_str(),TMPL_BLANK) == 0 ) {
+		// blank string: %BLANK
+		result.type = TMPL_S_BLANK;
 	
-	} else {
-		// read value, compare and return
-		string val = this->exp_value( exp );
-		if ( val!="" && val!="0" )
-			return true;
-		else
-			return false;
+	} else  {
+		// string
+		result.type = TMPL_S_UNKNOWN;
+		result.name = exp;
 	}
+}
 
-	// split exp by compare operator
-	String lexp = exp.substr( 0, oppos );
-	String rexp = exp.substr( oppos+cmpop.length() );
-	
-	// read value
-	lexp.trim(); rexp.trim();
-	lexp = this->exp_value( lexp );
-	rexp = this->exp_value( rexp );
+/// 编译片段缓存定义
+/// 缓存键中的 $xxx 在输出时替换为模板域值,模板域名称由字母,数字及下划线组成
+/// \param program 编译结果
+/// \param exp 片段缓存定义字符串,"缓存键 缓存时间"格式,缓存时间省略时为 TMPL_FRAGMENT_TTL
+/// \return 编译结果在片段缓存定义列表中的位置
+int Template::compile_frag( tmpl_program &program, const string &exp ) {
+	tmpl_frag frag;
+	frag.ttl = TMPL_FRAGMENT_TTL;
+
+	// split key and ttl
+	size_t split = exp.find_first_of( " \t\r\n" );
+	string key = exp.substr( 0, split );
+	if ( split != exp.npos ) {
+		String ttl = exp.substr( split );
+		ttl.trim();
+		if ( ttl.isnum() )
+			frag.ttl = atoi( ttl.c_str() );
+	}
 
-	// compare
-	int cmp;
-	if ( lexp.isnum() && rexp.isnum() ) {
-		int lv = atoi( lexp.c_str() );
-		int rv = atoi( rexp.c_str() );
-		cmp = ( lv>rv ) ? 1 : ( lv==rv ) ? 0 : -1;
-	} else {
-		cmp = strcmp( lexp.c_str(), rexp.c_str() );
+	// key parts, text or $xxx
+	size_t pos = 0;
+	while ( pos < key.length() ) {
+		size_t var = key.find( TMPL_VALUE, pos );
+		size_t end = ( var!=key.npos ) ? var+TMPL_VALUE_LEN : key.length();
+		while ( end<key.length() && (isalnum(key[end]) || key[end]=='_') )
+			++end;
+
+		tmpl_exp part;
+		if ( var==key.npos || end==var+TMPL_VALUE_LEN ) {
+			// text
+			compile_exp( program, "", part );
+			part.name = key.substr( pos, end-pos );
+		} else {
+			if ( var > pos ) {
+				compile_exp( program, "", part );
+				part.name = key.substr( pos, var-pos );
+				frag.key.push_back( part );
+			}
+			compile_exp( program, key.substr(var,end-var), part );
+		}
+		frag.key.push_back( part );
+		pos = end;
 	}
 
-	// return
-	switch ( optype ) {
-		case TMPL_C_EQ:
-			return ( cmp==0 ) ? true : false;
-		case TMPL_C_NE:
-			return ( cmp!=0 ) ? true : false;
-		case TMPL_C_LE:
-			return ( cmp<=0 ) ? true : false;
-		case TMPL_C_LT:
-			return ( cmp<0 ) ? true : false;
-		case TMPL_C_GE:
-			return ( cmp>=0 ) ? true : false;
-		case TMPL_C_GT:
-			return ( cmp>0 ) ? true : false;
-		default:
-			return false;
+	program.frags.push_back( frag );
+	return program.frags.size()-1;
+}
+
+/// 编译包含模板
+/// 包含模板从模板缓存读取,文件名为相对路径时相对于本模板所在目录,
+/// 包含模板的模板域加入本模板,分析时使用本模板的替换值及循环
+/// \param program 编译结果
+/// \param exp 包含模板文件名
+/// \param depth 本模板的包含模板嵌套层数
+/// \param error 错误描述
+/// \return 包含模板在包含模板列表中的位置,读取失败返回-1
+int Template::compile_include( tmpl_program &program, const string &exp, 
+	const int depth, string &error ) 
+{
+	// file name, quoted or not
+	string file = exp;
+	if ( file.length()>=2 && (file[0]=='"'||file[0]=='\'') && file[file.length()-1]==file[0] )
+		file = file.substr( 1, file.length()-2 );
+	if ( file == "" ) {
+		error = "Error: Empty include file name";
+		return -1;
 	}
+	if ( file[0] != '/' ) {
+		size_t dir = program.file.rfind( '/' );
+		if ( dir != program.file.npos )
+			file = program.file.substr( 0, dir+1 ) + file;
+	}
+
+	// recursive include
+	if ( depth >= TMPL_INCLUDE_DEPTH ) {
+		error = "Error: Include nested too deep " + file;
+		return -1;
+	}
+
+	tmpl_include include;
+	include.program = Template::cache_load( file, depth+1 );
+	if ( include.program == NULL ) {
+		error = "Error: Can't open include file " + file;
+		return -1;
+	}
+	include.colbase = 0;
+
+	// values of included template
+	const strings &names = include.program->names;
+	include.slots.resize( names.size() );
+	for ( size_t i=0; i<names.size(); ++i )
+		include.slots[i] = add_slot( program, names[i] );
+
+	// syntax errors of included template
+	const multimap<int,string> &errlog = include.program->errlog;
+	for ( multimap<int,string>::const_iterator i=errlog.begin(); i!=errlog.end(); ++i )
+		program.errlog.insert( multimap<int,string>::value_type(i->first,
+			i->second + ", in " + file) );
+
+	program.includes.push_back( include );
+	return program.includes.size()-1;
+}
+
+/// 编译输出转义方式
+/// 转义方式为 none,html,attr,url,js 之一,写在表达式之后,以 TMPL_ESCAPE 分隔
+/// \param exp 表达式字符串,返回时去除转义方式
+/// \param error 错误描述
+/// \return 转义方式 escape_mode,未指定或不能识别时返回-1
+int Template::compile_escape( string &exp, string &error ) {
+	size_t pos = exp.rfind( TMPL_ESCAPE );
+	if ( pos == exp.npos )
+		return -1;
+	String mode = exp.substr( pos+TMPL_ESCAPE_LEN );
+	mode.trim();
+	String name = exp.substr( 0, pos );
+	name.trim();
+	exp = name;
+
+	const char *modes[] = { "none", "html", "attr", "url", "js", NULL };
+	for ( int i=0; modes[i]!=NULL; ++i ) {
+		if ( mode == modes[i] )
+			return i;
+	}
+	error = "Warning: Unknown escape mode \"" + mode + "\"";
+	return -1;
 }
 
-/// Ƿ	
-/// \param exp Ϊʽ
-/// \retval true ʽ
-/// \retval false ʽ
-bool Template::check_if( const string &exp ) {
-	tmpl_logictype exp_type = TMPL_L_NONE;
+/// 编译循环名称表达式
+/// \param program 编译结果
+/// \param exp 循环名称表达式字符串
+/// \return 编译结果在循环名称表达式列表中的位置
+int Template::compile_scope( tmpl_program &program, const string &exp ) {
+	tmpl_exp scope;
+	compile_exp( program, exp, scope );
+	program.scopes.push_back( scope );
+	return program.scopes.size()-1;
+}
+
+/// 添加模板域
+/// \param program 编译结果
+/// \param name 模板域名称
+/// \return 模板域位置
+int Template::add_slot( tmpl_program &program, const string &name ) {
+	map<string,int>::const_iterator i = program.slots.find( name );
+	if ( i != program.slots.end() )
+		return i->second;
+	program.names.push_back( name );
+	return ( program.slots[name] = program.names.size()-1 );
+}
+
+/// 编译比较表达式
+/// 支持的比较运算符依次为 ==,!=,<=,<,>=,>,
+/// 无比较运算符时为检查表达式的值
+/// \param program 编译结果
+/// \param exp 比较表达式字符串
+/// \param result 编译结果
+void Template::compile_cmp( tmpl_program &program, const string &exp, tmpl_cmp &result ) {
+	// read compare type
+	static const char *cmpops[] = { TMPL_EQ, TMPL_NE, TMPL_LE, TMPL_LT, TMPL_GE, TMPL_GT };
+	size_t oppos = exp.npos;
+	int optype;
+	for ( optype=TMPL_C_EQ; optype<TMPL_C_NONE; ++optype ) {
+		if ( (oppos=exp.find(cmpops[optype])) != exp.npos )
+			break;
+	}
+
+	result.op = optype;
+	if ( optype == TMPL_C_NONE ) {
+		compile_exp( program, exp, result.lexp );
+		return;
+	}
+
+	// split exp by compare operator
+	String lexp = exp.substr( 0, oppos );
+	String rexp = exp.substr( oppos+strlen(cmpops[optype]) );
+	lexp.trim(); rexp.trim();
+	compile_exp( program, lexp, result.lexp );
+	compile_exp( program, rexp, result.rexp );
+}
+
+/// 编译条件表达式
+/// \param program 编译结果
+/// \param exp 条件表达式及其组合
+/// \return 编译结果在条件表达式列表中的位置
+int Template::compile_cond( tmpl_program &program, const string &exp ) {
+	tmpl_cond cond;
+	cond.logic = TMPL_L_NONE;
+	cond.warning = false;
 	String exps;
 
 	// check expression type
 	if ( strncmp(exp.c_str(),TMPL_AND,TMPL_AND_LEN) == 0 ) {
-		exp_type = TMPL_L_AND;
+		cond.logic = TMPL_L_AND;
 		exps = exp.substr( TMPL_AND_LEN );
 	} else if ( strncmp(exp.c_str(),TMPL_OR,TMPL_OR_LEN) == 0 ) {
-		exp_type = TMPL_L_OR;
+		cond.logic = TMPL_L_OR;
 		exps = exp.substr( TMPL_OR_LEN );
 	}
 
-	// none logic expression
-	if ( exp_type == TMPL_L_NONE )
-		return this->compare( exp );
-
 	// check TMPL_SUBBEGIN/TMPL_SUBEND
-	exps.trim();
-	size_t explen = exps.length();
-	if ( exps.substr(0,TMPL_SUBBEGIN_LEN)!=TMPL_SUBBEGIN ||
-		 exps.substr(explen-TMPL_SUBEND_LEN)!=TMPL_SUBEND ) {
-		this->error_log( _lines, "Warning: Maybe wrong TMPL_AND or TMPL_OR script" );
-		return this->compare( exp );
+	if ( cond.logic != TMPL_L_NONE ) {
+		exps.trim();
+		size_t explen = exps.length();
+		if ( exps.substr(0,TMPL_SUBBEGIN_LEN)!=TMPL_SUBBEGIN ||
+			 exps.substr(explen-TMPL_SUBEND_LEN)!=TMPL_SUBEND ) {
+			cond.logic = TMPL_L_NONE;
+			cond.warning = true;
+		}
 	}
-		
-	// split expressions list
-	exps = exps.substr( TMPL_SUBBEGIN_LEN, explen-TMPL_SUBBEGIN_LEN-TMPL_SUBEND_LEN );
-	vector<String> explist = exps.split( TMPL_SPLIT );
 
-	// judge
-	if ( exp_type == TMPL_L_AND ) {
-		// TMPL_AND
-		for ( size_t i=0; i<explist.size(); i++ ) {
-			explist[i].trim();
-			if ( !this->compare(explist[i]) )
-				return false;
-		}
-		return true;
-		
+	if ( cond.logic == TMPL_L_NONE ) {
+		// none logic expression
+		cond.cmps.resize( 1 );
+		compile_cmp( program, exp, cond.cmps[0] );
 	} else {
-		// TMPL_OR
-		for ( size_t i=0; i<explist.size(); i++ ) {
+		// split expressions list
+		exps = exps.substr( TMPL_SUBBEGIN_LEN, exps.length()-TMPL_SUBBEGIN_LEN-TMPL_SUBEND_LEN );
+		vector<String> explist = exps.split( TMPL_SPLIT );
+		cond.cmps.resize( explist.size() );
+		for ( size_t i=0; i<explist.size(); ++i ) {
 			explist[i].trim();
-			if ( this->compare(explist[i]) )
-				return true;
+			compile_cmp( program, explist[i], cond.cmps[i] );
 		}
-		return false;
+	}
+
+	program.conds.push_back( cond );
+	return program.conds.size()-1;
+}
+
+/// 分析已编译表达式的值
+/// \param exp 已编译表达式
+/// \return 返回值为该表达式的值,若表达式非法则返回表达式字符串
+string Template::exp_value( const tmpl_exp &exp ) {
+	switch ( exp.type ) {
+		case TMPL_S_VALUE:
+			// simple value: $xxx
+			return this->slot_value( exp.slot );
+
+		case TMPL_S_LOOPVALUE: {
+			// current value in loop: .$xxx
+			const char *data;
+			size_t length;
+			if ( this->loop_cell(exp,-1,data,length) )
+				return string( data, length );
+			return "";
+			}
+
+		case TMPL_S_CURSOR:
+			// current loop cursor: %CURSOR
+			if ( exp.scope >= 0 ) {
+				const tmpl_loop *loop = this->scope_loop( exp );
+				return itos( (loop!=NULL) ? loop->cursor+1 : 1 );
+			}
+			return itos( _cursor+1 );
+
+		case TMPL_S_ROWS: {
+			// current loop rows: %ROWS
+			return itos( this->loop_rows(this->scope_loop(exp)) );
+			}
+
+		case TMPL_S_DATE:
+			// date: %DATE
+			return _date;
+
+		case TMPL_S_TIME:
+			// time: %TIME
+			return _time;
+
+		case TMPL_S_BLANK:
+			// blank string: %BLANK
+			return "";
+
+		default:
+			// string or space char
+			return exp.name;
+	}
+}
+
+/// 执行模板指令
+/// \param output 分析处理结果输出流
+void Template::parse( ostream &output ) {
+	// init datetime
+	struct tm stm;
+	time_t tt = time( 0 );
+	localtime_r( &tt, &stm );
+	snprintf( _date, 15, "%d-%d-%d", stm.tm_year+1900, stm.tm_mon+1, stm.tm_mday );
+	snprintf( _time, 15, "%d:%d:%d", stm.tm_hour, stm.tm_min, stm.tm_sec );
+
+	// confirm if inited
+	if ( _program==NULL || _program->tmpl=="" ) {
+		this->error_log( 0, "Error: Templet not initialized" );
+		return;
 	}
 	
-	return false; // for warning
-}
-
-/// ģ
-/// \param tmpl ģַ
-/// \param output 
-/// \param parent_state øúʱ״̬
-/// \param parsed_exp ѷűʽ
-/// \param parsed_length ѷűʽ
-/// \return ֵΪηַ
-size_t Template::parse_if( const string &tmpl, ostream &output, 
-	const bool parent_state, const string &parsed_exp, const int parsed_length ) 
-{
-	// parsed length
-	size_t length = parsed_length;
-		
-	// check status
-	bool status;
-	bool effected;
-	if ( parent_state == false ) {
-		status = false;
-		effected = true;
-	} else if ( this->check_if(parsed_exp) ) {
-		status = true;
-		effected = true;
-	} else {
-		status = false;
-		effected = false;
+	// parse init
+	_errlog.insert( _program->errlog.begin(), _program->errlog.end() );
+	_curloop = NULL;
+	_cursor = 0;
+	_flushed = 0;
+	_exec = _program;
+	_slotmap = NULL;
+	_colbase = 0;
+	if ( !_profile ) {
+		this->execute( output );
+		return;
 	}
-		
-	// parse
-	size_t lastpos = parsed_length;
-	size_t currpos = parsed_length;
 
-	// for parse_script()
-	string exp;
-	int type;
-	int parsed;
+	// whole template statistics
+	vector<tmpl_block> blocks;
+	this->profile_open( blocks, -1, -1 );
+	this->execute( output );
+	this->profile_close( blocks, 0 );
+}
+
+/// 执行当前模板或包含模板的指令
+/// 执行 _exec 的指令,包含模板的循环、条件及片段缓存块在包含模板内结束,
+/// 包含模板的模板域按 _slotmap 转换为本模板的模板域位置
+/// \param output 分析处理结果输出流
+void Template::execute( ostream &output ) {
+	const vector<tmpl_code> &codes = _exec->codes;
+	const vector<tmpl_cond> &conds = _exec->conds;
+
+	// current output, {{#CACHE}} block output captured
+	ostream *out = &output;
+	vector<tmpl_capture*> captures;
+
+	// parent loop status
+	vector<tmpl_frame> parents;
+	const char *tmpl = _exec->tmpl.data();
+	int pc = 0;
+	int size = codes.size();
+
+	// blocks in profiling
+	vector<tmpl_block> blocks;
 	
-	while( (currpos=tmpl.find(TMPL_BEGIN,lastpos)) != tmpl.npos ) {
-		// output html before TMPL_BEGIN if status valid
-		if ( status )
-			output << tmpl.substr( lastpos, currpos-lastpos );
-		length += ( currpos-lastpos );
-		
-		// log current position
-		if ( _debug == TMPL_OUTPUT_DEBUG ) {
-			String orightml = tmpl.substr( lastpos, currpos-lastpos );
-			_lines += orightml.count( TMPL_NEWLINE );
-		}
-		
-		// get script content between TMPL_BEGIN and TMPL_END
-		parsed = this->parse_script( tmpl, currpos, exp, type );
-		
-		if ( parsed < 0 ) {
-			// can't find TMPL_END
-			this->error_log( _lines, "Error: Can't find TMPL_END" );
-			lastpos = currpos;
-			break;
-		}
-		
-		// parse by script type
-		switch ( type ) {
-			case TMPL_S_VALUE:
-				// replace if status is true
-			case TMPL_S_LOOPVALUE:
-				// replace with loop value if status is true
-			case TMPL_S_CURSOR:
-				// replace with cursor
-			case TMPL_S_ROWS:
-				// replace with rows
-			case TMPL_S_DATE:
-				// replace with date
-			case TMPL_S_TIME:
-				// replace with time
-			case TMPL_S_SPACE:
-				// replace with space char
-			case TMPL_S_BLANK:
-				// replace with blank string
-				if ( status )
-					output << this->exp_value( exp );
+	while ( pc < size ) {
+		if ( _profile && !blocks.empty() && pc>blocks.back().end )
+			this->profile_close( blocks, pc );
+
+		const tmpl_code &code = codes[pc];
+		switch ( code.type ) {
+			case TMPL_S_TEXT:
+				// static html
+				out->write( tmpl+code.pos, code.len );
+				_outbytes += code.len;
+				++pc;
 				break;
 
-			case TMPL_S_ELSIF:
-				// check and set status
-				if ( effected ) {
-					// something effected before
-					status = false;
-				} else if ( this->check_if(exp) ) {
-					// nothing effected and status is true now
-					status = true;
-					effected = true;
-				} else {
-					// nothing effected, status is false now
-					status = false;
-				}
+			case TMPL_S_IF:
+				// condition begin, go to the first true branch
+				if ( _profile )
+					this->profile_open( blocks, pc, code.end );
+				if ( this->check_if(conds[code.cond],code.line) )
+					++pc;
+				else
+					pc = this->check_branch( codes, code.jump );
 				break;
 
+			case TMPL_S_ELSIF:
+				// end of the true branch
 			case TMPL_S_ELSE:
-				// check and set status
-				if ( effected ) {
-					// something effected before
-					status = false;
-				} else {
-					// nothing effected, then status is true
-					status = true;
-					effected = true;
-				}
+				// end of the true branch
+				pc = code.end + 1;
 				break;
 
 			case TMPL_S_ENDIF:
-				// parsed length
-				length += parsed;
-				// exit function
-				return length;
-					
-			case TMPL_S_IF:
-				// sub condition replace
-				parsed = this->parse_if( tmpl.substr(currpos), output, status, exp, parsed );
+				// condition end
+				++pc;
 				break;
-				
-			case TMPL_S_LOOP: { // make compiler happy
+
+			case TMPL_S_LOOP: {
+				// cycle begin
+				if ( _profile )
+					this->profile_open( blocks, pc, code.jump );
+				tmpl_loop *loop = this->check_loop( code.script, this->exp_value(code.exp), code.line );
+				if ( loop == NULL ) {
+					pc = code.jump + 1;
+					break;
+				}
+
 				// backup current loop status
-				string parent_loop = _loop;
-				int parent_cursor = _cursor;
-				
-				// sub cycle replace
-				parsed = this->parse_loop( tmpl.substr(currpos), output, status, exp, parsed );
-				
+				tmpl_frame parent;
+				parent.loop = _curloop;
+				parent.cursor = _cursor;
+				parents.push_back( parent );
+				_curloop = loop;
+				_cursor = 0;
+				_curloop->cursor = 0;
+				++pc;
+				}
+				break;
+
+			case TMPL_S_ENDLOOP:
+				// at the end of this cycle
+				_curloop->cursor = ++_cursor;
+				if ( _response!=NULL && _flushrows>0 && ++_flushed>=_flushrows ) {
+					// send rows to client early
+					_response->flush();
+					_flushed = 0;
+				}
+				if ( code.jump>=0 && this->loop_fetch(_curloop,_cursor) ) {
+					// next cycle
+					pc = code.jump + 1;
+					break;
+				}
+
 				// restore loop status
-				_loop = parent_loop;
-				_cursor = parent_cursor;
-				_loops[_loop].cursor = _cursor;
+				if ( _profile && !blocks.empty() )
+					blocks.back().rows = _cursor;
+				_curloop = parents.back().loop;
+				_cursor = parents.back().cursor;
+				parents.pop_back();
+				if ( _curloop != NULL )
+					_curloop->cursor = _cursor;
+				++pc;
+				break;
+
+			case TMPL_S_LOOPVALUE: {
+				// replace with loop value
+				const char *data;
+				size_t length;
+				if ( this->loop_cell(code.exp,pc,data,length) )
+					_outbytes += this->write_value( *out, code.escape, data, length );
+				++pc;
 				}
 				break;
 
-			case TMPL_S_UNKNOWN:
-				// unknown script, maybe html code
-				this->error_log( _lines, "Warning: Unknown script, in parse_if()" );
+			case TMPL_S_VALUE: {
+				// replace
+				const string &value = this->slot_value( code.exp.slot );
+				_outbytes += this->write_value( *out, code.escape, value.data(), value.size() );
+				++pc;
+				}
+				break;
 
-				// for syntax error
-				size_t backlen;
-				if ( (backlen=exp.find(TMPL_BEGIN)) != exp.npos )
-					parsed = backlen+TMPL_BEGIN_LEN;
+			case TMPL_S_CACHE: {
+				// fragment cache begin
+				if ( _profile )
+					this->profile_open( blocks, pc, code.jump );
+				const tmpl_frag &frag = _exec->frags[code.frag];
+				string key;
+				for ( size_t i=0; i<frag.key.size(); ++i )
+					key += this->exp_value( frag.key[i] );
+
+				if ( this->fetch_fragment(key) ) {
+					// cached, skip the block
+					out->write( _fragment.data(), _fragment.size() );
+					_outbytes += _fragment.size();
+					pc = code.jump + 1;
+					break;
+				}
 
-				if ( status )
-					output << tmpl.substr( currpos, parsed );
+				// capture block output
+				tmpl_capture *capture = new tmpl_capture;
+				capture->output = out;
+				capture->key = key;
+				capture->ttl = frag.ttl;
+				captures.push_back( capture );
+				out = &capture->html;
+				++pc;
+				}
 				break;
 
-			default:
-				// syntax error
-				error_log( _lines, "Error: Unexpected script, in parse_if()" );
-		}
+			case TMPL_S_ENDCACHE:
+				// fragment cache end, store and output block
+				if ( !captures.empty() ) {
+					tmpl_capture *capture = captures.back();
+					captures.pop_back();
+					string html = capture->html.str();
+					Template::store_fragment( capture->key, html, capture->ttl );
+					out = capture->output;
+					out->write( html.data(), html.size() );
+					delete capture;
+				}
+				++pc;
+				break;
 
-		// parsed length
-		length += parsed;
-		// location to next position
-		lastpos = currpos + parsed;
+			case TMPL_S_INCLUDE: {
+				// run included template with own values and loops
+				if ( _profile )
+					this->profile_open( blocks, pc, pc );
+				const tmpl_include &include = _exec->includes[code.include];
+				const tmpl_program *exec = _exec;
+				const int *slotmap = _slotmap;
+				size_t colbase = _colbase;
+
+				// nested include, map values to top template
+				const vector<int> *remap = &include.slots;
+				vector<int> slots;
+				if ( _slotmap!=NULL && !include.slots.empty() ) {
+					slots.resize( include.slots.size() );
+					for ( size_t i=0; i<slots.size(); ++i )
+						slots[i] = _slotmap[include.slots[i]];
+					remap = &slots;
+				}
+
+				_exec = include.program;
+				_slotmap = remap->empty() ? NULL : &(*remap)[0];
+				_colbase += include.colbase;
+				this->execute( *out );
+				_exec = exec;
+				_slotmap = slotmap;
+				_colbase = colbase;
+				++pc;
+				}
+				break;
+
+			default: {
+				// loop value, cursor, rows, date, time, space, blank
+				string value = this->exp_value( code.exp );
+				out->write( value.data(), value.size() );
+				_outbytes += value.size();
+				++pc;
+				}
+		}
 	}
-	
-	// can not find TMPL_ENDIF
-	this->error_log( _lines, "Error: Can't find TMPL_ENDIF" );
 
-	// output tail html
-	if ( status )
-		output << tmpl.substr( lastpos );
-	length += ( tmpl.size()-lastpos );
-	
-	return length;
+	if ( _profile )
+		this->profile_close( blocks, size );
 }
 
-/// ѭǷЧ
-/// \param loop ѭѭ
-/// \retval true ѭѶ
-/// \retval false δ
-bool Template::check_loop( const string &loopname ) {
-	string loop = this->exp_value( loopname );
-	
-	if ( _loops.find(loop) != _loops.end() && _loops[loop].rows > 0 ) {
-		return true;
-	} else {
-		this->error_log( _lines, "Warning: loop " + loopname + " \""+loop+
-			"\" not defined or not set data" );
-		return false;
+/// 按转义方式输出模板域或循环字段的值
+/// \param output 输出流
+/// \param escape 模板中指定的转义方式,为-1时使用 set_escape() 设置的默认转义方式
+/// \param data 值
+/// \param length 值长度
+/// \return 输出长度
+size_t Template::write_value( ostream &output, const int escape, 
+	const char *data, const size_t length ) 
+{
+	escape_mode mode = ( escape>=0 ) ? static_cast<escape_mode>( escape ) : _escape;
+	if ( mode == ESCAPE_NONE ) {
+		output.write( data, length );
+		return length;
 	}
+	return escape_write( output, data, length, mode );
 }
 
-/// ѭָλֶεֵ
-/// \param fleid ѭֶ
-/// \return ȡɹֵַ,򷵻ؿַ
-string Template::loop_value( const string &field ) {
-	// get loop info
-	size_t pos = field.find( TMPL_LOOPSCOPE );
-	if ( pos != field.npos ) {
-		string loop_name = this->exp_value( field.substr(pos+TMPL_LOOPSCOPE_LEN) );
-		string field_name = field.substr( 0, pos );
-		int cursor = _loops[loop_name].cursor;
-
-		// return value
-		int col = this->field_pos( loop_name, field_name );
-		if ( col!=-1 && cursor<_loops[loop_name].rows )
-			return _loops[loop_name].datas[cursor][col];
+/// 检查比较表达式是否成立
+/// \param cmp 已编译比较表达式,
+/// 若为 TMPL_C_NONE,则值不为""并且不为"0"时返回true,否则返回false,
+/// 若为比较表达式,成立返回true,否则返回false
+/// \retval true 条件表达式成立
+/// \retval false 条件表达式不成立
+bool Template::compare( const tmpl_cmp &cmp ) {
+	if ( cmp.op == TMPL_C_NONE ) {
+		// read value, compare and return
+		string val = this->exp_value( cmp.lexp );
+		if ( val!="" && val!="0" )
+			return true;
 		else
-			return string( "" );
+			return false;
+	}
+
+	// read value
+	String lexp = this->exp_value( cmp.lexp );
+	String rexp = this->exp_value( cmp.rexp );
+
+	// compare
+	int result;
+	if ( lexp.isnum() && rexp.isnum() ) {
+		int lv = atoi( lexp.c_str() );
+		int rv = atoi( rexp.c_str() );
+		result = ( lv>rv ) ? 1 : ( lv==rv ) ? 0 : -1;
 	} else {
-		// return value
-		int col = this->field_pos( _loop, field );
-		if ( col!=-1 && _cursor<_loops[_loop].rows )
-			return _loops[_loop].datas[_cursor][col];
-		else
-			return string( "" );
+		result = strcmp( lexp.c_str(), rexp.c_str() );
+	}
+
+	// return
+	switch ( cmp.op ) {
+		case TMPL_C_EQ:
+			return ( result==0 ) ? true : false;
+		case TMPL_C_NE:
+			return ( result!=0 ) ? true : false;
+		case TMPL_C_LE:
+			return ( result<=0 ) ? true : false;
+		case TMPL_C_LT:
+			return ( result<0 ) ? true : false;
+		case TMPL_C_GE:
+			return ( result>=0 ) ? true : false;
+		case TMPL_C_GT:
+			return ( result>0 ) ? true : false;
+		default:
+			return false;
 	}
 }
 
-/// ѭģ
-/// \param tmpl ģַ
-/// \param output 
-/// \param parent_state øúʱ״̬
-/// \param parsed_exp ѷѭűʽ
-/// \param parsed_length ѷѭűʽ
-/// \return ֵΪηַ
-size_t Template::parse_loop( const string &tmpl, ostream &output, 
-	const bool parent_state, const string &parsed_exp, const int parsed_length ) 
-{
-	// parsed length
-	size_t length = parsed_length;
-		
-	// check status
-	bool status;
-	if ( parent_state == false )
-		status = false;
-	else if ( this->check_loop(parsed_exp) )
-		status = true;
-	else
-		status = false;
-		
-	// init
-	bool cycled = false;
-	int cursor = 0;
-	size_t start_pos = parsed_length;
-	size_t start_len = parsed_length;
-	size_t lastpos = parsed_length;
-	size_t currpos = parsed_length;
-	
-	// current loop name
-	string loop = this->exp_value( parsed_exp );
-	_loop = loop;
-	_loops[_loop].cursor = 0;
+/// 检查条件是否成立	
+/// \param cond 已编译条件表达式
+/// \param line 所在模板行数
+/// \retval true 条件表达式成立
+/// \retval false 条件表达式不成立
+bool Template::check_if( const tmpl_cond &cond, const int line ) {
+	if ( cond.warning )
+		this->error_log( line, "Warning: Maybe wrong TMPL_AND or TMPL_OR script" );
 
-	// for parse_script()		
-	string exp;
-	int type;
-	int parsed;
-
-	while( (currpos=tmpl.find(TMPL_BEGIN,lastpos)) != tmpl.npos ) {
-		// output html before TMPL_BEGIN if status valid
-		if ( status )
-			output << tmpl.substr( lastpos, currpos-lastpos );
-		length += ( currpos-lastpos );
-		
-		// log current position
-		if ( !cycled && _debug==TMPL_OUTPUT_DEBUG ) {
-			String orightml = tmpl.substr( lastpos, currpos-lastpos );
-			_lines += orightml.count( TMPL_NEWLINE );
+	// judge
+	if ( cond.logic == TMPL_L_AND ) {
+		// TMPL_AND
+		for ( size_t i=0; i<cond.cmps.size(); ++i ) {
+			if ( !this->compare(cond.cmps[i]) )
+				return false;
 		}
+		return true;
 		
-		// get script content between TMPL_BEGIN and TMPL_END
-		parsed = this->parse_script( tmpl, currpos, exp, type );
-		
-		if ( parsed < 0 ) {
-			// can't find TMPL_END
-			if ( !cycled )
-				this->error_log( _lines, "Error: Can't find TMPL_END" );
-			lastpos = currpos;
-			break;
+	} else if ( cond.logic == TMPL_L_OR ) {
+		// TMPL_OR
+		for ( size_t i=0; i<cond.cmps.size(); ++i ) {
+			if ( this->compare(cond.cmps[i]) )
+				return true;
 		}
-		
-		// current loop cursor
-		_cursor = cursor;
+		return false;
+	}
 
-		// parse by script type
-		switch ( type ) {
-			case TMPL_S_VALUE:
-				// replace
-			case TMPL_S_LOOPVALUE:
-				// replace with loop value in loop
-			case TMPL_S_CURSOR:
-				// replace with cursor
-			case TMPL_S_ROWS:
-				// replace with rows				
-			case TMPL_S_DATE:
-				// replace with date
-			case TMPL_S_TIME:
-				// replace with time
-			case TMPL_S_SPACE:
-				// replace with space char
-			case TMPL_S_BLANK:
-				// replace with blank string
-				if ( status )           
-					output << this->exp_value( exp );
-				break;
+	// none logic expression
+	return this->compare( cond.cmps[0] );
+}
 
-			case TMPL_S_ENDLOOP:
-				// at the end of this cycle
-				++cursor; // data cursor
-				_loops[_loop].cursor = cursor;
-				if ( status && cursor<_loops[loop].rows ) {
-					// next cycle
-					length = start_len;		// reset parsed length
-					lastpos = start_pos;	// reset start position
-					cycled = true;			// do not add current position value
-					continue;
-				} else {
-					// parsed length
-					length += parsed;
-					// exit function
-					return length;
-				}
-					
-			case TMPL_S_IF:
-				// sub condition replace
-				parsed = this->parse_if( tmpl.substr(currpos), output, status, exp, parsed );
-				break;
-				
-			case TMPL_S_LOOP:
-				// sub cycle replace
-				parsed = this->parse_loop( tmpl.substr(currpos), output, status, exp, parsed );
-				// restore loop status
-				_loop = loop;
-				_cursor = cursor;
-				_loops[_loop].cursor = _cursor;
-				break;
+/// 查找成立的条件分支
+/// \param codes 模板指令列表
+/// \param pc 条件不成立时跳转的分支指令位置
+/// \return 成立的分支内第一条指令位置,均不成立时为 TMPL_S_ENDIF 之后的指令位置
+int Template::check_branch( const vector<tmpl_code> &codes, int pc ) {
+	while ( codes[pc].type == TMPL_S_ELSIF ) {
+		if ( this->check_if(_exec->conds[codes[pc].cond],codes[pc].line) )
+			break;
+		pc = codes[pc].jump;
+	}
+	return pc + 1;
+}
 
-			case TMPL_S_UNKNOWN:
-				// unknown script, maybe html code
-				if ( !cycled )
-					this->error_log( _lines, "Warning: Unknown script, in parse_loop()" );
+/// 检查循环语句是否有效
+/// \param loopname 循环名称表达式
+/// \param loop 循环名称
+/// \param line 所在模板行数
+/// \return 循环已定义并且有数据时返回循环模板设置结构,否则返回NULL
+Template::tmpl_loop* Template::check_loop( const string &loopname, const string &loop, const int line ) {
+	map<string,tmpl_loop>::iterator i = _loops.find( loop );
+	if ( i!=_loops.end() && this->loop_fetch(&i->second,0) ) {
+		return &i->second;
+	} else {
+		this->error_log( line, "Warning: loop " + loopname + " \""+loop+
+			"\" not defined or not set data" );
+		return NULL;
+	}
+}
 
-				// for syntax error
-				size_t backlen;
-				if ( (backlen=exp.find(TMPL_BEGIN)) != exp.npos )
-					parsed = backlen+TMPL_BEGIN_LEN;
+/// 返回表达式指定的循环
+/// \param exp 已编译表达式
+/// \return 指定循环名称时返回该循环,否则返回当前循环,循环未定义返回NULL
+const Template::tmpl_loop* Template::scope_loop( const tmpl_exp &exp ) {
+	if ( exp.scope < 0 )
+		return _curloop;
+	map<string,tmpl_loop>::const_iterator i = _loops.find( this->exp_value(_exec->scopes[exp.scope]) );
+	return ( i!=_loops.end() ) ? &i->second : NULL;
+}
 
-				if ( status )
-					output << tmpl.substr( currpos, parsed );
-				break;
+/// 返回循环数据行数
+/// \param loop 循环模板设置结构
+/// \return 循环数据行数,循环未定义返回0
+int Template::loop_rows( const tmpl_loop *loop ) {
+	if ( loop == NULL )
+		return 0;
+	if ( loop->source != NULL )
+		return loop->source->rows();
+	return loop->rows;
+}
 
-			default:
-				// syntax error
-				if ( !cycled )
-					this->error_log( _lines, "Error: Unexpected script, in parse_loop()" );
-		}
+/// 检查循环中指定行是否存在
+/// 循环数据源移动到该行
+/// \param loop 循环模板设置结构
+/// \param cursor 行位置
+/// \retval true 该行存在
+/// \retval false 不存在
+bool Template::loop_fetch( const tmpl_loop *loop, const int cursor ) {
+	if ( loop->source != NULL )
+		return loop->source->fetch( cursor );
+	return cursor < loop->rows;
+}
 
-		// parsed length
-		length += parsed;
-		// location to next position
-		lastpos = currpos + parsed;
-	}
-	
-	// can not find TMPL_ENDLOOP
-	this->error_log( _lines, "Error: Can't find TMPL_ENDLOOP" );
+/// 返回循环中指定位置字段的值
+/// 字段值不复制,直接指向循环数据或循环数据源
+/// \param exp 已编译循环变量表达式
+/// \param pc 模板指令位置,用于缓存字段位置,为-1则不缓存
+/// \param data 字段值
+/// \param length 字段值长度
+/// \retval true 读取成功
+/// \retval false 循环或字段不存在
+bool Template::loop_cell( const tmpl_exp &exp, const int pc, 
+	const char* &data, size_t &length ) 
+{
+	// get loop info
+	const tmpl_loop *loop = this->scope_loop( exp );
+	if ( loop == NULL )
+		return false;
+	int cursor = ( exp.scope>=0 ) ? loop->cursor : _cursor;
 
-	// output tail html
-	if ( status )
-		output << tmpl.substr( lastpos );
-	length += ( tmpl.size()-lastpos );
+	// field position
+	int col;
+	if ( pc>=0 && _colcache[_colbase+pc].first==loop ) {
+		col = _colcache[_colbase+pc].second;
+	} else {
+		if ( loop->source != NULL ) {
+			col = loop->source->field_pos( exp.name );
+		} else {
+			map<string,int>::const_iterator i = loop->fieldspos.find( exp.name );
+			col = ( i!=loop->fieldspos.end() ) ? i->second : -1;
+		}
+		if ( pc >= 0 )
+			_colcache[_colbase+pc] = tmpl_colcache( loop, col );
+	}
 
-	return length;
+	// return value
+	if ( col == -1 )
+		return false;
+	if ( loop->source != NULL ) {
+		if ( !loop->source->fetch(cursor) )
+			return false;
+		data = loop->source->value( col, length );
+		return ( data != NULL );
+	}
+	if ( cursor >= loop->rows )
+		return false;
+	size_t cell = static_cast<size_t>( cursor )*loop->cols + col;
+	size_t start = ( cell>0 ) ? loop->ends[cell-1] : 0;
+	data = loop->arena.data() + start;
+	length = loop->ends[cell] - start;
+	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////
 // output functions
 
-/// ģ¼
-/// \param pos ģλ
-/// \param error 
+/// 模板分析错误纪录
+/// \param pos 模板错误行位置
+/// \param error 错误描述
 void Template::error_log( const size_t lines, const string &error ) {
 	if ( error != "" )
 		_errlog.insert( multimap<int,string>::value_type(lines,error) );
 }
 
-/// ģ¼
-/// \param output 
+/// 返回模板分析纪录
+/// \param output 分析处理结果输出流
 void Template::parse_log( ostream &output ) {
 	output << endl;
 	output << "<!-- Generated by waTemplate " << _date << " " << _time << endl
@@ -1000,41 +2071,49 @@ void Template::parse_log( ostream &output ) {
 		output << "    Line " << i->first+1
 			<< "\t\t" << i->second << endl;
 	}
+
+	if ( _profile )
+		output << this->profile();
 			   
 	output << "-->";
 	_errlog.clear();
 }
 
-/// HTMLַ
-/// \return ģ
+/// 返回HTML字符串
+/// \return 返回模板分析处理结果
 string Template::html() {
 	ostringstream result;
-	this->parse( _tmpl, result );
+	this->parse( result );
 	result << ends;
 	return result.str();
 }
 
-/// HTMLstdout
-/// \param mode ǷϢ
-/// - Template::TMPL_OUTPUT_DEBUG Ϣ
-/// - Template::TMPL_OUTPUT_RELEASE Ϣ
-/// - ĬΪϢ
+/// 输出HTML到当前请求的回应对象 Response::current()
+/// 先调用 http_head() 时按其选择的压缩方式压缩输出,
+/// 调用 set_flush() 后输出循环时提前发送已输出的内容
+/// \param mode 是否输出调试信息
+/// - Template::TMPL_OUTPUT_DEBUG 输出调试信息
+/// - Template::TMPL_OUTPUT_RELEASE 不输出调试信息
+/// - 默认为不输出调试信息
 void Template::print( const output_mode mode ) {
+	ostream &output = Response::current().stream();
 	_debug = mode;
-	this->parse( _tmpl, std::cout );
+	_response = &Response::current();
+	this->parse( output );
+	_response = NULL;
 	if ( _debug == TMPL_OUTPUT_DEBUG ) 
-		this->parse_log( std::cout );
-}
-
-/// HTMLļ
-/// \param file ļ
-/// \param mode ǷϢ
-/// - Template::TMPL_OUTPUT_DEBUG Ϣ
-/// - Template::TMPL_OUTPUT_RELEASE Ϣ
-/// - ĬΪϢ
-/// \param permission ļԲĬΪ0666
-/// \retval true ļɹ
-/// \retval false ʧ
+		this->parse_log( output );
+}
+
+/// 输出HTML到文件
+/// \param file 输出文件名
+/// \param mode 是否输出调试信息
+/// - Template::TMPL_OUTPUT_DEBUG 输出调试信息
+/// - Template::TMPL_OUTPUT_RELEASE 不输出调试信息
+/// - 默认为不输出调试信息
+/// \param permission 文件属性参数，默认为0666
+/// \retval true 文件输出成功
+/// \retval false 失败
 bool Template::print( const string &file, const output_mode mode,
 	const mode_t permission ) 
 {
@@ -1042,7 +2121,7 @@ bool Template::print( const string &file, const output_mode mode,
 	if ( outfile ) {
 		// parse
 		_debug = mode;
-		this->parse( _tmpl, outfile );
+		this->parse( outfile );
 		if ( _debug == TMPL_OUTPUT_DEBUG ) 
 			this->parse_log( outfile );
 		outfile.close();
@@ -1058,6 +2137,166 @@ bool Template::print( const string &file, const output_mode mode,
 	return false;
 }
 
+////////////////////////////////////////////////////////////////////////////
+// profile functions
+
+// 当前时间,单位为秒
+static double profile_time() {
+	struct timeval tv;
+	gettimeofday( &tv, NULL );
+	return tv.tv_sec + tv.tv_usec/1000000.0;
+}
+
+// JSON字符串
+static string json_quote( const string &str ) {
+	string res = "\"";
+	char buf[8];
+	for ( size_t i=0; i<str.length(); ++i ) {
+		unsigned char c = str[i];
+		if ( c=='"' || c=='\\' ) {
+			res += '\\';
+			res += c;
+		} else if ( c < 0x20 ) {
+			snprintf( buf, sizeof(buf), "\\u%04x", c );
+			res += buf;
+		} else {
+			res += c;
+		}
+	}
+	return res + "\"";
+}
+
+/// 设置是否纪录模板脚本执行统计
+/// 纪录时 html()、print() 按模板脚本统计条件、循环、片段缓存及包含模板块的
+/// 执行次数、循环行数、累计执行时间及输出长度,多次输出的统计累加,
+/// 调试模式输出时统计报告附加在调试信息中
+/// \param enable 是否纪录,开始纪录时清除原有统计,默认不纪录
+void Template::set_profile( const bool enable ) {
+	if ( enable && !_profile )
+		_stats.clear();
+	_profile = enable;
+}
+
+/// 清除模板脚本执行统计
+void Template::clear_profile() {
+	_stats.clear();
+}
+
+/// 模板脚本执行统计报告
+/// 整个模板的统计在前,各模板脚本按累计执行时间从大到小排列,
+/// 时间单位为毫秒,执行时间及输出长度包括块内脚本
+/// \param json 是否输出JSON格式,默认为文本格式
+/// \return 统计报告
+string Template::profile( const bool json ) const {
+	// 按累计执行时间从大到小排序,整个模板的统计在前
+	vector<const tmpl_stat*> all;
+	vector< pair<double,size_t> > order;
+	for ( map<tmpl_statkey,tmpl_stat>::const_iterator i=_stats.begin(); i!=_stats.end(); ++i ) {
+		double key = ( i->second.line<0 ) ? -1e300 : -i->second.time;
+		order.push_back( pair<double,size_t>(key,all.size()) );
+		all.push_back( &i->second );
+	}
+	sort( order.begin(), order.end() );
+
+	vector<const tmpl_stat*> stats;
+	for ( size_t i=0; i<order.size(); ++i )
+		stats.push_back( all[order[i].second] );
+
+	ostringstream report;
+	char buf[128];
+	if ( json ) {
+		report << "[";
+		for ( size_t i=0; i<stats.size(); ++i ) {
+			const tmpl_stat &stat = *stats[i];
+			snprintf( buf, sizeof(buf), "%.3f", stat.time*1000 );
+			report << ( i>0 ? ",\n" : "\n" )
+				<< "{\"file\":" << json_quote( stat.file )
+				<< ",\"line\":" << stat.line+1
+				<< ",\"script\":" << json_quote( stat.script )
+				<< ",\"count\":" << stat.count
+				<< ",\"rows\":" << stat.rows
+				<< ",\"time_ms\":" << buf
+				<< ",\"bytes\":" << stat.bytes << "}";
+		}
+		report << "\n]\n";
+		return report.str();
+	}
+
+	report << "  Profile: " << stats.size() << endl;
+	for ( size_t i=0; i<stats.size(); ++i ) {
+		const tmpl_stat &stat = *stats[i];
+		snprintf( buf, sizeof(buf), "%10.3f ms %8lu times %8lu rows %10lu bytes  ", stat.time*1000,
+			(unsigned long)stat.count, (unsigned long)stat.rows, (unsigned long)stat.bytes );
+		report << "    " << buf << stat.file;
+		if ( stat.line >= 0 )
+			report << ":" << stat.line+1;
+		report << "  " << stat.script << endl;
+	}
+	return report.str();
+}
+
+/// 模板脚本的执行统计
+/// \param program 编译后的模板或包含模板
+/// \param pc 模板指令位置,为-1时是整个模板
+/// \return 执行统计,不存在时添加
+Template::tmpl_stat& Template::profile_stat( const tmpl_program *program, const int pc ) {
+	tmpl_stat &stat = _stats[ tmpl_statkey(program,pc) ];
+	if ( stat.script == "" ) {
+		stat.file = ( program->file!="" ) ? program->file : _tmplfile;
+		if ( pc < 0 ) {
+			stat.line = -1;
+			stat.script = "(template)";
+			return stat;
+		}
+
+		const tmpl_code &code = program->codes[pc];
+		stat.line = code.line;
+		switch ( code.type ) {
+			case TMPL_S_IF:
+				stat.script = string( TMPL_BEGIN ) + TMPL_IF + " " + code.script + TMPL_END;
+				break;
+			case TMPL_S_LOOP:
+				stat.script = string( TMPL_BEGIN ) + TMPL_LOOP + " " + code.script + TMPL_END;
+				break;
+			case TMPL_S_CACHE:
+				stat.script = string( TMPL_BEGIN ) + TMPL_CACHE + " " + code.script + TMPL_END;
+				break;
+			default:
+				stat.script = string( TMPL_BEGIN ) + TMPL_INCLUDE + " " + code.script + TMPL_END;
+		}
+	}
+	return stat;
+}
+
+/// 开始纪录块执行统计
+/// \param blocks 执行中的块列表
+/// \param pc 块开始指令位置,为-1时是整个模板
+/// \param end 块结束指令位置,执行到该位置之后时结束纪录
+void Template::profile_open( vector<tmpl_block> &blocks, const int pc, const int end ) {
+	tmpl_block block;
+	block.stat = &this->profile_stat( (pc>=0) ? _exec : _program, pc );
+	block.end = end;
+	block.bytes = _outbytes;
+	block.rows = 0;
+	block.start = profile_time();
+	blocks.push_back( block );
+}
+
+/// 结束纪录指定位置之前的块执行统计
+/// \param blocks 执行中的块列表
+/// \param pc 当前指令位置,结束位置在该位置之前的块结束纪录
+void Template::profile_close( vector<tmpl_block> &blocks, const int pc ) {
+	double now = profile_time();
+	while ( !blocks.empty() && pc>blocks.back().end ) {
+		tmpl_block &block = blocks.back();
+		++block.stat->count;
+		block.stat->rows += block.rows;
+		block.stat->time += now - block.start;
+		block.stat->bytes += _outbytes - block.bytes;
+		blocks.pop_back();
+	}
+}
+
 } // namespace
 
 
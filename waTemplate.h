@@ -1,8 +1,8 @@
 /// \file waTemplate.h
-/// HTMLģ崦ͷļ
-/// ֧ѭűHTMLģ崦
-///  waString
-/// <a href="wa_template.html">ʹ˵ĵ򵥷</a>
+/// HTML模板处理类头文件
+/// 支持条件、循环脚本的HTML模板处理类
+/// 依赖于 waString, waEncode, waResponse
+/// <a href="wa_template.html">使用说明文档及简单范例</a>
 
 #ifndef _WEBAPPLIB_TMPL_H_
 #define _WEBAPPLIB_TMPL_H_ 
@@ -11,159 +11,573 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <ctime>
+#include <sys/types.h>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 #include "waString.h"
+#include "waEncode.h"
 
 using namespace std;
 
 /// Web Application Library namaspace
 namespace webapp {
 	
-/// ֧ѭűHTMLģ崦
-/// <a href="wa_template.html">ʹ˵ĵ򵥷</a>
+/// 模板缓存默认内存上限,单位为byte
+const size_t TMPL_CACHE_SIZE = 32*1024*1024;
+
+/// 片段缓存默认内存上限,单位为byte
+const size_t TMPL_FRAGMENT_SIZE = 8*1024*1024;
+
+/// 片段缓存默认缓存时间,单位为秒
+const int TMPL_FRAGMENT_TTL = 60;
+
+/// 包含模板最大嵌套层数
+const int TMPL_INCLUDE_DEPTH = 8;
+
+/// 模板循环数据源接口
+/// 由 Template::set_loop() 指定为循环数据,输出时按行读取字段值,
+/// 字段值直接从数据源输出,不复制到 Template 中,如 MysqlData
+class TemplateSource {
+	public:
+
+	/// 析构函数
+	virtual ~TemplateSource(){};
+
+	/// 返回字段位置
+	/// \param field 字段名
+	/// \return 字段位置,不存在返回-1
+	virtual int field_pos( const string &field ) = 0;
+
+	/// 移动到指定行
+	/// \param row 行位置
+	/// \retval true 成功
+	/// \retval false 该行不存在
+	virtual bool fetch( const size_t row ) = 0;
+
+	/// 返回当前行指定位置的字段值
+	/// \param col 字段位置,由 field_pos() 返回
+	/// \param length 字段值长度
+	/// \return 字段值,不存在返回NULL
+	virtual const char* value( const int col, size_t &length ) = 0;
+
+	/// 返回数据行数
+	virtual size_t rows() const = 0;
+};
+
+class TemplateStream;
+
+/// \typedef tmpl_row_reader
+/// 流式循环数据读取函数类型,
+/// 参数依次为 TemplateStream 对象,TemplateStream 构造时指定的参数,
+/// 函数中调用 TemplateStream::append() 依次添加一行数据的字段值,
+/// 返回true表示已添加一行数据,返回false表示数据结束
+typedef bool (*tmpl_row_reader)( TemplateStream &stream, void *arg );
+
+/// 流式模板循环数据源
+/// 输出循环时每次调用读取函数读取一行数据,只保存当前行,
+/// 用于数据量很大的循环,数据只能按顺序读取一次,
+/// 读取过程中 \%ROWS 为已读取的行数
+class TemplateStream : public TemplateSource {
+	public:
+
+	/// 构造函数
+	TemplateStream( tmpl_row_reader reader, void *arg, const char* field_0, ... );
+
+	/// 析构函数
+	virtual ~TemplateStream(){};
+
+	/// 添加一个字段值到当前行
+	void append( const char *value, const size_t length );
+	/// 添加一个字段值到当前行
+	/// \param value 字段值
+	inline void append( const char *value ) {
+		this->append( value, strlen(value) );
+	}
+	/// 添加一个字段值到当前行
+	/// \param value 字段值
+	inline void append( const string &value ) {
+		this->append( value.data(), value.length() );
+	}
+	/// 添加一个整数字段值到当前行
+	void append( const long value );
+	/// 添加一个整数字段值到当前行
+	/// \param value 字段值
+	inline void append( const int value ) {
+		this->append( static_cast<long>(value) );
+	}
+
+	/// 返回字段位置
+	int field_pos( const string &field );
+	/// 读取指定行
+	bool fetch( const size_t row );
+	/// 返回当前行指定位置的字段值
+	const char* value( const int col, size_t &length );
+
+	/// 返回已读取的数据行数
+	/// \return 已读取的数据行数
+	inline size_t rows() const {
+		return _rows;
+	}
+
+	////////////////////////////////////////////////////////////////////////////
+	private:
+
+	/// 禁止调用拷贝构造函数
+	TemplateStream( TemplateStream &copy );
+	/// 禁止调用拷贝赋值操作
+	TemplateStream& operator = ( const TemplateStream& copy );
+
+	tmpl_row_reader _reader;			// 读取函数
+	void *_arg;							// 读取函数参数
+	map<string,int> _fieldspos;			// 字段位置
+	size_t _rows;						// 已读取的数据行数
+	bool _eof;							// 数据是否已结束
+	string _arena;						// 当前行字段值,依次连续保存
+	vector<size_t> _ends;				// 当前行各字段值在 _arena 中的结束位置
+};
+
+class Response;
+
+/// 支持条件、循环脚本的HTML模板处理类
+/// 模板读取时编译为指令列表,输出时只执行指令列表,不再重复分析模板脚本,
+/// 从文件读取的编译结果保存在进程内共享的模板缓存中,文件修改后自动重新读取
+/// <a href="wa_template.html">使用说明文档及简单范例</a>
 class Template {
+	friend class TemplateCompiler;
+
 	public:
 	
-	/// ĬϹ캯
-	Template(){};
+	/// 默认构造函数
+	Template():
+	_program(NULL), _lastloop(NULL), _escape(ESCAPE_NONE), _curloop(NULL), _exec(NULL), _slotmap(NULL), _colbase(0),
+	_flushrows(0), _response(NULL), _outbytes(0), _profile(false),
+	_debug(TMPL_OUTPUT_RELEASE)
+	{}
 	
-	/// 캯
-	/// \param tmpl_file ģļ
-	Template( const string tmpl_file ) {
+	/// 构造函数
+	/// \param tmpl_file 模板文件
+	Template( const string tmpl_file ):
+	_program(NULL), _lastloop(NULL), _escape(ESCAPE_NONE), _curloop(NULL), _exec(NULL), _slotmap(NULL), _colbase(0),
+	_flushrows(0), _response(NULL), _outbytes(0), _profile(false),
+	_debug(TMPL_OUTPUT_RELEASE)
+	{
 		this->load( tmpl_file );
 	}
 	
-	/// 캯
-	/// \param tmpl_dir ģĿ¼
-	/// \param tmpl_file ģļ
-	Template( const string tmpl_dir, const string tmpl_file ) {
+	/// 构造函数
+	/// \param tmpl_dir 模板目录
+	/// \param tmpl_file 模板文件
+	Template( const string tmpl_dir, const string tmpl_file ):
+	_program(NULL), _lastloop(NULL), _escape(ESCAPE_NONE), _curloop(NULL), _exec(NULL), _slotmap(NULL), _colbase(0),
+	_flushrows(0), _response(NULL), _outbytes(0), _profile(false),
+	_debug(TMPL_OUTPUT_RELEASE)
+	{
 		this->load( tmpl_dir, tmpl_file );
 	}
+
+	/// 拷贝构造函数
+	Template( const Template &copy );
+	/// 拷贝赋值操作
+	Template& operator = ( const Template &copy );
 	
-	/// 
-	virtual ~Template(){};
+	/// 析构函数
+	virtual ~Template();
+
+	/// 模板缓存统计
+	typedef struct {
+		size_t hits;					// 命中次数
+		size_t misses;					// 未命中次数
+		size_t files;					// 已缓存模板数量
+		size_t bytes;					// 已缓存模板占用内存估计值
+	} cache_stat;
+
+	/// 设置模板缓存内存上限
+	static void set_cache( const size_t max_bytes );
+	/// 清空模板缓存
+	static void clear_cache();
+	/// 模板缓存统计
+	static cache_stat cache_stats();
+
+	/// 设置片段缓存内存上限
+	static void set_fragment_cache( const size_t max_bytes );
+	/// 清除片段缓存
+	static void clear_fragment( const string &key = "" );
 	
-	/// \enum ʱǷϢ
+	/// \enum 输出时是否包括调试信息
 	enum output_mode {
-		/// ʾϢ
+		/// 显示调试信息
 		TMPL_OUTPUT_DEBUG,	
-		/// ʾ
+		/// 不显示
 		TMPL_OUTPUT_RELEASE	
 	};
 
-	/// ȡHTMLģļ
+	/// 读取HTML模板文件
 	bool load( const string &tmpl_file );
 
-	/// ȡģ
-	/// \param tmpl_dir ģĿ¼
-	/// \param tmpl_file ģļ
-	/// \retval true ȡɹ
-	/// \retval false ʧ
+	/// 读取模板
+	/// \param tmpl_dir 模板目录
+	/// \param tmpl_file 模板文件
+	/// \retval true 读取成功
+	/// \retval false 失败
 	inline bool load( const string &tmpl_dir, const string &tmpl_file ) {
 		return this->load( tmpl_dir + "/" + tmpl_file );
 	}
 	
-	/// HTMLģ
+	/// 设置HTML模板内容
 	void tmpl( const string &tmpl );
 
-	/// 滻
+	/// 返回模板域位置
+	int slot( const string &name ) const;
+
+	/// 设置替换规则
 	void set( const string &name, const string &value );
-	/// 滻
-	/// \param name ģ
-	/// \param value 滻ֵ
+	/// 设置替换规则
+	/// \param name 模板域名称
+	/// \param value 替换值
 	inline void set( const string &name, const long value ) {
 		this->set( name, itos(value) );
 	}
+	/// 设置替换规则
+	void set( const int slot, const string &value );
+	/// 设置替换规则
+	/// \param slot 模板域位置,由 slot() 返回
+	/// \param value 替换值
+	inline void set( const int slot, const long value ) {
+		this->set( slot, itos(value) );
+	}
+	#if __cplusplus >= 201103L
+	/// 设置替换规则
+	void set( const string &name, string &&value );
+	/// 设置替换规则
+	void set( const int slot, string &&value );
+	#endif
 	
-	/// ½ѭ
+	/// 新建循环
 	void def_loop( const string &loop, const char* field_0, ... );
-	/// һݵѭ
+	/// 添加一行数据到循环
 	void append_row( const string &loop, const char* value_0, ... );
-	/// һָʽݵѭ
+	/// 添加一行指定格式的数据到循环
 	void append_format( const string &loop, const char* format, ... );
+
+	/// 预留循环数据空间
+	void reserve( const string &loop, const size_t rows, const size_t bytes = 0 );
+	/// 添加一个字段值到循环
+	void append( const string &loop, const char *value, const size_t length );
+	/// 添加一个字段值到循环
+	/// \param loop 循环名称
+	/// \param value 字段值
+	inline void append( const string &loop, const char *value ) {
+		this->append( loop, value, strlen(value) );
+	}
+	/// 添加一个字段值到循环
+	/// \param loop 循环名称
+	/// \param value 字段值
+	inline void append( const string &loop, const string &value ) {
+		this->append( loop, value.data(), value.length() );
+	}
+	#if __cplusplus >= 201703L
+	/// 添加一个字段值到循环
+	/// \param loop 循环名称
+	/// \param value 字段值
+	inline void append( const string &loop, const string_view value ) {
+		this->append( loop, value.data(), value.length() );
+	}
+	#endif
+	/// 添加一个整数字段值到循环
+	void append( const string &loop, const long value );
+	/// 添加一个整数字段值到循环
+	/// \param loop 循环名称
+	/// \param value 字段值
+	inline void append( const string &loop, const int value ) {
+		this->append( loop, static_cast<long>(value) );
+	}
+	/// 添加一个浮点数字段值到循环
+	void append( const string &loop, const double value, const int ndigit = 2 );
+
+	/// 设置循环数据源
+	void set_loop( const string &loop, TemplateSource &source );
+
+	/// 设置输出时提前发送的循环行数
+	/// \param rows print() 输出至回应对象时,每输出该行数的循环数据后调用 Response::flush(),
+	/// 为0则不提前发送,默认为0
+	inline void set_flush( const size_t rows ) {
+		_flushrows = rows;
+	}
+
+	/// 设置模板域及循环字段的默认输出转义方式
+	/// \param mode 转义方式,模板中 {{$xxx|转义方式}} 指定的转义方式优先,
+	/// 默认为 ESCAPE_NONE
+	inline void set_escape( const escape_mode mode ) {
+		_escape = mode;
+	}
 	
-	/// 滻
+	/// 清空所有替换规则
 	void clear_set();
 
-	/// HTMLַ
+	/// 返回HTML字符串
 	string html();
-	/// HTMLstdout
+	/// 输出HTML到当前请求的回应对象
 	void print( const output_mode mode = TMPL_OUTPUT_RELEASE );
-	/// HTMLļ
+	/// 输出HTML到文件
 	bool print( const string &file, const output_mode mode = TMPL_OUTPUT_RELEASE,
 		const mode_t permission = S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH );
+
+	/// 设置是否纪录模板脚本执行统计
+	void set_profile( const bool enable );
+	/// 清除模板脚本执行统计
+	void clear_profile();
+	/// 模板脚本执行统计报告
+	string profile( const bool json = false ) const;
 	
 	////////////////////////////////////////////////////////////////////////////
 	private:
 	
-	/// ȡָλõģűͼʽ
-	int parse_script( const string &tmpl, const size_t pos,
+	// 数据定义
+	typedef vector<string> strings;		// 字符串列表
+	typedef struct {					// 循环模板设置结构
+		int cols;						// 循环字段数量
+		int rows;						// 循环数据行数
+		int cursor;						// 当前光标位置
+		strings fields;					// 循环字段定义列表
+		map<string,int> fieldspos;		// 循环字段位置,for speed
+		string arena;					// 循环数据,全部字段值依次连续保存
+		vector<size_t> ends;			// 各字段值在 arena 中的结束位置,按行依次排列
+		TemplateSource *source;			// 循环数据源,为NULL时使用 arena
+	} tmpl_loop;
+
+	typedef struct {					// 上层循环状态
+		tmpl_loop *loop;				// 循环模板设置结构
+		int cursor;						// 循环光标位置
+	} tmpl_frame;
+
+	typedef pair<const tmpl_loop*,int> tmpl_colcache;	// 字段位置缓存 <循环模板设置结构,字段位置>
+
+	typedef struct {					// 编译后的表达式
+		int type;						// 表达式类型 tmpl_scripttype,TMPL_S_UNKNOWN 为字符串
+		string name;					// 模板域名称,循环字段名称或字符串值
+		int slot;						// 模板域位置,TMPL_S_VALUE 时有效
+		int scope;						// 循环名称表达式位置,未指定循环名称时为-1
+	} tmpl_exp;
+
+	typedef struct {					// 编译后的比较表达式
+		int op;							// 比较运算类型 tmpl_cmptype
+		tmpl_exp lexp;					// 左侧表达式
+		tmpl_exp rexp;					// 右侧表达式,TMPL_C_NONE 时不使用
+	} tmpl_cmp;
+
+	typedef struct {					// 编译后的条件表达式
+		int logic;						// 逻辑运算类型 tmpl_logictype
+		bool warning;					// 是否为错误的 TMPL_AND/TMPL_OR 脚本
+		vector<tmpl_cmp> cmps;			// 比较表达式列表
+	} tmpl_cond;
+
+	typedef struct {					// 模板指令
+		int type;						// 指令类型 tmpl_scripttype,TMPL_S_TEXT 为静态文本
+		size_t pos;						// 静态文本在模板中的位置
+		size_t len;						// 静态文本长度
+		int line;						// 所在模板行数
+		int jump;						// 跳转位置,见 compile()
+		int end;						// 条件分支对应的 TMPL_S_ENDIF 位置
+		int cond;						// 条件表达式在条件表达式列表中的位置
+		tmpl_exp exp;					// 表达式
+		string script;					// 条件、循环、片段缓存及包含模板脚本原文,用于错误纪录及执行统计
+		int frag;						// 片段缓存定义在片段缓存定义列表中的位置
+		int include;					// 包含模板在包含模板列表中的位置
+		int escape;						// 输出转义方式 escape_mode,为-1时使用默认转义方式
+	} tmpl_code;
+
+	typedef struct {					// 编译后的片段缓存定义
+		vector<tmpl_exp> key;			// 缓存键表达式列表,输出时依次连接
+		int ttl;						// 缓存时间,单位为秒,为0则不过期
+	} tmpl_frag;
+
+	struct tmpl_program;
+
+	typedef struct {					// 包含模板
+		tmpl_program *program;			// 编译后的包含模板,与其它模板共享
+		vector<int> slots;				// 包含模板的模板域对应的本模板模板域位置
+		size_t colbase;					// 包含模板字段位置缓存的起始位置
+	} tmpl_include;
+
+	struct tmpl_program {			// 编译后的模板,编译后不再修改,多个对象共享
+		String tmpl;					// HTML模板内容
+		string file;					// 模板文件名,从字符串读取时为空
+		time_t mtime;					// 模板文件修改时间
+		off_t size;						// 模板文件大小
+		ino_t ino;						// 模板文件inode
+		vector<tmpl_code> codes;		// 模板指令列表
+		vector<tmpl_cond> conds;		// 条件表达式列表
+		vector<tmpl_exp> scopes;		// 循环名称表达式列表
+		vector<tmpl_frag> frags;		// 片段缓存定义列表
+		vector<tmpl_include> includes;	// 包含模板列表
+		map<string,int> slots;			// 模板域位置列表 <模板域名称,位置>
+		strings names;					// 模板域名称列表
+		multimap<int,string> errlog;	// 编译错误纪录 <错误位置行数,错误描述信息>
+		size_t cols;					// 字段位置缓存长度,包括各层包含模板
+		size_t bytes;					// 占用内存估计值
+		volatile int refs;				// 引用计数
+	};
+
+	typedef struct {					// 模板脚本执行统计
+		string file;					// 模板文件名
+		int line;						// 所在模板行数,为-1时是整个模板
+		string script;					// 模板脚本
+		size_t count;					// 执行次数
+		size_t rows;					// 循环输出行数
+		double time;					// 累计执行时间,单位为秒,包括块内脚本
+		size_t bytes;					// 累计输出长度,包括块内脚本
+	} tmpl_stat;
+	typedef pair<const tmpl_program*,int> tmpl_statkey;	// 执行统计索引 <编译后的模板,模板指令位置>
+
+	typedef struct {					// 执行中的块
+		tmpl_stat *stat;				// 执行统计
+		int end;						// 块结束指令位置
+		double start;					// 开始时间
+		size_t bytes;					// 开始时的输出长度
+		int rows;						// 循环输出行数
+	} tmpl_block;
+
+	struct tmpl_cache;					// 模板缓存
+	struct tmpl_fragments;				// 片段缓存
+	struct tmpl_capture;				// 片段缓存块输出状态
+
+	/// 读取指定位置的模板脚本类型及表达式
+	static int parse_script( const string &tmpl, const size_t pos,
 		string &exp, int &type );
 
-	/// ʽֵ
-	string exp_value( const string &expression );
+	/// 编译模板
+	static void compile( tmpl_program &program, const int depth = 0 );
+	/// 添加模板指令
+	static int add_code( tmpl_program &program, const int type, const int line );
+	/// 添加静态文本指令
+	static void add_text( tmpl_program &program, const size_t pos, 
+		const size_t len, const int line );
+	/// 编译表达式
+	static void compile_exp( tmpl_program &program, const string &exp, tmpl_exp &result );
+	/// 编译循环名称表达式
+	static int compile_scope( tmpl_program &program, const string &exp );
+	/// 添加模板域
+	static int add_slot( tmpl_program &program, const string &name );
+	/// 编译比较表达式
+	static void compile_cmp( tmpl_program &program, const string &exp, tmpl_cmp &result );
+	/// 编译条件表达式
+	static int compile_cond( tmpl_program &program, const string &exp );
+	/// 编译片段缓存定义
+	static int compile_frag( tmpl_program &program, const string &exp );
+	/// 编译输出转义方式
+	static int compile_escape( string &exp, string &error );
+	/// 编译包含模板
+	static int compile_include( tmpl_program &program, const string &exp, 
+		const int depth, string &error );
+
+	/// 模板缓存
+	static tmpl_cache& cache();
+	/// 从模板缓存读取模板文件
+	static tmpl_program* cache_load( const string &tmpl_file, const int depth = 0 );
+	/// 检查包含模板文件是否已修改
+	static bool modified( const tmpl_program *program );
+	/// 释放编译后的模板
+	static void release( tmpl_program *program );
+	/// 片段缓存
+	static tmpl_fragments& fragments();
 
-	/// ģ
-	void parse( const string &tmpl, ostream &output );
+	/// 使用编译后的模板
+	void bind( tmpl_program *program );
+
+	/// 分析已编译表达式的值
+	string exp_value( const tmpl_exp &exp );
+
+	/// 执行模板指令
+	void parse( ostream &output );
+	/// 执行当前模板或包含模板的指令
+	void execute( ostream &output );
+	/// 按转义方式输出模板域或循环字段的值
+	size_t write_value( ostream &output, const int escape, const char *data, const size_t length );
 	
-	/// ʽǷ
-	bool compare( const string &exp );
+	/// 检查比较表达式是否成立
+	bool compare( const tmpl_cmp &cmp );
 	
-	/// Ƿ
-	bool check_if( const string &exp );
+	/// 检查条件是否成立
+	bool check_if( const tmpl_cond &cond, const int line );
 
-	/// ģ
-	size_t parse_if( const string &tmpl, ostream &output, 
-		const bool parent_state, const string &parsed_exp,
-		const int parsed_length );
+	/// 查找成立的条件分支
+	int check_branch( const vector<tmpl_code> &codes, int pc );
 
-	/// ֶλ
-	int field_pos( const string &loop, const string &field );
+	/// 模板域值,包含模板中按模板域对应关系转换
+	inline const string& slot_value( const int slot ) const {
+		return _values[ (_slotmap!=NULL) ? _slotmap[slot] : slot ];
+	}
 
-	/// ѭǷЧ
-	bool check_loop( const string &loopname );
-	
-	/// ѭָλֶεֵ
-	string loop_value( const string &field );
+	/// 读取片段缓存
+	bool fetch_fragment( const string &key );
+	/// 保存片段缓存
+	static void store_fragment( const string &key, const string &html, const int ttl );
+
+	/// 初始化循环
+	tmpl_loop& init_loop( const string &loop );
+	/// 查找循环
+	tmpl_loop* find_loop( const string &loop );
+	/// 添加一个字段值到循环数据
+	void append_cell( tmpl_loop &data, const char *value, const size_t length );
 
-	/// ѭģ
-	size_t parse_loop( const string &tmpl, ostream &output, 
-		const bool parent_state, const string &parsed_exp,
-		const int parsed_length );
+	/// 检查循环语句是否有效
+	tmpl_loop* check_loop( const string &loopname, const string &loop, const int line );
+	/// 返回表达式指定的循环
+	const tmpl_loop* scope_loop( const tmpl_exp &exp );
+	/// 返回循环数据行数
+	int loop_rows( const tmpl_loop *loop );
+	/// 检查循环中指定行是否存在
+	bool loop_fetch( const tmpl_loop *loop, const int cursor );
+	
+	/// 返回循环中指定位置字段的值
+	bool loop_cell( const tmpl_exp &exp, const int pc, const char* &data, size_t &length );
 							
-	/// ģ¼
+	/// 模板分析错误纪录
 	void error_log( const size_t lines, const string &error );
-	/// ģ¼
+	/// 模板分析纪录
 	void parse_log( ostream &output );
 
-	// ݶ
-	typedef vector<string> strings;		// ַб
-	typedef struct {					// ѭģýṹ
-		int cols;						// ѭֶ
-		int rows;						// ѭ
-		int cursor;						// ǰλ
-		strings fields;					// ѭֶζб
-		map<string,int> fieldspos;		// ѭֶλ,for speed
-		vector<strings> datas;			// ѭ
-	} tmpl_loop;
+	/// 模板脚本的执行统计
+	tmpl_stat& profile_stat( const tmpl_program *program, const int pc );
+	/// 开始纪录块执行统计
+	void profile_open( vector<tmpl_block> &blocks, const int pc, const int end );
+	/// 结束纪录指定位置之前的块执行统计
+	void profile_close( vector<tmpl_block> &blocks, const int pc );
 
-	// ģ
-	String _tmpl;						// HTMLģ
-	map<string,string> _sets;			// 滻б <ģ,ģֵ>
-	map<string,tmpl_loop> _loops;		// ѭ滻б <ѭ,ѭģýṹ>
+	// 模板数据
+	tmpl_program *_program;				// 编译后的模板
+	strings _values;					// 模板域值列表,按模板域位置索引
+	map<string,string> _sets;			// 模板中没有的替换规则列表 <模板域名称,模板域值>
+	map<string,tmpl_loop> _loops;		// 循环替换规则列表 <循环名称,循环模板设置结构>
+	tmpl_loop *_lastloop;				// 最近添加数据的循环
+	string _lastname;					// 最近添加数据的循环名称
+	escape_mode _escape;				// 默认输出转义方式
 	
-	// 
-	string _loop;						// ǰѭ
-	int _cursor;						// ǰѭλ
-	int _lines;							// Ѵģ
-
-	string _tmplfile;					// HTMLģļ
-	char _date[15];						// ǰ
-	char _time[15];						// ǰʱ
-	output_mode _debug;					// ģʽ
-	multimap<int,string> _errlog;		// ¼ <λ,Ϣ>
+	// 分析过程数据
+	tmpl_loop *_curloop;				// 当前循环
+	int _cursor;						// 当前循环光标位置
+	vector<tmpl_colcache> _colcache;	// 字段位置缓存,按模板指令位置索引
+	const tmpl_program *_exec;			// 正在执行的模板或包含模板
+	const int *_slotmap;				// 包含模板的模板域对应关系,为NULL时不转换
+	size_t _colbase;					// 包含模板字段位置缓存的起始位置
+	string _fragment;					// 读取的片段缓存内容
+	size_t _flushrows;					// 提前发送的循环行数
+	size_t _flushed;					// 上次发送后输出的循环行数
+	Response *_response;				// print() 输出的回应对象
+	size_t _outbytes;					// 已输出长度
+	bool _profile;						// 是否纪录执行统计
+	map<tmpl_statkey,tmpl_stat> _stats;	// 执行统计列表
+
+	string _tmplfile;					// HTML模板文件名
+	char _date[15];						// 当前日期
+	char _time[15];						// 当前时间
+	output_mode _debug;					// 分析模式
+	multimap<int,string> _errlog;		// 分析错误纪录 <错误位置行数,错误描述信息>
 };
 
-// ģ﷨ʽ
+// 模板语法格式定义
 const char TMPL_BEGIN[]		= "{{";		const int TMPL_BEGIN_LEN 	= strlen(TMPL_BEGIN);
 const char TMPL_END[]		= "}}";		const int TMPL_END_LEN 		= strlen(TMPL_END);
 const char TMPL_SUBBEGIN[]	= "(";		const int TMPL_SUBBEGIN_LEN = strlen(TMPL_SUBBEGIN);
@@ -189,7 +603,12 @@ const char TMPL_ELSIF[]		= "#ELSIF";	const int TMPL_ELSIF_LEN 	= strlen(TMPL_ELS
 const char TMPL_ELSE[]		= "#ELSE";	const int TMPL_ELSE_LEN 	= strlen(TMPL_ELSE);
 const char TMPL_ENDIF[]		= "#ENDIF";	const int TMPL_ENDIF_LEN 	= strlen(TMPL_ENDIF);
 
-// Ƚϲ
+const char TMPL_CACHE[]		= "#CACHE";	const int TMPL_CACHE_LEN 	= strlen(TMPL_CACHE);
+const char TMPL_ENDCACHE[]	= "#ENDCACHE";const int TMPL_ENDCACHE_LEN = strlen(TMPL_ENDCACHE);
+const char TMPL_INCLUDE[]	= "#INCLUDE";const int TMPL_INCLUDE_LEN = strlen(TMPL_INCLUDE);
+const char TMPL_ESCAPE[]	= "|";		const int TMPL_ESCAPE_LEN	= strlen(TMPL_ESCAPE);
+
+// 比较操作符定义
 const char TMPL_AND[]		= "AND";	const int TMPL_AND_LEN 		= strlen(TMPL_AND);
 const char TMPL_OR[]		= "OR";		const int TMPL_OR_LEN 		= strlen(TMPL_OR);
 const char TMPL_EQ[]		= "==";		const int TMPL_EQ_LEN 		= strlen(TMPL_EQ);
@@ -199,11 +618,11 @@ const char TMPL_LT[]		= "<";		const int TMPL_LT_LEN 		= strlen(TMPL_LT);
 const char TMPL_GE[]		= ">=";		const int TMPL_GE_LEN 		= strlen(TMPL_GE);
 const char TMPL_GT[]		= ">";		const int TMPL_GT_LEN 		= strlen(TMPL_GT);
 
-// Htt::format_row()ʽ
+// Htt::format_row()格式定义
 const char TMPL_FMTSTR[]	= "%s";		const int TMPL_FMTSTR_LEN 	= strlen(TMPL_FMTSTR);
 const char TMPL_FMTINT[]	= "%d";		const int TMPL_FMTINT_LEN 	= strlen(TMPL_FMTINT);
 
-// ű
+// 脚本语句类型
 enum tmpl_scripttype {
 	TMPL_S_VALUE,	
 	TMPL_S_LOOPVALUE,	
@@ -219,24 +638,29 @@ enum tmpl_scripttype {
 	TMPL_S_TIME,
 	TMPL_S_SPACE,
 	TMPL_S_BLANK,
-	TMPL_S_UNKNOWN
+	TMPL_S_UNKNOWN,
+	TMPL_S_TEXT,
+	TMPL_S_CACHE,
+	TMPL_S_ENDCACHE,
+	TMPL_S_INCLUDE
 };
 
-// ߼
+// 逻辑运算类型
 enum tmpl_logictype {
 	TMPL_L_NONE,	
 	TMPL_L_AND,
 	TMPL_L_OR
 };
 
-// Ƚ
+// 比较运算类型
 enum tmpl_cmptype {
 	TMPL_C_EQ,
 	TMPL_C_NE,
 	TMPL_C_LE,
 	TMPL_C_LT,
 	TMPL_C_GE,
-	TMPL_C_GT
+	TMPL_C_GT,
+	TMPL_C_NONE
 };
 
 } // namespace
@@ -1,7 +1,7 @@
 /// \file waTextFile.h
-/// ̶ָıļȡͷļ
-/// ȡ̶ָıļ
-///  webapp::String
+/// 固定分隔符文本文件读取解析类头文件
+/// 读取解析固定分隔符文本文件
+/// 依赖于 webapp::String
 
 #ifndef _WEBAPPLIB_TEXTFILE_H_
 #define _WEBAPPLIB_TEXTFILE_H_ 
@@ -14,35 +14,35 @@ using namespace std;
 /// Web Application Library namaspace
 namespace webapp {
 	
-/// ̶ָıļȡ
+/// 固定分隔符文本文件读取解析类
 class TextFile {
 	public:
 		
-	/// ĬϹ캯
+	/// 默认构造函数
 	TextFile():_fp(0), _line(0), _len(0)
 	{};
 	
-	/// ΪıļĹ캯
+	/// 参数为文本文件名的构造函数
 	TextFile( const string &file )
 	:_fp(0), _line(0), _len(0) {
 		this->open( file );
 	}
 	
-	/// 
+	/// 析构函数
 	~TextFile() {
 		this->close();
 	}
 	
-	/// ıļ
+	/// 打开文本文件
 	bool open( const string &file );
 	
-	/// رıļ
+	/// 关闭文本文件
 	void close();
 	
-	/// ȡһ
+	/// 读取下一行
 	bool next_line( string &line );
 	
-	/// ȡһвֶָ
+	/// 读取下一行并按分隔符拆分字段
 	bool next_fields( vector<String> &fields, const string &split="\t", const int limit=0 );
 	
 	////////////////////////////////////////////////////////////////////////////
@@ -1,5 +1,5 @@
 /// \file waUtility.cpp
-/// ϵͳùߺʵļ
+/// 系统调用工具函数实现文件
 
 #include <cstdio>
 #include <cstring>
@@ -28,11 +28,11 @@ namespace webapp {
 	
 /// \ingroup waUtility 
 /// \fn size_t string_hash( const string &str )
-/// ַHASHֵDJB HASH㷨
-/// Perlʵְ汾 string_hash.pl
-/// JavaScriptʵְ汾 string_hash.js
-/// \param str Դַ
-/// \return ַHASH޷
+/// 返回字符串HASH值，基于DJB HASH算法
+/// Perl兼容实现版本 string_hash.pl
+/// JavaScript兼容实现版本 string_hash.js
+/// \param str 源字符串
+/// \return 字符串HASH结果，无符号整数
 size_t string_hash( const string &str ) {
 	unsigned char ch;
 	size_t hash = 5381;
@@ -51,10 +51,10 @@ size_t string_hash( const string &str ) {
 
 /// \ingroup waUtility 
 /// \fn string replace_text( const string &text, const map<string,string> &replace )
-/// ȫĴʱ滻GBK
-/// \param text ַԭ
-/// \param replace 滻Ӧʱ
-/// \return 滻
+/// 全文词表替换，兼容GBK汉字
+/// \param text 字符串原文
+/// \param replace 替换对应词表
+/// \return 替换后结果
 string replace_text( const string &text, const map<string,string> &replace ) {
 	// replace size list 
 	map<string,string>::const_iterator it = replace.begin();
@@ -111,7 +111,7 @@ string replace_text( const string &text, const map<string,string> &replace ) {
 	return result;
 }
 
-// жǷַ
+// 判断是否标点符号字符
 bool is_punctuation( unsigned char c ) {
 	const char filter_char[] = "`[]~@^_{}|\\";
 	if ( strchr(filter_char,c) != NULL )
@@ -120,7 +120,7 @@ bool is_punctuation( unsigned char c ) {
 		return false;
 }
 
-// ȫĸ֡㡢հַתΪַ
+// 全角字母、数字、标点、空白字符转换为半角字符
 string sbc_to_dbc( const string &sbc_string ) {
 	string dbc;
 	if ( sbc_string == "" ) return dbc;
@@ -158,9 +158,9 @@ string sbc_to_dbc( const string &sbc_string ) {
 
 /// \ingroup waUtility 
 /// \fn string extract_html( const string &html )
-/// ȡHTML
-/// \param html HTMLַ
-/// \return HTMLȡ
+/// 提取HTML代码正文
+/// \param html HTML代码字符串
+/// \return 不含HTML代码的提取结果
 string extract_html( const string &html ) {
 	bool in_html = false;
 	string text, curr_tag;
@@ -190,17 +190,17 @@ string extract_html( const string &html ) {
 
 /// \ingroup waUtility 
 /// \fn string extract_text( const string &text, const int option, const size_t len )
-/// ȫǰַתȡ
-/// \param text Դַ
-/// \param option ˷Χѡѡֵ
-/// - EXTRACT_ALPHA ĸ
-/// - EXTRACT_DIGIT 
-/// - EXTRACT_PUNCT ˱
-/// - EXTRACT_SPACE ˿հ
-/// - EXTRACT_HTML HTML
-/// - ĬֵΪEXTRACT_ALLȫ
-/// \param len ˳ȣ0ʱֻȡǰlenЧַĬΪ0
-/// \return תȡַԴַݱȫ򷵻ؿ
+/// 全角半角字符转换并提取正文
+/// \param text 源字符串
+/// \param option 过滤范围选项，可选值组合有
+/// - EXTRACT_ALPHA 过滤字母
+/// - EXTRACT_DIGIT 过滤数字
+/// - EXTRACT_PUNCT 过滤标点
+/// - EXTRACT_SPACE 过滤空白
+/// - EXTRACT_HTML 过滤HTML代码
+/// - 默认值为EXTRACT_ALL即以上全部
+/// \param len 过滤长度，大于0时只截取前len个有效字符，默认为0
+/// \return 转换提取结果字符串，若源字符串内容被全部过滤则返回空
 string extract_text( const string &text, const int option, const size_t len ) {
 	if ( text=="" || option<=0 )
 		return text;
@@ -244,7 +244,7 @@ string extract_text( const string &text, const int option, const size_t len ) {
 	return extracted;
 }
 
-// ײ־ʵ
+// 底层日志函数实现
 void _file_logger( FILE *fp, va_list ap, const char *format ) {
 	if ( fp == NULL ) return;
 	
@@ -260,10 +260,10 @@ void _file_logger( FILE *fp, va_list ap, const char *format ) {
 
 /// \ingroup waUtility 
 /// \fn void file_logger( const string &file, const char *format, ... )
-/// ׷־¼
-/// \param file ־ļ·
-/// \param format ־иʽ
-/// \param ... ־ݲб
+/// 追加日志记录
+/// \param file 日志文件路径
+/// \param format 日志行格式
+/// \param ... 日志数据参数列表
 void file_logger( const string &file, const char *format, ... ) {
 	if ( file == "" ) return;
 	
@@ -279,10 +279,10 @@ void file_logger( const string &file, const char *format, ... ) {
 
 /// \ingroup waUtility 
 /// \fn void file_logger( FILE *fp, const char *format, ... )
-/// ׷־¼
-/// \param fp ־ļstdout/stderr
-/// \param format ־иʽ
-/// \param ... ־ݲб
+/// 追加日志记录
+/// \param fp 日志文件句柄，或者stdout/stderr
+/// \param format 日志行格式
+/// \param ... 日志数据参数列表
 void file_logger( FILE *fp, const char *format, ... ) {
 	if ( fp == NULL ) return;
 	
@@ -294,9 +294,9 @@ void file_logger( FILE *fp, const char *format, ... ) {
 
 /// \ingroup waUtility 
 /// \fn string system_command( const string &cmd )
-/// ִ
-/// \param cmd ַв
-/// \return ִ
+/// 执行命令并返回命令输出结果
+/// \param cmd 命令字符串，包括命令行参数
+/// \return 命令执行输出结果
 string system_command( const string &cmd ) {
 	string res;
 	if ( cmd == "" ) return res;
@@ -314,9 +314,9 @@ string system_command( const string &cmd ) {
 
 /// \ingroup waUtility 
 /// \fn string host_addr( const string &interface )
-/// ָ豸󶨵IPַ
-/// \param interface 豸ĬΪ"eth0"
-/// \return ָ豸󶨵IPַ
+/// 返回指定网卡设备绑定的IP地址
+/// \param interface 网卡设备名，默认为"eth0"
+/// \return 指定网卡设备绑定的IP地址
 string host_addr( const string &interface ) {
 	int fd;
 	if ( (fd=socket(AF_INET,SOCK_DGRAM,0)) < 0 )
@@ -336,7 +336,7 @@ string host_addr( const string &interface ) {
 	}
 	
 	static char buf[256] = {0};
-	if( inet_ntop(AF_INET,(void *)&sin->sin_addr,buf,sizeof(buf)-1) < 0 ) {
+	if( inet_ntop(AF_INET,(void *)&sin->sin_addr,buf,sizeof(buf)-1) == NULL ) {
 		close( fd );
 		return string("");
 	}
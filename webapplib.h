@@ -1,24 +1,29 @@
 /** \mainpage Web Application Library
  *
- * WebAppLibһϵҪUnixϵͳWEBC++⡣ Ŀͨṩʹü򵥷㡢ԶC++ͺCGI򿪷еĳ߿ЧʣϵͳάĽѶȣеϹģWEBϵͳ<br><br>
+ * WebAppLib是一系列主要用于类Unix操作系统环境下WEB开发的C++类库。 设计目的是通过提供使用简单方便、相对独立的C++类和函数来简化CGI程序开发过程中的常见操作，提高开发效率，降低系统维护与改进的难度，适用于中等以上规模WEB系统开发<br><br>
  *
- * WebAppLibеࡢwebappռڣ²ɣ<br>
- * <b>String</b> : ̳вstd::stringַ࣬˿гõַ<br>
- * <b>Cgi</b> : ֧ļϴCGIȡࣻ<br>
- * <b>Cookie</b> : HTTP Cookieȡࣻ<br>
- * <b>MysqlClient</b> : MySQLݿ࣬MySQLӴCӿڵC++װ<br>
- * <b>MysqlData</b> : MySQLѯݼ࣬MySQLѯȡCӿڵC++װ<br>
- * <b>Template</b> : ֧ģǶתѭű HTML ģࣻ<br>
- * <b>HttpClient</b> : HTTP/1.1ͨЭͻࣻ<br>
- * <b>DateTime</b> : ʱ㡢ʽࣻ<br>
- * <b>TextFile</b> : ̶ָıļȡࣻ<br>
- * <b>ConfigFile</b> : INIʽļࣻ<br>
- * <b>FileSystem</b> : ļϵͳ⣻<br>
- * <b>Encode</b> : ַ뺯⣻<br>
- * <b>Utility</b> : ϵͳ빤ߺ<br>
- * ϸʹ˵ɲμοֲ help.chm<br>
+ * WebAppLib所有的类、函数、变量都声明于webapp命名空间内，由以下部分组成：<br>
+ * <b>String</b> : 继承并兼容与std::string的字符串类，增加了开发中常用的字符串处理函数；<br>
+ * <b>Cgi</b> : 支持文件上传的CGI参数读取类；<br>
+ * <b>Cookie</b> : HTTP Cookie设置与读取类；<br>
+ * <b>Response</b> : HTTP回应输出缓冲类；<br>
+ * <b>FastCgi</b> : FastCGI常驻进程模式请求处理类；<br>
+ * <b>HttpServer</b> : 基于epoll的内嵌HTTP/1.1服务器类；<br>
+ * <b>Prefork</b> : 多进程预派生工作进程管理类；<br>
+ * <b>MysqlClient</b> : MySQL数据库连接类，MySQL连接处理C函数接口的C++封装；<br>
+ * <b>MysqlData</b> : MySQL查询结果数据集类，MySQL查询结果数据提取C函数接口的C++封装；<br>
+ * <b>Template</b> : 支持在模板中嵌入条件跳转、循环输出脚本的 HTML 模板类；<br>
+ * <b>HttpClient</b> : HTTP/1.1通信协议客户端类；<br>
+ * <b>HttpMulti</b> : 基于epoll的HTTP请求并发执行类；<br>
+ * <b>DateTime</b> : 日期时间运算、格式化输出类；<br>
+ * <b>TextFile</b> : 固定分隔符文本文件读取解析类；<br>
+ * <b>ConfigFile</b> : INI格式配置文件解析类；<br>
+ * <b>FileSystem</b> : 文件系统操作函数库；<br>
+ * <b>Encode</b> : 字符串编码解码及 HTML/URL/JavaScript 输出转义函数库；<br>
+ * <b>Utility</b> : 系统调用与工具函数库<br>
+ * 类库详细使用说明可参见类库参考手册 help.chm<br>
  *
- * 뱾Ҫʹg++汾v3.4.0Ŀǰֵ֧ĲϵͳLinux(CentOS v4.0ϰ汾)Solaris(v10ϰ汾)ͨCygwinWindowsϵͳ<br>
+ * 编译本类库要求使用g++编译器，版本不低于v3.4.0，目前支持的操作系统有Linux(CentOS v4.0以上版本)，Solaris(v10以上版本)，还可以通过Cygwin环境运行于Windows操作系统<br>
  *
  * <center>
  * <a href="readme.html">Readme</a><br>
@@ -26,13 +31,14 @@
  */
 
 /// \file webapplib.h
-/// ͷļ
+/// 开发库头文件集合
 
 #ifndef _WEBAPPLIB_H_
 #define _WEBAPPLIB_H_ 
 
 #include "waString.h"
 #include "waCgi.h"
+#include "waResponse.h"
 #include "waDateTime.h"
 #include "waTemplate.h"
 #include "waHttpClient.h"
@@ -41,8 +47,16 @@
 #include "waUtility.h"
 #include "waTextFile.h"
 #include "waConfigFile.h"
+#include "waFastCgi.h"
+#include "waPrefork.h"
 
-// ʱʹ -D_WEBAPPLIB_NOMYSQL 򲻰 MysqlCleint ģ
+// HttpServer 及 HttpMulti 模块只支持 Linux 系统
+#ifdef __linux__
+#include "waHttpServer.h"
+#include "waHttpMulti.h"
+#endif
+
+// 编译时使用 -D_WEBAPPLIB_NOMYSQL 参数则不包含 MysqlCleint 模块
 #ifndef _WEBAPPLIB_NOMYSQL
 #include "waMysqlClient.h"
 #endif